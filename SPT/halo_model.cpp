@@ -0,0 +1,203 @@
+//
+// Created by David Seery on 10/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#include "halo_model.h"
+
+#include "time_functions.h"
+#include "one_loop_kernels.h"
+
+#include "lib/detail/special_functions.h"
+
+
+namespace SPT
+  {
+
+    halo_bias::halo_bias(symbol_factory& sf)
+      : b1_1(sf.make_symbol("b1_1")),
+        b1_2(sf.make_symbol("b1_2")),
+        b1_3(sf.make_symbol("b1_3")),
+        b2_2(sf.make_symbol("b2_2")),
+        b2_3(sf.make_symbol("b2_3")),
+        bG2_2(sf.make_symbol("bG2_2")),
+        bG2_3(sf.make_symbol("bG2_3")),
+        b3(sf.make_symbol("b3")),
+        bG3(sf.make_symbol("bG3")),
+        bdG2(sf.make_symbol("bdG2")),
+        bGamma3(sf.make_symbol("bGamma3"))
+      {
+        for(const auto& b : this->get_symbols())
+          {
+            sf.declare_coefficient(b);
+          }
+      }
+
+
+    GiNaC_symbol_set halo_bias::get_symbols() const
+      {
+        return GiNaC_symbol_set{this->b1_1, this->b1_2, this->b1_3, this->b2_2, this->b2_3, this->b3,
+                                this->bG2_2, this->bG2_3, this->bdG2, this->bG3, this->bGamma3};
+      }
+
+
+    fourier_kernel<3> dark_matter_overdensity(const initial_value& q_iv, const initial_value& s_iv,
+                                              const initial_value& t_iv, service_locator& loc)
+      {
+        const auto& z = loc.get_symbol_factory().get_z();
+
+        auto delta = loc.make_fourier_kernel<3>();
+
+        // linear set is delta*_q; quadratic set is delta*_q delta*_s; cubic set is delta*_q delta*_s delta*_t
+        initial_value_set iv_q{q_iv};
+        initial_value_set iv_qs{q_iv, s_iv};
+        initial_value_set iv_qst{q_iv, s_iv, t_iv};
+
+        // extract momentum vectors from these initial value placeholders
+        vector q = q_iv;
+        vector s = s_iv;
+        vector t = t_iv;
+
+        // linear order
+        delta.add(SPT::D(z), iv_q, 1);
+
+        // second order
+        // we don't symmetrize explicitly; kernels are symmetrized automatically
+        // if this feature is not disabled
+        kernel qs_base{iv_qs, loc};
+        delta.add(SPT::DA(z) * alpha(q, s, qs_base, loc));
+        delta.add(SPT::DB(z) * gamma(q, s, qs_base, loc));
+
+        // third order
+        kernel qst_base{iv_qst, loc};
+        delta.add((SPT::DD(z) - SPT::DJ(z)) * 2*gamma_bar(s+t, q, alpha_bar(s, t, qst_base, loc), loc));
+        delta.add(SPT::DE(z)                * 2*gamma_bar(s+t, q, gamma_bar(s, t, qst_base, loc), loc));
+        delta.add((SPT::DF(z) + SPT::DJ(z)) * 2*alpha_bar(s+t, q, alpha_bar(s, t, qst_base, loc), loc));
+        delta.add(SPT::DG(z)                * 2*alpha_bar(s+t, q, gamma_bar(s, t, qst_base, loc), loc));
+        delta.add(SPT::DJ(z)                * (alpha(s+t, q, gamma_bar(s, t, qst_base, loc), loc)
+                                               - 2*alpha(s+t, q, alpha_bar(s, t, qst_base, loc), loc)));
+
+        return delta;
+      }
+
+
+    fourier_kernel<3> velocity_potential(const fourier_kernel<3>& delta)
+      {
+        auto delta_1 = delta.extract_order(1);
+        auto delta_2 = delta.extract_order(2);
+        auto delta_3 = delta.extract_order(3);
+
+        // compute kernels for the dark matter velocity potential \phi, v = grad phi -> v(k) = i k phi
+        auto phi1 = InverseLaplacian(-diff_t(delta_1));
+        auto phi2 = InverseLaplacian(-diff_t(delta_2) - delta_1*Laplacian(phi1) - gradgrad(phi1, delta_1));
+        auto phi3 = InverseLaplacian(-diff_t(delta_3)
+                                     - delta_1*Laplacian(phi2) - delta_2*Laplacian(phi1)
+                                     - gradgrad(phi1, delta_2) - gradgrad(phi2, delta_1));
+
+        return phi1 + phi2 + phi3;
+      }
+
+
+    fourier_kernel<3> halo_overdensity(const fourier_kernel<3>& delta, const fourier_kernel<3>& phi, const halo_bias& b,
+                                       service_locator& loc)
+      {
+        const auto& z = loc.get_symbol_factory().get_z();
+
+        // H is the Hubble rate, f is linear growth factor
+        GiNaC::ex H = FRW::Hub(z);
+        GiNaC::ex f = SPT::f(z);
+
+        // extract different orders of \delta and \delta^2
+        auto delta_1 = delta.extract_order(1);
+        auto delta_2 = delta.extract_order(2);
+        auto delta_3 = delta.extract_order(3);
+
+        auto deltasq = delta*delta;
+        auto deltasq_2 = deltasq.extract_order(2);
+        auto deltasq_3 = deltasq.extract_order(3);
+
+        // first, need velocity potentials for the Galileon terms
+        auto Phi_delta = InverseLaplacian(delta);
+        auto Phi_v = -phi/(f*H);
+
+        auto G2 = Galileon2(Phi_delta);
+        auto G2_2 = G2.extract_order(2);
+        auto G2_3 = G2.extract_order(3);
+
+        auto G3 = Galileon3(Phi_delta);
+        auto Gamma3 = (Galileon2(Phi_delta) - Galileon2(Phi_v)).extract_order(3);
+
+        // velocity potentials for the advective terms
+        auto vp1 = phi.extract_order(1) / (H*f);
+        auto vp2 = phi.extract_order(2) / (H*f);
+
+        auto deltah_b1 = b.b1_1*delta_1 + b.b1_2*delta_2 + b.b1_3*delta_3;
+
+        auto deltah_b1_adv = - (b.b1_1 - b.b1_2) * gradgrad(vp1, delta_1)
+                             - (b.b1_2 - b.b1_3) * gradgrad(vp1, delta_2)
+                             - (b.b1_1 - b.b1_3) * gradgrad(vp2, delta_1) / 2
+                             + ((b.b1_1 + b.b1_3) / 2 - b.b1_2) * convective_bias_term(vp1, delta_1);
+
+        auto deltah_b2 = (b.b2_2/2)*deltasq_2 + (b.b2_3/2)*deltasq_3;
+
+        auto deltah_b2_adv = - (b.b2_2/2-b.b2_3/2) * gradgrad(vp1, deltasq_2);
+
+        auto deltah_G2 = b.bG2_2*G2_2 + b.bG2_3*G2_3;
+
+        auto deltah_G2_adv = - (b.bG2_2 - b.bG2_3) * gradgrad(vp1, G2_2);
+
+        auto deltah_cubic = (b.b3/6)*delta*delta*delta + b.bdG2*G2*delta + b.bG3*G3 + b.bGamma3*Gamma3;
+
+        return deltah_b1 + deltah_b1_adv + deltah_b2 + deltah_b2_adv + deltah_G2 + deltah_G2_adv + deltah_cubic;
+      }
+
+
+    fourier_kernel<3> redshift_space_overdensity(const fourier_kernel<3>& d, const fourier_kernel<3>& r_dot_v,
+                                                 const GiNaC::ex& kmu, service_locator& loc)
+      {
+        const auto& z = loc.get_symbol_factory().get_z();
+        GiNaC::ex H = FRW::Hub(z);
+
+        return d
+               - (GiNaC::I / H) * kmu * r_dot_v
+               - (GiNaC::I / H) * kmu * (r_dot_v * d)
+               - (GiNaC::numeric{1} / (2*H*H)) * kmu*kmu * (r_dot_v * r_dot_v)
+               - (GiNaC::numeric{1} / (2*H*H)) * kmu*kmu * (r_dot_v * r_dot_v * d)
+               + (GiNaC::I / (3*2*H*H*H)) * kmu*kmu*kmu * (r_dot_v * r_dot_v * r_dot_v);
+      }
+
+
+    void simplify_line_of_sight(Pk_one_loop& Pk, const GiNaC::symbol& k, const GiNaC::symbol& r_sym,
+                                const GiNaC::symbol& mu)
+      {
+        // simplify mu-dependence
+        Pk.canonicalize_external_momenta();
+        Pk.simplify(GiNaC::exmap{ {Angular::Cos(k, r_sym), mu} });
+
+        // remove unwanted r factors, which are equal to unity (r is a unit vector)
+        Pk.simplify(GiNaC::exmap{ {r_sym, GiNaC::ex{1}} });
+      }
+
+  }   // namespace SPT
@@ -0,0 +1,121 @@
+//
+// Created by David Seery on 10/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#ifndef LSSEFT_ANALYTIC_HALO_MODEL_H
+#define LSSEFT_ANALYTIC_HALO_MODEL_H
+
+
+#include "lib/vector.h"
+#include "lib/initial_value.h"
+#include "lib/fourier_kernel.h"
+#include "lib/Pk_one_loop.h"
+
+#include "services/service_locator.h"
+
+#include "utilities/GiNaC_utils.h"
+
+
+// construction of the one-loop halo model in redshift space, shared by LSSEFT_analytic and LSSEFT_bench
+
+namespace SPT
+  {
+
+    //! halo_bias holds the bias coefficients of the halo overdensity, to third order
+    class halo_bias
+      {
+
+        // CONSTRUCTOR, DESTRUCTOR
+
+      public:
+
+        //! constructor creates the bias symbols and declares them as coefficients, so they are carried
+        //! separately from the momentum kernels
+        explicit halo_bias(symbol_factory& sf);
+
+        //! destructor is default
+        ~halo_bias() = default;
+
+
+        // INTERFACE
+
+      public:
+
+        //! get set of all bias symbols
+        GiNaC_symbol_set get_symbols() const;
+
+
+        // BIAS COEFFICIENTS
+
+      public:
+
+        //! linear bias
+        const GiNaC::symbol b1_1;
+        const GiNaC::symbol b1_2;
+        const GiNaC::symbol b1_3;
+
+        //! quadratic bias
+        const GiNaC::symbol b2_2;
+        const GiNaC::symbol b2_3;
+
+        //! tidal bias
+        const GiNaC::symbol bG2_2;
+        const GiNaC::symbol bG2_3;
+
+        //! cubic bias
+        const GiNaC::symbol b3;
+        const GiNaC::symbol bG3;
+        const GiNaC::symbol bdG2;
+        const GiNaC::symbol bGamma3;
+
+      };
+
+
+    //! build the dark matter overdensity to third order, from the stochastic initial values q, s, t
+    fourier_kernel<3> dark_matter_overdensity(const initial_value& q, const initial_value& s, const initial_value& t,
+                                              service_locator& loc);
+
+    //! build the dark matter velocity potential phi, v = grad phi, from the dark matter overdensity
+    fourier_kernel<3> velocity_potential(const fourier_kernel<3>& delta);
+
+    //! build the halo overdensity, including advective terms, from the dark matter overdensity and velocity potential
+    fourier_kernel<3> halo_overdensity(const fourier_kernel<3>& delta, const fourier_kernel<3>& phi, const halo_bias& b,
+                                       service_locator& loc);
+
+    //! transform an overdensity to redshift space; kmu is the line-of-sight component of its momentum,
+    //! and r_dot_v = r.grad phi is the line-of-sight velocity
+    fourier_kernel<3> redshift_space_overdensity(const fourier_kernel<3>& d, const fourier_kernel<3>& r_dot_v,
+                                                 const GiNaC::ex& kmu, service_locator& loc);
+
+    //! simplify the mu-dependence of a redshift-space power spectrum, and remove factors of the
+    //! unit line-of-sight vector r
+    void simplify_line_of_sight(Pk_one_loop& Pk, const GiNaC::symbol& k, const GiNaC::symbol& r_sym,
+                                const GiNaC::symbol& mu);
+
+  }   // namespace SPT
+
+
+#endif //LSSEFT_ANALYTIC_HALO_MODEL_H
@@ -28,6 +28,12 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <iomanip>
+#include <set>
+#include <cstdint>
 
 #include "boost/date_time/posix_time/posix_time.hpp"
 #include "boost/filesystem/operations.hpp"
@@ -35,6 +41,8 @@
 #include "LSSEFT.h"
 
 #include "utilities/GiNaC_utils.h"
+#include "utilities/stable_hash.h"
+#include "instruments/profiler.h"
 
 #include "shared/exceptions.h"
 #include "localizations/messages.h"
@@ -52,35 +60,119 @@ namespace LSSEFT_impl
         external_momenta(std::move(em_)),
         dim(dm_)
       {
+        // coalesce measure and integrand, then expand to get in a canonical form
+        this->normalized = (this->measure * this->integrand).expand();
+
+        // divide out the numerical factor of the term selected by content, so that kernels differing only
+        // by a numerical factor share the same normalized form, independently of GiNaC's ordering of terms
+        this->scale = canonical_numeric_factor(this->normalized);
+
+        if(this->scale.is_zero()) this->scale = 1;
+        if(!this->scale.is_equal(GiNaC::ex{1})) this->normalized = (this->normalized / this->scale).expand();
       }
 
 
-    bool LSSEFT_kernel::is_equal(const LSSEFT_kernel& obj) const
+    LSSEFT_kernel LSSEFT_kernel::normalize() const
+      {
+        return LSSEFT_kernel{this->normalized, GiNaC::ex{1}, this->WickProduct, this->variables,
+                             this->external_momenta, this->dim};
+      }
+
+
+    bool LSSEFT_kernel::is_integration_compatible(const LSSEFT_kernel& obj) const
       {
-        // coalesce measure and integrand, then test for equality
-        auto combined_a = (this->measure * this->integrand).expand();
-        auto combined_b = (obj.measure * obj.integrand).expand();
+        // kernels can share an integrand if they are integrated over the same variables, have the same
+        // mass dimension, and carry the same Wick product; the measure is absorbed into each component
+        if(this->dim != obj.dim) return false;
+        if(this->variables != obj.variables) return false;
+        if(this->external_momenta != obj.external_momenta) return false;
+
+        return this->WickProduct.is_equal(obj.WickProduct);
+      }
+
+
+    std::vector< std::pair<GiNaC::ex, LSSEFT_kernel> > LSSEFT_kernel::decompose() const
+      {
+        std::vector< std::pair<GiNaC::ex, LSSEFT_kernel> > terms;
+
+        auto combined = (this->integrand * this->measure).expand();
+        if(combined.is_zero()) return terms;
+
+        // accumulate numerical coefficients of each distinct monomial
+        std::map<GiNaC::ex, GiNaC::ex, GiNaC::ex_is_less> monomials;
+
+        auto add_term = [&](const GiNaC::ex& term) -> void
+          {
+            GiNaC::ex coeff{1};
+            GiNaC::ex mono{1};
+
+            if(GiNaC::is_a<GiNaC::mul>(term))
+              {
+                for(const auto& factor : term)
+                  {
+                    if(GiNaC::is_a<GiNaC::numeric>(factor)) coeff *= factor;
+                    else                                    mono *= factor;
+                  }
+              }
+            else if(GiNaC::is_a<GiNaC::numeric>(term))
+              {
+                coeff = term;
+              }
+            else
+              {
+                mono = term;
+              }
+
+            monomials[mono] += coeff;
+          };
+
+        if(GiNaC::is_a<GiNaC::add>(combined))
+          {
+            for(const auto& term : combined)
+              {
+                add_term(term);
+              }
+          }
+        else
+          {
+            add_term(combined);
+          }
+
+        for(const auto& m : monomials)
+          {
+            if(m.second.is_zero()) continue;
 
-        if(!static_cast<bool>(combined_a == combined_b)) return false;
+            LSSEFT_kernel ker{m.first, GiNaC::ex{1}, this->WickProduct, this->variables, this->external_momenta, this->dim};
+
+            // an IR-unsafe monomial must stay together with the terms that cancel its divergence,
+            // so decline to decompose
+            if(!ker.is_IR_safe(true))
+              {
+                terms.clear();
+                terms.emplace_back(GiNaC::ex{1}, *this);
+                return terms;
+              }
+
+            terms.emplace_back(m.second, std::move(ker));
+          }
+
+        return terms;
+      }
+
+
+    bool LSSEFT_kernel::is_equal(const LSSEFT_kernel& obj) const
+      {
+        // test for equality of normalized integrands; kernels differing only by a numerical factor compare equal
+        if(!static_cast<bool>(this->normalized == obj.normalized)) return false;
 
         // test for equality of Wick product
         if(!static_cast<bool>(this->WickProduct == obj.WickProduct)) return false;
 
         // test for equality of integration variables
-        auto a_iv = order_symbol_set(this->variables);
-        auto b_iv = order_symbol_set(obj.variables);
-
-        if(!std::equal(a_iv.cbegin(), a_iv.cend(), b_iv.cbegin(), b_iv.cend(),
-                       [](const GiNaC::symbol& asym, const GiNaC::symbol& bsym) -> bool
-                         { return asym.get_name() == bsym.get_name(); })) return false;
+        if(this->variables != obj.variables) return false;
 
         // test for equality of external momenta
-        auto a_em = order_symbol_set(this->external_momenta);
-        auto b_em = order_symbol_set(obj.external_momenta);
-
-        if(!std::equal(a_em.cbegin(), a_em.cend(), b_em.cbegin(), b_em.cend(),
-                       [](const GiNaC::symbol& asym, const GiNaC::symbol& bsym) -> bool
-                         { return asym.get_name() == bsym.get_name(); })) return false;
+        if(this->external_momenta != obj.external_momenta) return false;
 
         return true;
       }
@@ -90,41 +182,55 @@ namespace LSSEFT_impl
       {
         size_t h = 0;
 
-        // coalesce measure and integrand, then expand to get in a canonical form
-        auto combined = (this->measure * this->integrand).expand();
-
-        // print to string and hash
+        // print normalized integrand to string and hash
         std::ostringstream expr_string;
-        expr_string << combined;
+        expr_string << this->normalized;
 
         hash_impl::hash_combine(h, expr_string.str());
 
-        // order integration variables lexically, convert to a string, and hash
-        auto ordered_iv = order_symbol_set(this->variables);
+        // hash integration variables and external momenta; symbol sets are ordered by identifier
+        hash_impl::hash_combine(h, this->variables);
+        hash_impl::hash_combine(h, this->external_momenta);
+
+        return h;
+      }
+
 
-        std::string iv_string;
-        std::for_each(ordered_iv.begin(), ordered_iv.end(),
-                      [&](const GiNaC::symbol& e) -> void
-                        { iv_string += e.get_name(); });
+    std::string LSSEFT_kernel::fingerprint() const
+      {
+        std::ostringstream str;
 
-        hash_impl::hash_combine(h, iv_string);
+        str << canonical_print(this->normalized) << ";" << canonical_print(this->WickProduct) << ";";
 
-        // order external momenta lexically, convert to a string, and hash
-        auto ordered_em = order_symbol_set(this->external_momenta);
+        // print names in lexical order, independently of the container ordering
+        auto print_names = [&](const GiNaC_symbol_set& syms) -> void
+          {
+            std::set<std::string> names;
+            for(const auto& s : syms)
+              {
+                names.insert(s.get_name());
+              }
+            for(const auto& n : names)
+              {
+                str << n << ",";
+              }
+            str << ";";
+          };
 
-        std::string em_string;
-        std::for_each(ordered_em.begin(), ordered_em.end(),
-                      [&](const GiNaC::symbol& e) -> void
-                        { em_string += e.get_name(); });
+        print_names(this->variables);
+        print_names(this->external_momenta);
 
-        hash_impl::hash_combine(h, em_string);
+        str << static_cast<int>(this->dim);
 
-        return h;
+        return str.str();
       }
 
 
+    // pull in stable hash function
+    using hash_impl::stable_hash;
+
+
     // forward-declare print functions
-    static std::string format_print(const GiNaC::ex& expr);
     static std::string print_operands(const GiNaC::ex& expr, const std::string& op);
 
 
@@ -303,8 +409,10 @@ namespace LSSEFT_impl
       }
 
 
-    static std::string format_print(const GiNaC::ex& expr)
+    std::string format_print(const GiNaC::ex& expr)
       {
+        PROFILE_SCOPE("format_print");
+
         std::string name;
 
         if(GiNaC::is_a<GiNaC::function>(expr)) name = GiNaC::ex_to<GiNaC::function>(expr).get_name();
@@ -345,10 +453,401 @@ namespace LSSEFT_impl
       }
 
 
-    std::string LSSEFT_kernel::print_integrand(const GiNaC::exmap& subs_map, const GiNaC::ex& normalize) const
+    //! cse_builder performs common-subexpression elimination on a group of expressions that are evaluated
+    //! together. Subexpressions that occur more than once are replaced by named temporaries, which can be
+    //! emitted as const double declarations ahead of the expressions themselves
+    class cse_builder
+      {
+
+        // TYPES
+
+      public:
+
+        //! a temporary is a symbol together with its definition
+        using temporary = std::pair<GiNaC::symbol, GiNaC::ex>;
+
+        //! list of temporaries, in order of definition
+        using temporary_list = std::vector<temporary>;
+
+      protected:
+
+        //! map from subexpression to use count
+        using count_db = std::map<GiNaC::ex, unsigned int, GiNaC::ex_is_less>;
+
+        //! map from subexpression to temporary
+        using temporary_db = std::map<GiNaC::ex, GiNaC::symbol, GiNaC::ex_is_less>;
+
+        //! map_function adapter that reduces each operand of an expression
+        class reducer : public GiNaC::map_function
+          {
+          public:
+            explicit reducer(cse_builder& b_) : b(b_) { }
+            GiNaC::ex operator()(const GiNaC::ex& e) override { return b.reduce(e); }
+          private:
+            cse_builder& b;
+          };
+
+
+        // CONSTRUCTOR, DESTRUCTOR
+
+      public:
+
+        //! constructor accepts prefix used to name temporaries
+        explicit cse_builder(std::string p_)
+          : prefix(std::move(p_))
+          {
+          }
+
+        //! destructor is default
+        ~cse_builder() = default;
+
+
+        // INTERFACE
+
+      public:
+
+        //! register an expression, counting uses of each of its subexpressions
+        void add(const GiNaC::ex& expr);
+
+        //! rewrite an expression using temporaries for repeated subexpressions;
+        //! all expressions should be registered using add() before any is reduced
+        GiNaC::ex reduce(const GiNaC::ex& expr);
+
+        //! get list of temporaries generated so far
+        const temporary_list& get_temporaries() const { return this->temps; }
+
+
+        // INTERNAL API
+
+      protected:
+
+        //! determine whether a subexpression is worth replacing with a temporary
+        static bool is_candidate(const GiNaC::ex& expr);
+
+
+        // INTERNAL DATA
+
+      private:
+
+        //! prefix for temporaries
+        const std::string prefix;
+
+        //! use counts
+        count_db counts;
+
+        //! temporaries assigned to subexpressions
+        temporary_db assigned;
+
+        //! temporaries in order of definition
+        temporary_list temps;
+
+      };
+
+
+    bool cse_builder::is_candidate(const GiNaC::ex& expr)
+      {
+        if(GiNaC::is_a<GiNaC::add>(expr) || GiNaC::is_a<GiNaC::mul>(expr) || GiNaC::is_a<GiNaC::power>(expr))
+          return true;
+
+        // special functions and power spectrum evaluations are worth keeping; time functions
+        // are already precomputed and print as a simple lookup
+        if(GiNaC::is_a<GiNaC::function>(expr))
+          {
+            const auto& name = GiNaC::ex_to<GiNaC::function>(expr).get_name();
+            return name == "Pk" || func_convert.find(name) != func_convert.end();
+          }
+
+        return false;
+      }
+
+
+    void cse_builder::add(const GiNaC::ex& expr)
+      {
+        if(is_candidate(expr))
+          {
+            // count this use; if we have seen this subexpression before then its operands
+            // have already been counted, and will be absorbed into a single temporary
+            if(this->counts[expr]++ > 0) return;
+          }
+
+        for(const auto& arg : expr)
+          {
+            this->add(arg);
+          }
+      }
+
+
+    GiNaC::ex cse_builder::reduce(const GiNaC::ex& expr)
+      {
+        auto t = this->assigned.find(expr);
+        if(t != this->assigned.end()) return t->second;
+
+        // reduce operands first, so that temporaries are defined in dependency order
+        reducer r{*this};
+        GiNaC::ex rval = expr.nops() > 0 ? expr.map(r) : expr;
+
+        auto u = this->counts.find(expr);
+        if(u == this->counts.end() || u->second < 2) return rval;
+
+        GiNaC::symbol sym{this->prefix + std::to_string(this->temps.size()) + "_"};
+        this->assigned.emplace(expr, sym);
+        this->temps.emplace_back(sym, rval);
+
+        return sym;
+      }
+
+
+    //! rewrite a sum of monomials in nested Horner form with respect to the variables vars[i], vars[i+1], ...;
+    //! the outermost nesting is in vars[i], and the coefficient of each of its powers is treated recursively
+    //! using the remaining variables. Factors that are not nonnegative integer powers of the variable
+    //! (eg. denominators) are carried in the coefficients
+    static GiNaC::ex horner_form(const GiNaC::ex& expr, const std::vector<GiNaC::symbol>& vars, size_t i = 0)
+      {
+        if(i >= vars.size()) return expr;
+
+        // products and powers may contain sums; rewrite each of their operands
+        if(GiNaC::is_a<GiNaC::power>(expr))
+          {
+            return GiNaC::pow(horner_form(expr.op(0), vars, i), expr.op(1));
+          }
+
+        if(GiNaC::is_a<GiNaC::mul>(expr))
+          {
+            GiNaC::ex rval{1};
+            for(const auto& arg : expr)
+              {
+                rval *= horner_form(arg, vars, i);
+              }
+
+            return rval;
+          }
+
+        if(!GiNaC::is_a<GiNaC::add>(expr)) return expr;
+
+        const auto& v = vars[i];
+
+        // determine the power of v carried by a single factor
+        auto power_of = [&](const GiNaC::ex& factor) -> unsigned int
+          {
+            if(factor.is_equal(v)) return 1;
+
+            if(GiNaC::is_a<GiNaC::power>(factor) && factor.op(0).is_equal(v)
+               && GiNaC::is_a<GiNaC::numeric>(factor.op(1)))
+              {
+                const auto& n = GiNaC::ex_to<GiNaC::numeric>(factor.op(1));
+                if(GiNaC::is_pos_integer(n)) return static_cast<unsigned int>(n.to_int());
+              }
+
+            return 0;
+          };
+
+        // collect coefficients of each power of v
+        std::map<unsigned int, GiNaC::ex> coeffs;
+
+        for(const auto& term : expr)
+          {
+            unsigned int n = 0;
+            GiNaC::ex c{1};
+
+            if(GiNaC::is_a<GiNaC::mul>(term))
+              {
+                for(const auto& factor : term)
+                  {
+                    auto p = power_of(factor);
+                    if(p > 0) n += p;
+                    else      c *= factor;
+                  }
+              }
+            else
+              {
+                n = power_of(term);
+                c = n > 0 ? GiNaC::ex{1} : term;
+              }
+
+            coeffs[n] += c;
+          }
+
+        // a single power of v gives nothing to nest; treat the remaining variables instead
+        if(coeffs.size() == 1 && coeffs.begin()->first == 0) return horner_form(expr, vars, i+1);
+
+        // build the nested form, starting from the highest power
+        auto t = coeffs.crbegin();
+        GiNaC::ex rval = horner_form(t->second, vars, i+1);
+        unsigned int prev = t->first;
+
+        for(++t; t != coeffs.crend(); ++t)
+          {
+            rval = rval * GiNaC::pow(v, prev - t->first) + horner_form(t->second, vars, i+1);
+            prev = t->first;
+          }
+
+        if(prev > 0) rval = rval * GiNaC::pow(v, prev);
+
+        return rval;
+      }
+
+
+    //! invariant_hoister identifies subexpressions that do not depend on the integration variables.
+    //! These take the same value at every sample point of an integration, so they can be replaced by named
+    //! temporaries that are evaluated only when the external momentum changes
+    class invariant_hoister
+      {
+
+        // TYPES
+
+      public:
+
+        //! an invariant is a symbol together with its definition
+        using invariant = std::pair<GiNaC::symbol, GiNaC::ex>;
+
+        //! list of invariants, in order of definition
+        using invariant_list = std::vector<invariant>;
+
+      protected:
+
+        //! map from subexpression to invariant
+        using invariant_db = std::map<GiNaC::ex, GiNaC::symbol, GiNaC::ex_is_less>;
+
+        //! map_function adapter that hoists invariants from each operand of an expression
+        class hoister : public GiNaC::map_function
+          {
+          public:
+            explicit hoister(invariant_hoister& h_) : h(h_) { }
+            GiNaC::ex operator()(const GiNaC::ex& e) override { return h.reduce(e); }
+          private:
+            invariant_hoister& h;
+          };
+
+
+        // CONSTRUCTOR, DESTRUCTOR
+
+      public:
+
+        //! constructor accepts list of integration variables and prefix used to name invariants
+        invariant_hoister(GiNaC_symbol_set v_, std::string p_)
+          : variables(std::move(v_)),
+            prefix(std::move(p_))
+          {
+          }
+
+        //! destructor is default
+        ~invariant_hoister() = default;
+
+
+        // INTERFACE
+
+      public:
+
+        //! rewrite an expression using invariants for subexpressions that do not depend on
+        //! the integration variables
+        GiNaC::ex reduce(const GiNaC::ex& expr);
+
+        //! get list of invariants generated so far
+        const invariant_list& get_invariants() const { return this->invs; }
+
+
+        // INTERNAL API
+
+      protected:
+
+        //! determine whether an expression is independent of the integration variables
+        bool is_invariant(const GiNaC::ex& expr) const;
+
+        //! replace an invariant expression by a named temporary, if it is worth doing so
+        GiNaC::ex hoist(const GiNaC::ex& expr);
+
+
+        // INTERNAL DATA
+
+      private:
+
+        //! integration variables
+        const GiNaC_symbol_set variables;
+
+        //! prefix for invariants
+        const std::string prefix;
+
+        //! invariants assigned to subexpressions
+        invariant_db assigned;
+
+        //! invariants in order of definition
+        invariant_list invs;
+
+      };
+
+
+    bool invariant_hoister::is_invariant(const GiNaC::ex& expr) const
+      {
+        for(const auto& v : this->variables)
+          {
+            if(expr.has(v)) return false;
+          }
+
+        return true;
+      }
+
+
+    GiNaC::ex invariant_hoister::hoist(const GiNaC::ex& expr)
+      {
+        // numbers and bare symbols are already as cheap as a temporary
+        if(GiNaC::is_a<GiNaC::numeric>(expr) || GiNaC::is_a<GiNaC::symbol>(expr)) return expr;
+
+        auto t = this->assigned.find(expr);
+        if(t != this->assigned.end()) return t->second;
+
+        GiNaC::symbol sym{this->prefix + std::to_string(this->invs.size()) + "_"};
+        this->assigned.emplace(expr, sym);
+        this->invs.emplace_back(sym, expr);
+
+        return sym;
+      }
+
+
+    GiNaC::ex invariant_hoister::reduce(const GiNaC::ex& expr)
+      {
+        if(this->is_invariant(expr)) return this->hoist(expr);
+
+        // for sums and products, gather the invariant operands into a single temporary
+        // and reduce the remainder
+        if(GiNaC::is_a<GiNaC::add>(expr) || GiNaC::is_a<GiNaC::mul>(expr))
+          {
+            bool is_add = GiNaC::is_a<GiNaC::add>(expr);
+
+            GiNaC::ex inv = is_add ? GiNaC::ex{0} : GiNaC::ex{1};
+            GiNaC::ex rval = is_add ? GiNaC::ex{0} : GiNaC::ex{1};
+
+            for(const auto& arg : expr)
+              {
+                if(this->is_invariant(arg))
+                  {
+                    if(is_add) inv += arg;
+                    else       inv *= arg;
+                  }
+                else
+                  {
+                    if(is_add) rval += this->reduce(arg);
+                    else       rval *= this->reduce(arg);
+                  }
+              }
+
+            return is_add ? this->hoist(inv) + rval : this->hoist(inv) * rval;
+          }
+
+        hoister h{*this};
+        return expr.map(h);
+      }
+
+
+    GiNaC::ex LSSEFT_kernel::build_integrand(const GiNaC::exmap& subs_map, const GiNaC::ex& normalize) const
       {
         auto expr = (normalize*this->integrand*this->measure).subs(subs_map).expand();
-        return format_print(GiNaC::collect_common_factors(expr));
+        return GiNaC::collect_common_factors(expr);
+      }
+
+
+    std::string LSSEFT_kernel::print_integrand(const GiNaC::exmap& subs_map, const GiNaC::ex& normalize) const
+      {
+        return format_print(this->build_integrand(subs_map, normalize));
       }
 
 
@@ -373,8 +872,8 @@ namespace LSSEFT_impl
       }
 
 
-    std::string
-    LSSEFT_kernel::print_WickProduct(const GiNaC::exmap& subs_map, const GiNaC_symbol_set& external_momenta) const
+    GiNaC::ex
+    LSSEFT_kernel::build_WickProduct(const GiNaC::exmap& subs_map, const GiNaC_symbol_set& external_momenta) const
       {
         GiNaC::ex filtered{1};
 
@@ -401,11 +900,18 @@ namespace LSSEFT_impl
               }
           }
 
-        return format_print(filtered.subs(subs_map));
+        return filtered.subs(subs_map);
+      }
+
+
+    std::string
+    LSSEFT_kernel::print_WickProduct(const GiNaC::exmap& subs_map, const GiNaC_symbol_set& external_momenta) const
+      {
+        return format_print(this->build_WickProduct(subs_map, external_momenta));
       }
 
 
-    bool LSSEFT_kernel::is_IR_safe() const
+    bool LSSEFT_kernel::is_IR_safe(bool silent) const
       {
         auto total_integrand = this->integrand*this->measure;
 
@@ -428,7 +934,7 @@ namespace LSSEFT_impl
 
             if(IR_part.ldegree(sym) < 0)
               {
-                std::cout << IR_part << '\n';
+                if(!silent) std::cout << IR_part << '\n';
                 return false;
               }
           }
@@ -476,27 +982,90 @@ LSSEFT& LSSEFT::add(const Pk_rsd& P, std::string name)
   }
 
 
-LSSEFT& LSSEFT::add(const Pk_rsd_set& Ps)
-  {
-    for(const auto& item : Ps)
+LSSEFT& LSSEFT::add(const Pk_rsd_set& Ps)
+  {
+    for(const auto& item : Ps)
+      {
+        const std::string& name = item.first;
+        const Pk_rsd& Pk = item.second.get();
+        this->add(Pk, name);
+      }
+
+    return *this;
+  }
+
+
+std::string LSSEFT::make_unique_kernel_name(const LSSEFT_impl::LSSEFT_kernel& ker)
+  {
+    // kernels keep the same name between runs unless their content changes, so the downstream
+    // database can reuse tables for unchanged kernels
+    std::string base = this->kernel_root + LSSEFT_impl::stable_hash(ker.fingerprint());
+
+    // disambiguate in the (unlikely) event of a hash collision
+    std::string name = base;
+    unsigned int count = 0;
+    while(this->kernel_names.find(name) != this->kernel_names.end())
+      {
+        name = base + "_" + std::to_string(++count);
+      }
+
+    this->kernel_names.insert(name);
+    return name;
+  }
+
+
+const std::string& LSSEFT::find_or_insert_kernel(LSSEFT_impl::LSSEFT_kernel ker)
+  {
+    auto it = this->kernel_db.find(ker);
+
+    if(it != this->kernel_db.end()) return it->second;
+
+    // generate a new kernel name
+    std::string name = this->make_unique_kernel_name(ker);
+    auto res = this->kernel_db.insert(std::make_pair(std::move(ker), std::move(name)));
+    if(!res.second) throw exception(ERROR_BACKEND_KERNEL_INSERT_FAILED, exception_code::backend_error);
+
+    return res.first->second;
+  }
+
+
+std::string LSSEFT::print_kernel(const LSSEFT_impl::LSSEFT_kernel& ker) const
+  {
+    using LSSEFT_impl::format_print;
+
+    std::ostringstream str;
+
+    // kernels are stored in normalized form, so restore the numerical factor
+    if(!ker.get_scale().is_equal(GiNaC::ex{1})) str << "(" << format_print(ker.get_scale()) << ")*";
+
+    if(!this->loc.get_argument_cache().get_master_integrals())
       {
-        const std::string& name = item.first;
-        const Pk_rsd& Pk = item.second.get();
-        this->add(Pk, name);
+        str << "ker.get_" << this->kernel_db.at(ker) << "()";
+        return str.str();
       }
 
-    return *this;
-  }
+    const auto& comb = this->combination_db.at(ker);
+    if(comb.empty()) return std::string{};
 
+    str << "(";
 
-std::string LSSEFT::make_unique_kernel_name()
-  {
-    return this->kernel_root + std::to_string(this->kernel_count++);
+    unsigned int count = 0;
+    for(const auto& term : comb)
+      {
+        if(count > 0) str << " + ";
+        str << "(" << format_print(term.first) << ")*ker.get_" << term.second << "()";
+        ++count;
+      }
+
+    str << ")";
+    return str.str();
   }
 
 
 void LSSEFT::process_kernels(const Pk_rsd_group& group, LSSEFT_impl::mass_dimension dim)
   {
+    bool master_integrals = this->loc.get_argument_cache().get_master_integrals();
+
     auto visitor = [&](const one_loop_element& elt) -> void
       {
         using LSSEFT_impl::LSSEFT_kernel;
@@ -504,12 +1073,28 @@ void LSSEFT::process_kernels(const Pk_rsd_group& group, LSSEFT_impl::mass_dimens
         LSSEFT_kernel ker{elt.get_integrand(), elt.get_measure(), elt.get_Wick_product(),
                           elt.get_integration_variables(), elt.get_external_momenta(), dim};
 
-        auto it = this->kernel_db.find(ker);
+        // kernels are stored in normalized form; physical kernels refer to them with an explicit coefficient
+        auto norm = ker.normalize();
+
+        if(!master_integrals)
+          {
+            this->find_or_insert_kernel(std::move(norm));
+            return;
+          }
+
+        // in master-integral mode, only basis monomials are integrated; the physical kernel
+        // is recorded as a linear combination of them
+        if(this->combination_db.find(norm) != this->combination_db.end()) return;
 
-        if(it != this->kernel_db.end()) return;
+        kernel_combination comb;
+        for(auto& term : norm.decompose())
+          {
+            GiNaC::ex c = term.first * term.second.get_scale();
+            const std::string& name = this->find_or_insert_kernel(term.second.normalize());
+            comb.emplace_back(c, name);
+          }
 
-        // generate a new kernel name
-        auto res = this->kernel_db.insert(std::make_pair(std::move(ker), this->make_unique_kernel_name()));
+        auto res = this->combination_db.insert(std::make_pair(std::move(norm), std::move(comb)));
         if(!res.second) throw exception(ERROR_BACKEND_KERNEL_INSERT_FAILED, exception_code::backend_error);
       };
 
@@ -595,6 +1180,63 @@ void LSSEFT::write() const
 
     //! write multiple make-index statements
     this->write_multipole_makeidx_stmts();
+
+
+    // all output has now been rendered; write it to disk
+    this->flush_output();
+  }
+
+
+std::vector<std::string> LSSEFT::render_batch(size_t count, const std::function<std::string(size_t)>& f) const
+  {
+    std::vector<std::string> results(count);
+
+    if(!this->loc.get_argument_cache().get_parallel_backend())
+      {
+        for(size_t n = 0; n < count; ++n)
+          {
+            results[n] = f(n);
+          }
+        return results;
+      }
+
+    // workers return their results as plain strings, so no symbolic state needs to be merged
+    this->loc.get_process_pool().run(count,
+      [&](size_t begin, size_t end, checkpoint& out) -> void
+        {
+          for(size_t n = begin; n < end; ++n)
+            {
+              out.set_string(std::to_string(n), f(n));
+            }
+        },
+      [&](size_t begin, size_t end, checkpoint& in) -> void
+        {
+          for(size_t n = begin; n < end; ++n)
+            {
+              results[n] = in.get_string(std::to_string(n));
+            }
+        });
+
+    return results;
+  }
+
+
+void LSSEFT::queue_output(const boost::filesystem::path& path, const std::ostringstream& buf) const
+  {
+    this->pending_output.emplace_back(path, buf.str());
+  }
+
+
+void LSSEFT::flush_output() const
+  {
+    for(const auto& item : this->pending_output)
+      {
+        std::ofstream outf{item.first.string(), std::ios_base::out | std::ios_base::trunc};
+        outf << item.second;
+        outf.close();
+      }
+
+    this->pending_output.clear();
   }
 
 
@@ -611,7 +1253,7 @@ void LSSEFT::write_pipeline_id() const
   {
     auto output = this->make_output_path("pipeline_id.cpp");
 
-    std::ofstream outf{output.string(), std::ios_base::out | std::ios_base::trunc};
+    std::ostringstream outf;
     this->write_header(outf);
 
     outf << "std::string pipeline_id()" << '\n'
@@ -619,7 +1261,7 @@ void LSSEFT::write_pipeline_id() const
          << "   return \"" << this->now_string << "\";" << '\n'
          << " }" << '\n';
 
-    outf.close();
+    this->queue_output(output, outf);
   }
 
 
@@ -627,10 +1269,10 @@ void LSSEFT::write_create() const
   {
     auto output = this->make_output_path("create_stmts.cpp");
 
-    std::ofstream outf{output.string(), std::ios_base::out | std::ios_base::trunc};
+    std::ostringstream outf;
     this->write_header(outf);
 
-    for(const auto& record : this->kernel_db)
+    for(const kernel_db_type::value_type& record : this->ordered_kernels())
       {
         const std::string& name = record.second;
 
@@ -658,7 +1300,7 @@ void LSSEFT::write_create() const
         outf << '\n';
       }
 
-    outf.close();
+    this->queue_output(output, outf);
   }
 
 
@@ -666,11 +1308,160 @@ void LSSEFT::write_kernel_integrands() const
   {
     using LSSEFT_impl::LSSEFT_kernel;
 
+    auto& ac = this->loc.get_argument_cache();
+
+    // check kernels for IR safety in all variables; in master-integral mode the basis monomials need
+    // not be individually IR safe, so the physical kernels are checked instead
+    std::vector<const LSSEFT_kernel*> candidates;
+    if(ac.get_master_integrals())
+      {
+        for(const auto& record : this->combination_db)
+          {
+            candidates.push_back(&record.first);
+          }
+      }
+    else
+      {
+        for(const kernel_db_type::value_type& record : this->ordered_kernels())
+          {
+            candidates.push_back(&record.first);
+          }
+      }
+
+    // the checks require series expansions, so with the parallel backend they are divided between worker processes
+    auto IR_safe = this->render_batch(candidates.size(),
+                                      [&](size_t n) -> std::string { return candidates[n]->is_IR_safe() ? "1" : "0"; });
+
+    for(size_t n = 0; n < candidates.size(); ++n)
+      {
+        const LSSEFT_kernel* ker = candidates[n];
+        if(IR_safe[n] == "1") continue;
+
+        error_handler err;
+        std::ostringstream msg;
+        msg << WARNING_KERNEL_IS_NOT_IR_SAFE << " '"
+            << (ac.get_master_integrals() ? this->print_kernel(*ker) : this->kernel_db.at(*ker)) << "'";
+        err.warn(msg.str());
+      }
+
+    // kernels sharing integration variables and Wick product are written as components of a single integrand
+    auto groups = this->build_kernel_groups();
+
+    // integrands may be sharded into several translation units, so they can be compiled in parallel
+    unsigned int shards = ac.get_integrand_shards();
+    size_t budget = ac.get_integrand_shard_bytes();
+    bool sharded = shards > 1 || budget > 0;
+
+    // render each integrand into its own buffer, so they can be distributed between shards
+    auto integrands = this->render_batch(groups.size(), [&](size_t n) -> std::string
+      {
+        std::ostringstream buf;
+        this->write_kernel_integrand(buf, groups[n], sharded);
+        return buf.str();
+      });
+
     auto output = this->make_output_path("kernel_integrands.cpp");
 
-    std::ofstream outf{output.string(), std::ios_base::out | std::ios_base::trunc};
+    std::ostringstream outf;
     this->write_header(outf);
 
+    if(!sharded)
+      {
+        for(const auto& integrand : integrands)
+          {
+            outf << integrand;
+          }
+
+        this->queue_output(output, outf);
+        return;
+      }
+
+    // when sharded, kernel_integrands.cpp just declares the integrands, which are defined elsewhere
+    outf << "#include \"kernel_integrands.h\"" << '\n';
+    this->queue_output(output, outf);
+
+    // assign integrands to shards; with a byte budget, shards are filled in turn,
+    // otherwise each integrand is assigned to the smallest of the requested number of shards
+    std::vector<std::string> contents;
+    if(budget > 0)
+      {
+        contents.emplace_back();
+        for(const auto& integrand : integrands)
+          {
+            if(!contents.back().empty() && contents.back().size() + integrand.size() > budget) contents.emplace_back();
+            contents.back().append(integrand);
+          }
+      }
+    else
+      {
+        contents.resize(shards);
+        for(const auto& integrand : integrands)
+          {
+            auto t = std::min_element(contents.begin(), contents.end(),
+                                      [](const std::string& a, const std::string& b) -> bool { return a.size() < b.size(); });
+            t->append(integrand);
+          }
+      }
+
+    // write header declaring all integrands
+    auto header = this->make_output_path("kernel_integrands.h");
+
+    std::ostringstream outh;
+    this->write_header(outh);
+
+    outh << "// declarations for kernel integrands defined in kernel_integrands_0.cpp ... kernel_integrands_"
+         << contents.size()-1 << ".cpp" << '\n';
+    outh << '\n';
+
+    for(const auto& group : groups)
+      {
+        outh << this->integrand_signature(group.first) << ";" << '\n';
+      }
+
+    this->queue_output(header, outh);
+
+    // write shards; each is a separate translation unit, and expects the downstream build to supply
+    // kernel_integrands_prelude.h declaring Cuba, integrand_data and the unit system
+    for(size_t i = 0; i < contents.size(); ++i)
+      {
+        auto shard = this->make_output_path("kernel_integrands_" + std::to_string(i) + ".cpp");
+
+        std::ostringstream outs;
+        this->write_header(outs);
+
+        outs << "#include \"kernel_integrands_prelude.h\"" << '\n';
+        outs << '\n';
+        outs << "namespace oneloop_momentum_impl" << '\n';
+        outs << " {" << '\n';
+        outs << '\n';
+        outs << "#include \"kernel_integrands.h\"" << '\n';
+        outs << '\n';
+        outs << contents[i];
+        outs << " }   // namespace oneloop_momentum_impl" << '\n';
+
+        this->queue_output(shard, outs);
+      }
+  }
+
+
+std::string LSSEFT::integrand_signature(const std::string& name) const
+  {
+    std::string sig = "int " + name + "_integrand(const int* ndim_, const cubareal x_[], const int* ncomp_, cubareal f_[], void* userdata_";
+    if(this->loc.get_argument_cache().get_nvec() > 1) sig.append(", const int* nvec_");
+    sig.append(")");
+
+    return sig;
+  }
+
+
+void LSSEFT::write_kernel_integrand(std::ostream& outf, const kernel_group_list::value_type& group, bool external_linkage) const
+  {
+    using LSSEFT_impl::LSSEFT_kernel;
+    using LSSEFT_impl::cse_builder;
+    using LSSEFT_impl::invariant_hoister;
+    using LSSEFT_impl::horner_form;
+    using LSSEFT_impl::format_print;
+
     auto& sf = this->loc.get_symbol_factory();
     auto& ac = this->loc.get_argument_cache();
 
@@ -681,72 +1472,207 @@ void LSSEFT::write_kernel_integrands() const
     auto z_ = sf.make_symbol("z_");
     auto k_ = sf.make_symbol("k_");
 
-    for(const auto& record : this->kernel_db)
+    // number of sample points evaluated per call; 1 means scalar integrands
+    unsigned int nvec = ac.get_nvec();
+
+    const std::string& name = group.first;
+    const auto& members = group.second;
+
+    // integration variables, external momenta and Wick product are shared by all members
+    const LSSEFT_kernel& lead = members.front().get().first;
+
+    const auto& integration_vars = lead.get_integration_variables();
+    const auto& external_momenta = lead.get_external_momenta();
+    const auto k = order_symbol_set(external_momenta).front();
+
+    GiNaC::exmap subs_map = { {q0, q_}, {x, z_}, {k, k_} };
+
+    bool has_x_integral = integration_vars.find(x) != integration_vars.end();
+
+    std::vector<GiNaC::ex> values;
+    values.reserve(members.size());
+    for(const auto& member : members)
       {
-        const LSSEFT_kernel& kernel = record.first;
-        const std::string& name = record.second;
+        values.push_back(member.get().first.build_integrand(subs_map, 8*GiNaC::Pi*GiNaC::Pi));
+      }
 
-        // check kernel integrand for IR safety in all variables
-        if(!kernel.is_IR_safe())
+    auto Wick = lead.build_WickProduct(subs_map, external_momenta);
+
+    // optionally rewrite the integrands in nested Horner form, z_ outermost and then q_
+    if(ac.get_horner())
+      {
+        std::vector<GiNaC::symbol> horner_vars;
+        if(has_x_integral) horner_vars.push_back(z_);
+        horner_vars.push_back(q_);
+
+        for(auto& value : values)
           {
-            error_handler err;
-            std::ostringstream msg;
-            msg << WARNING_KERNEL_IS_NOT_IR_SAFE << " '" << name << "'";
-            err.warn(msg.str());
+            value = horner_form(value, horner_vars);
           }
+      }
 
-        const auto& integration_vars = kernel.get_integration_variables();
-        const auto& external_momenta = kernel.get_external_momenta();
-        const auto& k = *external_momenta.begin();
+    // factors depending only on k_ are constant throughout the integration, so hoist them out of
+    // the per-point evaluation; they are recomputed only when k_ changes
+    invariant_hoister hoist{has_x_integral ? GiNaC_symbol_set{q_, z_} : GiNaC_symbol_set{q_}, "kinv"};
 
-        GiNaC::exmap subs_map = { {q0, q_}, {x, z_}, {k, k_} };
+    for(auto& value : values)
+      {
+        value = hoist.reduce(value);
+      }
+    Wick = hoist.reduce(Wick);
 
-        // write create statements for all kernels that we require
-        outf << "static int " << name << "_integrand(const int* ndim_, const cubareal x_[], const int* ncomp_, cubareal f_[], void* userdata_)" << '\n';
-        outf << " {" << '\n';
-        outf << "   // computed using auto-symmetrize = " << ac.get_auto_symmetrize() << ", symmetrize-22 = " << ac.get_symmetrize_22() << '\n';
-        outf << "   using oneloop_momentum_impl::integrand_data;" << '\n';
-        outf << "   integrand_data* data_ = static_cast<integrand_data*>(userdata_);" << '\n';
+    // write evaluation of invariants with the given indentation
+    auto write_invariants = [&](const std::string& indent) -> void
+      {
+        const auto& invs = hoist.get_invariants();
+        if(invs.empty()) return;
+
+        outf << indent << "// factors depending only on k_ are evaluated once for each value of k_" << '\n';
+        outf << indent << "static thread_local double cached_k_ = -1.0;" << '\n';
+        for(const auto& t : invs)
+          {
+            outf << indent << "static thread_local double " << t.first.get_name() << " = 0.0;" << '\n';
+          }
+        outf << indent << "if(k_ != cached_k_)" << '\n';
+        outf << indent << "  {" << '\n';
+        outf << indent << "    cached_k_ = k_;" << '\n';
+        for(const auto& t : invs)
+          {
+            outf << indent << "    " << t.first.get_name() << " = " << format_print(t.second) << ";" << '\n';
+          }
+        outf << indent << "  }" << '\n';
         outf << '\n';
-        outf << "   double k_ = data_->k * Mpc_units::Mpc;" << '\n';
-        outf << "   double q_ = (data_->IR_cutoff + x_[0] * data_->q_range) * Mpc_units::Mpc;" << '\n';
+      };
 
-        bool has_x_integral = false;
-        if(integration_vars.find(x) != integration_vars.end())
+    // the integrands and Wick product are evaluated together, so share temporaries between them
+    cse_builder cse{"cse"};
+    if(ac.get_cse())
+      {
+        for(const auto& value : values)
           {
-            has_x_integral = true;
-            outf << "   double z_ = 2.0*x_[1] - 1.0;" << '\n';
+            cse.add(value);
           }
-        else
+        cse.add(Wick);
+
+        for(auto& value : values)
           {
-            outf << "   // no z_ integral in this kernel; measure should be jacobian_dq" << '\n';
+            value = cse.reduce(value);
+          }
+        Wick = cse.reduce(Wick);
+      }
+
+    std::string jacobian = has_x_integral ? "data_->jacobian_dqdx" : "data_->jacobian_dq";
+
+    // name the value for each component; a single kernel uses the plain name value_
+    auto value_name = [&](size_t c) -> std::string
+      {
+        return members.size() > 1 ? "value" + std::to_string(c) + "_" : std::string{"value_"};
+      };
+
+    // write evaluation of temporaries, values and Wick product with the given indentation
+    auto write_body = [&](const std::string& indent) -> void
+      {
+        for(const auto& t : cse.get_temporaries())
+          {
+            outf << indent << "const double " << t.first.get_name() << " = " << format_print(t.second) << ";" << '\n';
+          }
+        if(!cse.get_temporaries().empty()) outf << '\n';
+
+        for(size_t c = 0; c < values.size(); ++c)
+          {
+            outf << indent << "const double " << value_name(c) << " = " << format_print(values[c]) << ";" << '\n';
+          }
+        outf << indent << "const double Wick_ = " << format_print(Wick) << ";" << '\n';
+      };
+
+    // write create statements for all kernels that we require
+    outf << (external_linkage ? "" : "static ") << this->integrand_signature(name) << '\n';
+    outf << " {" << '\n';
+    outf << "   // computed using auto-symmetrize = " << ac.get_auto_symmetrize() << ", symmetrize-22 = " << ac.get_symmetrize_22() << '\n';
+    if(members.size() > 1)
+      {
+        outf << "   // components:";
+        for(size_t c = 0; c < members.size(); ++c)
+          {
+            outf << (c > 0 ? "," : "") << " " << c << " = " << members[c].get().second;
           }
+        outf << '\n';
+      }
+    outf << "   using oneloop_momentum_impl::integrand_data;" << '\n';
+    outf << "   integrand_data* data_ = static_cast<integrand_data*>(userdata_);" << '\n';
+    outf << '\n';
+
+    if(nvec > 1)
+      {
+        // batched integrand: gather the sample points supplied by Cuba into struct-of-arrays form,
+        // then evaluate the kernel at each point
+        outf << "   const int n_ = *nvec_;" << '\n';
+        outf << "   if(n_ > " << nvec << ") return -999;" << '\n';
+        outf << '\n';
+        outf << "   const double k_ = data_->k * Mpc_units::Mpc;" << '\n';
+        outf << "   const double jacobian_ = " << jacobian << " * Mpc_units::Mpc;" << '\n';
+        if(!has_x_integral) outf << "   // no z_ integral in this kernel; measure should be jacobian_dq" << '\n';
+        outf << '\n';
+
+        write_invariants("   ");
+
+        outf << "   double q_v_[" << nvec << "];" << '\n';
+        if(has_x_integral) outf << "   double z_v_[" << nvec << "];" << '\n';
+        outf << '\n';
+        outf << "   for(int i_ = 0; i_ < n_; ++i_)" << '\n';
+        outf << "     {" << '\n';
+        outf << "       q_v_[i_] = (data_->IR_cutoff + x_[i_ * (*ndim_)] * data_->q_range) * Mpc_units::Mpc;" << '\n';
+        if(has_x_integral) outf << "       z_v_[i_] = 2.0*x_[i_ * (*ndim_) + 1] - 1.0;" << '\n';
+        outf << "     }" << '\n';
+        outf << '\n';
+        outf << "   for(int i_ = 0; i_ < n_; ++i_)" << '\n';
+        outf << "     {" << '\n';
+        outf << "       const double q_ = q_v_[i_];" << '\n';
+        if(has_x_integral) outf << "       const double z_ = z_v_[i_];" << '\n';
+        outf << '\n';
 
+        write_body("       ");
+
+        for(size_t c = 0; c < values.size(); ++c)
+          {
+            outf << "       f_[i_ * (*ncomp_) + " << c << "] = jacobian_ * " << value_name(c) << " * Wick_;" << '\n';
+          }
+        outf << "     }" << '\n';
         outf << '\n';
-        outf << "   double value_ = " << kernel.print_integrand(subs_map, 8*GiNaC::Pi*GiNaC::Pi) << ";" << '\n';
-        outf << "   double Wick_ = " << kernel.print_WickProduct(subs_map, external_momenta) << ";" << '\n';
-        outf << "   f_[0] = (";
+      }
+    else
+      {
+        outf << "   double k_ = data_->k * Mpc_units::Mpc;" << '\n';
+        outf << "   double q_ = (data_->IR_cutoff + x_[0] * data_->q_range) * Mpc_units::Mpc;" << '\n';
 
         if(has_x_integral)
           {
-            outf << "data_->jacobian_dqdx";
+            outf << "   double z_ = 2.0*x_[1] - 1.0;" << '\n';
           }
         else
           {
-            outf << "data_->jacobian_dq";
+            outf << "   // no z_ integral in this kernel; measure should be jacobian_dq" << '\n';
           }
 
-        outf << " * Mpc_units::Mpc) * value_ * Wick_;" << '\n';
         outf << '\n';
-        outf << "   return 0;" << '\n';
-        outf << " }" << '\n';
+
+        write_invariants("   ");
+        write_body("   ");
+
+        for(size_t c = 0; c < values.size(); ++c)
+          {
+            outf << "   f_[" << c << "] = (" << jacobian << " * Mpc_units::Mpc) * " << value_name(c) << " * Wick_;" << '\n';
+          }
         outf << '\n';
       }
 
-    outf.close();
+    outf << "   return 0;" << '\n';
+    outf << " }" << '\n';
+    outf << '\n';
   }
 
 
+
 const std::map< LSSEFT_impl::mass_dimension, std::string > integral_type_map
   = { { LSSEFT_impl::mass_dimension::zero, "dimless_integral" },
       { LSSEFT_impl::mass_dimension::minus3, "inverse_energy3_integral" } };
@@ -764,7 +1690,7 @@ void LSSEFT::write_container_class() const
 
     auto output = this->make_output_path("kernel_class.cpp");
 
-    std::ofstream outf{output.string(), std::ios_base::out | std::ios_base::trunc};
+    std::ostringstream outf;
     this->write_header(outf);
 
     outf << "class kernels" << '\n';
@@ -780,7 +1706,7 @@ void LSSEFT::write_container_class() const
 
     // constructor argument list
     unsigned int count = 0;
-    for(const auto& record : this->kernel_db)
+    for(const kernel_db_type::value_type& record : this->ordered_kernels())
       {
         const LSSEFT_kernel& kernel = record.first;
         const std::string& name = record.second;
@@ -795,7 +1721,7 @@ void LSSEFT::write_container_class() const
 
     // constructor initializer list
     outf << "     : fail(false)";
-    for(const auto& record : this->kernel_db)
+    for(const kernel_db_type::value_type& record : this->ordered_kernels())
       {
         const LSSEFT_kernel& kernel = record.first;
         const std::string& name = record.second;
@@ -811,7 +1737,7 @@ void LSSEFT::write_container_class() const
     outf << "    //! empty constructor" << '\n';
     outf << "    kernels()" << '\n';
     outf << "     : fail(false)";
-    for(const auto& record : this->kernel_db)
+    for(const kernel_db_type::value_type& record : this->ordered_kernels())
       {
         const LSSEFT_kernel& kernel = record.first;
         const std::string& name = record.second;
@@ -838,7 +1764,7 @@ void LSSEFT::write_container_class() const
 
     // accessors
     outf << '\n';
-    for(const auto& record : this->kernel_db)
+    for(const kernel_db_type::value_type& record : this->ordered_kernels())
       {
         const LSSEFT_kernel& kernel = record.first;
         const std::string& name = record.second;
@@ -857,7 +1783,7 @@ void LSSEFT::write_container_class() const
     outf << "    bool fail;" << '\n';
 
     outf << '\n';
-    for(const auto& record : this->kernel_db)
+    for(const kernel_db_type::value_type& record : this->ordered_kernels())
       {
         const LSSEFT_kernel& kernel = record.first;
         const std::string& name = record.second;
@@ -875,7 +1801,7 @@ void LSSEFT::write_container_class() const
          << "    void serialize(Archive& ar, unsigned int version)" << '\n'
          << "     {" << '\n'
          << "       ar & fail;" << '\n';
-    for(const auto& record : this->kernel_db)
+    for(const kernel_db_type::value_type& record : this->ordered_kernels())
       {
         const LSSEFT_kernel& kernel = record.first;
         const std::string& name = record.second;
@@ -886,6 +1812,8 @@ void LSSEFT::write_container_class() const
 
     // close class brace
     outf << " };" << '\n';
+
+    this->queue_output(output, outf);
   }
 
 
@@ -896,40 +1824,138 @@ void LSSEFT::write_integrate_stmts() const
 
     auto output = this->make_output_path("integrate_stmts.cpp");
 
-    std::ofstream outf{output.string(), std::ios_base::out | std::ios_base::trunc};
+    std::ostringstream outf;
     this->write_header(outf);
 
+    // batched integrands need the vector size to be passed to Cuba
+    unsigned int nvec = this->loc.get_argument_cache().get_nvec();
+
     outf << "    kernels ker;" << '\n';
     outf << "    bool fail = false;" << '\n';
 
-    for(const auto& record : this->kernel_db)
+    auto groups = this->build_kernel_groups();
+
+    for(const auto& group : groups)
       {
-        const LSSEFT_kernel& kernel = record.first;
-        const std::string& name = record.second;
+        const std::string& name = group.first;
+        const auto& members = group.second;
 
-        mass_dimension dim = kernel.get_dimension();
+        const LSSEFT_kernel& lead = members.front().get().first;
+        mass_dimension dim = lead.get_dimension();
 
         outf << "    fail |= this->kernel_integral(model, k, UV_cutoff, IR_cutoff, Pk, &oneloop_momentum_impl::" << name
-             << "_integrand, ker.get_" << name << "(), " << integral_1322_map.at(dim) << ", \"" << name << "\");" << '\n';
+             << "_integrand, ";
+
+        if(members.size() > 1)
+          {
+            // fused integrand: each component is stored in the kernel with the corresponding name
+            outf << "{ ";
+            for(size_t c = 0; c < members.size(); ++c)
+              {
+                outf << (c > 0 ? ", " : "") << "&ker.get_" << members[c].get().second << "()";
+              }
+            outf << " }, " << integral_1322_map.at(dim) << ", { ";
+            for(size_t c = 0; c < members.size(); ++c)
+              {
+                outf << (c > 0 ? ", " : "") << "\"" << members[c].get().second << "\"";
+              }
+            outf << " }";
+          }
+        else
+          {
+            outf << "ker.get_" << name << "(), " << integral_1322_map.at(dim) << ", \"" << name << "\"";
+          }
+
+        if(nvec > 1) outf << ", " << nvec;
+        outf << ");" << '\n';
       }
 
     outf << '\n';
     outf << "    if(fail) ker.mark_failed();" << '\n';
 
-    outf.close();
+    this->queue_output(output, outf);
+  }
+
+
+LSSEFT::kernel_group_list LSSEFT::build_kernel_groups() const
+  {
+    using LSSEFT_impl::LSSEFT_kernel;
+
+    bool fuse = this->loc.get_argument_cache().get_fuse_kernels();
+
+    kernel_group_list groups;
+
+    for(const kernel_db_type::value_type& record : this->ordered_kernels())
+      {
+        const LSSEFT_kernel& kernel = record.first;
+
+        if(fuse)
+          {
+            // search for an existing group whose integrand can be evaluated alongside this kernel
+            auto t = std::find_if(groups.begin(), groups.end(), [&](const kernel_group_list::value_type& g) -> bool
+              {
+                return g.second.front().get().first.is_integration_compatible(kernel);
+              });
+
+            if(t != groups.end())
+              {
+                t->second.emplace_back(std::cref(record));
+                continue;
+              }
+          }
+
+        groups.emplace_back(record.second, kernel_group{ std::cref(record) });
+      }
+
+    // groups containing more than one kernel need their own integrand name, derived from the names of its
+    // members; a single kernel keeps its own name
+    for(auto& g : groups)
+      {
+        if(g.second.size() > 1)
+          {
+            std::string members;
+            for(const auto& member : g.second)
+              {
+                members.append(member.get().second).append(";");
+              }
+
+            g.first = this->kernel_root + "grp" + LSSEFT_impl::stable_hash(members);
+          }
+      }
+
+    return groups;
+  }
+
+
+LSSEFT::kernel_group LSSEFT::ordered_kernels() const
+  {
+    kernel_group kernels;
+    kernels.reserve(this->kernel_db.size());
+
+    for(const auto& record : this->kernel_db)
+      {
+        kernels.emplace_back(std::cref(record));
+      }
+
+    std::sort(kernels.begin(), kernels.end(),
+              [](const kernel_db_type::value_type& a, const kernel_db_type::value_type& b) -> bool
+                { return a.second < b.second; });
+
+    return kernels;
   }
 
 
+
 void LSSEFT::write_kernel_store() const
   {
     using LSSEFT_impl::LSSEFT_kernel;
 
     auto output = this->make_output_path("store_kernel_stmts.cpp");
 
-    std::ofstream outf{output.string(), std::ios_base::out | std::ios_base::trunc};
+    std::ostringstream outf;
     this->write_header(outf);
 
-    for(const auto& record : this->kernel_db)
+    for(const kernel_db_type::value_type& record : this->ordered_kernels())
       {
         const LSSEFT_kernel& kernel = record.first;
         const std::string& name = record.second;
@@ -937,7 +1963,7 @@ void LSSEFT::write_kernel_store() const
         outf << "store_impl::store_loop_kernel(db, \"" << name << "\", ker.get_" << name << "(), model, params, sample);" << '\n';
       }
 
-    outf.close();
+    this->queue_output(output, outf);
   }
 
 
@@ -947,10 +1973,10 @@ void LSSEFT::write_kernel_missing() const
 
     auto output = this->make_output_path("missing_kernel_stmts.cpp");
 
-    std::ofstream outf{output.string(), std::ios_base::out | std::ios_base::trunc};
+    std::ostringstream outf;
     this->write_header(outf);
 
-    for(const auto& record : this->kernel_db)
+    for(const kernel_db_type::value_type& record : this->ordered_kernels())
       {
         const LSSEFT_kernel& kernel = record.first;
         const std::string& name = record.second;
@@ -961,7 +1987,7 @@ void LSSEFT::write_kernel_missing() const
       }
     outf << '\n';
 
-    for(const auto& record : this->kernel_db)
+    for(const kernel_db_type::value_type& record : this->ordered_kernels())
       {
         const LSSEFT_kernel& kernel = record.first;
         const std::string& name = record.second;
@@ -969,7 +1995,7 @@ void LSSEFT::write_kernel_missing() const
         outf << "drop_inconsistent_configurations(db, model, params, Pk_lin, \"" << name << "\", " << name << ", total_missing);" << '\n';
       }
 
-    outf.close();
+    this->queue_output(output, outf);
   }
 
 
@@ -979,12 +2005,12 @@ void LSSEFT::write_kernel_find() const
 
     auto output = this->make_output_path("find_kernel_stmts.cpp");
 
-    std::ofstream outf{output.string(), std::ios_base::out | std::ios_base::trunc};
+    std::ostringstream outf;
     this->write_header(outf);
 
     outf << "kernels ker;" << '\n';
 
-    for(const auto& record : this->kernel_db)
+    for(const kernel_db_type::value_type& record : this->ordered_kernels())
       {
         const LSSEFT_kernel& kernel = record.first;
         const std::string& name = record.second;
@@ -993,7 +2019,7 @@ void LSSEFT::write_kernel_find() const
 
       }
 
-    outf.close();
+    this->queue_output(output, outf);
   }
 
 
@@ -1003,7 +2029,7 @@ void LSSEFT::write_Pk_missing() const
 
     auto output = this->make_output_path("missing_Pk_stmts.cpp");
 
-    std::ofstream outf{output.string(), std::ios_base::out | std::ios_base::trunc};
+    std::ostringstream outf;
     this->write_header(outf);
 
     for(const auto& record : this->Pk_db)
@@ -1052,7 +2078,7 @@ void LSSEFT::write_Pk_missing() const
              << "_mu8\", record, " << name << "_mu8, missing);" << '\n';
       }
 
-    outf.close();
+    this->queue_output(output, outf);
   }
 
 
@@ -1062,7 +2088,7 @@ void LSSEFT::write_Pk_compute_stmts() const
 
     auto output = this->make_output_path("compute_Pk_stmts.cpp");
 
-    std::ofstream outf{output.string(), std::ios_base::out | std::ios_base::trunc};
+    std::ostringstream outf;
     this->write_header(outf);
 
     for(const auto& record : this->Pk_db)
@@ -1082,7 +2108,7 @@ void LSSEFT::write_Pk_compute_stmts() const
         outf << '\n';
       }
 
-    outf.close();
+    this->queue_output(output, outf);
   }
 
 
@@ -1092,7 +2118,7 @@ void LSSEFT::write_Pk_store() const
 
     auto output = this->make_output_path("store_Pk_stmts.cpp");
 
-    std::ofstream outf{output.string(), std::ios_base::out | std::ios_base::trunc};
+    std::ostringstream outf;
     this->write_header(outf);
 
     for(const auto& record : this->Pk_db)
@@ -1108,7 +2134,7 @@ void LSSEFT::write_Pk_store() const
         outf << '\n';
       }
 
-    outf.close();
+    this->queue_output(output, outf);
   }
 
 
@@ -1118,7 +2144,7 @@ void LSSEFT::write_Pk_find() const
 
     auto output = this->make_output_path("find_Pk_stmts.cpp");
 
-    std::ofstream outf{output.string(), std::ios_base::out | std::ios_base::trunc};
+    std::ostringstream outf;
     this->write_header(outf);
 
     for(const auto& record : this->Pk_db)
@@ -1144,10 +2170,12 @@ void LSSEFT::write_Pk_find() const
 
         outf << '\n';
       }
+
+    this->queue_output(output, outf);
   }
 
 
-void LSSEFT::write_Pk_mu_component(std::ofstream& outf, const std::string& name, const Pk_rsd& Pk, unsigned int mu) const
+void LSSEFT::write_Pk_mu_component(std::ostream& outf, const std::string& name, const Pk_rsd& Pk, unsigned int mu) const
   {
     std::string tag = std::string{"mu"} + std::to_string(mu);
 
@@ -1190,10 +2218,13 @@ void LSSEFT::write_Pk_mu_component(std::ofstream& outf, const std::string& name,
         LSSEFT_kernel ker{elt.get_integrand(), elt.get_measure(), elt.get_Wick_product(),
                           elt.get_integration_variables(), elt.get_external_momenta(), mass_dimension::zero};
 
-        const std::string& kname = this->kernel_db.at(ker);
+        auto kexpr = this->print_kernel(ker);
+
+        // skip kernels that vanish identically
+        if(kexpr.empty()) return;
 
         if(count > 0) P13_buffer << " + ";
-        P13_buffer << "(" << format_print(elt.get_time_function()) << ")*ker.get_" << kname << "()";
+        P13_buffer << "(" << format_print(elt.get_time_function()) << ")*" << kexpr;
         ++count;
       };
     P13.visit({mu}, P13_writer);
@@ -1214,10 +2245,13 @@ void LSSEFT::write_Pk_mu_component(std::ofstream& outf, const std::string& name,
         LSSEFT_kernel ker{elt.get_integrand(), elt.get_measure(), elt.get_Wick_product(),
                           elt.get_integration_variables(), elt.get_external_momenta(), mass_dimension::minus3};
 
-        const std::string& kname = this->kernel_db.at(ker);
+        auto kexpr = this->print_kernel(ker);
+
+        // skip kernels that vanish identically
+        if(kexpr.empty()) return;
 
         if(count > 0) P22_buffer << " + ";
-        P22_buffer << "(" << format_print(elt.get_time_function()) << ")*ker.get_" << kname << "()";
+        P22_buffer << "(" << format_print(elt.get_time_function()) << ")*" << kexpr;
         ++count;
       };
     P22.visit({mu}, P22_writer);
@@ -1238,7 +2272,7 @@ void LSSEFT::write_Pk_expressions() const
 
     auto output = this->make_output_path("Pk_expressions.cpp");
 
-    std::ofstream outf{output.string(), std::ios_base::out | std::ios_base::trunc};
+    std::ostringstream outf;
     this->write_header(outf);
 
     for(const auto& record : this->Pk_db)
@@ -1253,7 +2287,7 @@ void LSSEFT::write_Pk_expressions() const
         this->write_Pk_mu_component(outf, name, Pk, 8);
       }
 
-    outf.close();
+    this->queue_output(output, outf);
   }
 
 
@@ -1263,10 +2297,10 @@ void LSSEFT::write_kernel_dropidx_stmts() const
 
     auto output = this->make_output_path("dropidx_kernel_stmts.cpp");
 
-    std::ofstream outf{output.string(), std::ios_base::out | std::ios_base::trunc};
+    std::ostringstream outf;
     this->write_header(outf);
 
-    for(const auto& record : this->kernel_db)
+    for(const kernel_db_type::value_type& record : this->ordered_kernels())
       {
         const LSSEFT_kernel& kernel = record.first;
         const std::string& name = record.second;
@@ -1274,7 +2308,7 @@ void LSSEFT::write_kernel_dropidx_stmts() const
         outf << "sqlite3_operations::drop_index(this->handle, \"" << name << "\", { \"mid\", \"params_id\", \"kid\", \"Pk_id\", \"IR_id\", \"UV_id\" });" << '\n';
       }
 
-    outf.close();
+    this->queue_output(output, outf);
   }
 
 
@@ -1284,10 +2318,10 @@ void LSSEFT::write_kernel_makeidx_stmts() const
 
     auto output = this->make_output_path("makeidx_kernel_stmts.cpp");
 
-    std::ofstream outf{output.string(), std::ios_base::out | std::ios_base::trunc};
+    std::ostringstream outf;
     this->write_header(outf);
 
-    for(const auto& record : this->kernel_db)
+    for(const kernel_db_type::value_type& record : this->ordered_kernels())
       {
         const LSSEFT_kernel& kernel = record.first;
         const std::string& name = record.second;
@@ -1295,7 +2329,7 @@ void LSSEFT::write_kernel_makeidx_stmts() const
         outf << "sqlite3_operations::create_index(this->handle, \"" << name << "\", { \"mid\", \"params_id\", \"kid\", \"Pk_id\", \"IR_id\", \"UV_id\" });" << '\n';
       }
 
-    outf.close();
+    this->queue_output(output, outf);
   }
 
 
@@ -1305,7 +2339,7 @@ void LSSEFT::write_Pk_dropidx_stmts() const
 
     auto output = this->make_output_path("dropidx_Pk_stmts.cpp");
 
-    std::ofstream outf{output.string(), std::ios_base::out | std::ios_base::trunc};
+    std::ostringstream outf;
     this->write_header(outf);
 
     for(const auto& record : this->Pk_db)
@@ -1334,7 +2368,7 @@ void LSSEFT::write_Pk_dropidx_stmts() const
              << '\n';
       }
 
-    outf.close();
+    this->queue_output(output, outf);
   }
 
 
@@ -1344,7 +2378,7 @@ void LSSEFT::write_Pk_makeidx_stmts() const
 
     auto output = this->make_output_path("makeidx_Pk_stmts.cpp");
 
-    std::ofstream outf{output.string(), std::ios_base::out | std::ios_base::trunc};
+    std::ostringstream outf;
     this->write_header(outf);
 
     for(const auto& record : this->Pk_db)
@@ -1374,7 +2408,7 @@ void LSSEFT::write_Pk_makeidx_stmts() const
         outf << '\n';
       }
 
-    outf.close();
+    this->queue_output(output, outf);
   }
 
 
@@ -1384,7 +2418,7 @@ void LSSEFT::write_multipole_missing() const
 
     auto output = this->make_output_path("missing_multipole_stmts.cpp");
 
-    std::ofstream outf{output.string(), std::ios_base::out | std::ios_base::trunc};
+    std::ostringstream outf;
     this->write_header(outf);
 
     for(const auto& record : this->Pk_db)
@@ -1419,7 +2453,7 @@ void LSSEFT::write_multipole_missing() const
              << name << "_P4\", record, " << name << "_P4, missing);" << '\n';
       }
 
-    outf.close();
+    this->queue_output(output, outf);
   }
 
 
@@ -1429,7 +2463,7 @@ void LSSEFT::write_multipole_decompose_stmts() const
 
     auto output = this->make_output_path("multipole_compute_stmts.cpp");
 
-    std::ofstream outf{output.string(), std::ios_base::out | std::ios_base::trunc};
+    std::ostringstream outf;
     this->write_header(outf);
 
     for(const auto& record : this->Pk_db)
@@ -1439,7 +2473,7 @@ void LSSEFT::write_multipole_decompose_stmts() const
         outf << "apply(\"" << name << "\");" << '\n';
       }
 
-    outf.close();
+    this->queue_output(output, outf);
   }
 
 
@@ -1449,7 +2483,7 @@ void LSSEFT::write_multipole_store() const
 
     auto output = this->make_output_path("store_multipole_stmts.cpp");
 
-    std::ofstream outf{output.string(), std::ios_base::out | std::ios_base::trunc};
+    std::ostringstream outf;
     this->write_header(outf);
 
     for(const auto& record : this->Pk_db)
@@ -1463,7 +2497,7 @@ void LSSEFT::write_multipole_store() const
         outf << '\n';
       }
 
-    outf.close();
+    this->queue_output(output, outf);
   }
 
 
@@ -1473,7 +2507,7 @@ void LSSEFT::write_multipole_dropidx_stmts() const
 
     auto output = this->make_output_path("dropidx_multipole_stmts.cpp");
 
-    std::ofstream outf{output.string(), std::ios_base::out | std::ios_base::trunc};
+    std::ostringstream outf;
     this->write_header(outf);
 
     for(const auto& record : this->Pk_db)
@@ -1494,7 +2528,7 @@ void LSSEFT::write_multipole_dropidx_stmts() const
              << '\n';
       }
 
-    outf.close();
+    this->queue_output(output, outf);
   }
 
 
@@ -1504,7 +2538,7 @@ void LSSEFT::write_multipole_makeidx_stmts() const
 
     auto output = this->make_output_path("makeidx_multipole_stmts.cpp");
 
-    std::ofstream outf{output.string(), std::ios_base::out | std::ios_base::trunc};
+    std::ostringstream outf;
     this->write_header(outf);
 
     for(const auto& record : this->Pk_db)
@@ -1525,11 +2559,11 @@ void LSSEFT::write_multipole_makeidx_stmts() const
              << '\n';
       }
 
-    outf.close();
+    this->queue_output(output, outf);
   }
 
 
-void LSSEFT::write_header(std::ofstream& outf) const
+void LSSEFT::write_header(std::ostream& outf) const
   {
     outf << "// Generated at " << this->now_string << '\n';
     outf << "//" << '\n';
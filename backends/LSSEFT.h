@@ -27,8 +27,13 @@
 #define LSSEFT_ANALYTIC_LSSEFT_H
 
 
+#include <string>
 #include <map>
+#include <set>
+#include <vector>
+#include <utility>
 #include <functional>
+#include <sstream>
 
 #include "shared/defaults.h"
 
@@ -38,15 +43,16 @@
 #include "boost/date_time/posix_time/ptime.hpp"
 
 
-using Pk_rsd_set = std::map< std::string, std::reference_wrapper<Pk_rsd> >;
-
-
 namespace LSSEFT_impl
   {
 
     enum class mass_dimension { zero, minus3 };
 
 
+    //! format a GiNaC expression as C++ source
+    std::string format_print(const GiNaC::ex& expr);
+
+
     //! holds the details of a single LSSEFT kernel
     class LSSEFT_kernel
       {
@@ -76,25 +82,52 @@ namespace LSSEFT_impl
         //! get integration variables
         const GiNaC_symbol_set& get_integration_variables() const { return this->variables; }
 
+        //! get numerical factor extracted from integrand x measure during normalization
+        const GiNaC::ex& get_scale() const { return this->scale; }
+
+        //! build a kernel representing the normalized integrand, with unit numerical scale
+        LSSEFT_kernel normalize() const;
+
 
         // SERVICES
 
       public:
 
-        //! test for IR safety
-        bool is_IR_safe() const;
+        //! test for IR safety; if not silent, the IR-divergent part is written to the console on failure
+        bool is_IR_safe(bool silent=false) const;
 
         //! test for equality
         bool is_equal(const LSSEFT_kernel& obj) const;
 
+        //! test whether another kernel can be integrated as a component of the same integrand
+        bool is_integration_compatible(const LSSEFT_kernel& obj) const;
+
+        //! decompose integrand x measure into a linear combination of monomials with exact numerical
+        //! coefficients; each monomial is returned as a kernel sharing our Wick product, integration variables,
+        //! external momenta and mass dimension.
+        //! IR divergences which cancel between monomials must not be separated, so if any monomial is
+        //! not IR safe on its own the kernel is returned undivided, with unit coefficient
+        std::vector< std::pair<GiNaC::ex, LSSEFT_kernel> > decompose() const;
+
         //! hash
         size_t hash() const;
 
+        //! build a canonical string representation of the kernel, independent of GiNaC's internal
+        //! term ordering, so that it is stable between runs
+        std::string fingerprint() const;
+
 
         // FORMATTING
 
       public:
 
+        //! build integrand constructed from 3D integrand plus any factors from the measure,
+        //! with the optional normalization described below
+        GiNaC::ex build_integrand(const GiNaC::exmap& subs_map, const GiNaC::ex& normalize = GiNaC::ex{1}) const;
+
+        //! build Wick product, omitting factors that do not participate in the integration
+        GiNaC::ex build_WickProduct(const GiNaC::exmap& subs_map, const GiNaC_symbol_set& external_momenta) const;
+
         //! print integrand constructed from 3D integrand plus any factors from the measure
         //! the optional normalization allows common factors (eg. powers of pi) to be extracted for
         //! numerical reasons, if desired
@@ -117,6 +150,13 @@ namespace LSSEFT_impl
         //! Wick product
         GiNaC::ex WickProduct;
 
+        //! integrand x measure with its numerical content divided out; kernels that differ only
+        //! by a numerical factor share the same normalized form, and are treated as equal
+        GiNaC::ex normalized;
+
+        //! numerical content of integrand x measure
+        GiNaC::ex scale{1};
+
         //! set of integration variables
         GiNaC_symbol_set variables;
 
@@ -171,6 +211,18 @@ class LSSEFT
     //! kernel database
     using kernel_db_type = std::unordered_map< LSSEFT_impl::LSSEFT_kernel, std::string >;
 
+    //! a kernel group is a list of kernel records that can be integrated as components of a single integrand
+    using kernel_group = std::vector< std::reference_wrapper<const kernel_db_type::value_type> >;
+
+    //! list of kernel groups, each labelled by the name of its integrand
+    using kernel_group_list = std::vector< std::pair<std::string, kernel_group> >;
+
+    //! linear combination of basis kernels, stored as (coefficient, basis kernel name) pairs
+    using kernel_combination = std::vector< std::pair<GiNaC::ex, std::string> >;
+
+    //! database of physical kernels expressed as linear combinations of basis kernels
+    using combination_db_type = std::unordered_map< LSSEFT_impl::LSSEFT_kernel, kernel_combination >;
+
 
     // CONSTRUCTOR, DESTRUCTOR
 
@@ -201,8 +253,15 @@ class LSSEFT
     //! process the kernels associated with an added power spectrum
     void process_kernels(const Pk_rsd_group& group, LSSEFT_impl::mass_dimension dim);
 
-    //! generate a unique kernel name
-    std::string make_unique_kernel_name();
+    //! generate a unique kernel name, derived from a stable hash of the kernel fingerprint
+    std::string make_unique_kernel_name(const LSSEFT_impl::LSSEFT_kernel& ker);
+
+    //! look up a kernel in the kernel database, inserting it if it is not present; returns its name
+    const std::string& find_or_insert_kernel(LSSEFT_impl::LSSEFT_kernel ker);
+
+    //! print the C++ expression for a physical kernel; in master-integral mode this is a linear
+    //! combination of basis kernels, which is empty if the kernel vanishes identically
+    std::string print_kernel(const LSSEFT_impl::LSSEFT_kernel& ker) const;
 
 
     // INTERNAL API
@@ -212,6 +271,23 @@ class LSSEFT
     //! construct an output file name from the cached root
     boost::filesystem::path make_output_path(const boost::filesystem::path& leaf) const;
 
+    //! evaluate f(n) for n = 0, 1, ..., count-1 and return the results in order; if the parallel backend
+    //! is enabled, evaluations are divided between the worker processes
+    std::vector<std::string> render_batch(size_t count, const std::function<std::string(size_t)>& f) const;
+
+    //! queue a rendered output file; files are written to disk by flush_output()
+    void queue_output(const boost::filesystem::path& path, const std::ostringstream& buf) const;
+
+    //! write all queued output files
+    void flush_output() const;
+
+    //! partition the kernel database into groups sharing an integrand; if kernel fusion is disabled,
+    //! each kernel forms its own group
+    kernel_group_list build_kernel_groups() const;
+
+    //! list kernel records in order of name, so that generated files are stable between runs
+    kernel_group ordered_kernels() const;
+
 
     // SQL
 
@@ -243,6 +319,13 @@ class LSSEFT
     //! write kernels
     void write_kernel_integrands() const;
 
+    //! write the integrand for a single kernel group
+    void write_kernel_integrand(std::ostream& outf, const kernel_group_list::value_type& group,
+                                bool external_linkage) const;
+
+    //! build the signature of a kernel integrand
+    std::string integrand_signature(const std::string& name) const;
+
     //! write kernel integrate statements
     void write_integrate_stmts() const;
 
@@ -280,7 +363,7 @@ class LSSEFT
 
 
     //! write expression for a single mu component of a given Ok
-    void write_Pk_mu_component(std::ofstream& outf, const std::string& name, const Pk_rsd& Pk, unsigned int mu) const;
+    void write_Pk_mu_component(std::ostream& outf, const std::string& name, const Pk_rsd& Pk, unsigned int mu) const;
 
 
     // MULTIPOLE POWER SPECTRA
@@ -308,7 +391,7 @@ class LSSEFT
   public:
 
     //! write generic header line
-    void write_header(std::ofstream& outf) const;
+    void write_header(std::ostream& outf) const;
 
 
     // INTERNAL DATA
@@ -326,8 +409,8 @@ class LSSEFT
     //! output root
     boost::filesystem::path root;
 
-    //! current kernel number
-    unsigned int kernel_count{0};
+    //! kernel names already in use
+    std::set<std::string> kernel_names;
 
     //! kernel root string
     std::string kernel_root{LSSEFT_DEFAULT_KERNEL_ROOT};
@@ -341,6 +424,15 @@ class LSSEFT
     //! kernel database
     kernel_db_type kernel_db;
 
+    //! decomposition of physical kernels into basis kernels, used in master-integral mode
+    combination_db_type combination_db;
+
+
+    // OUTPUT
+
+    //! rendered output files awaiting flush_output()
+    mutable std::vector< std::pair<boost::filesystem::path, std::string> > pending_output;
+
 
     // TIMESTAMP
 
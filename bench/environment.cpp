@@ -0,0 +1,78 @@
+//
+// Created by David Seery on 08/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#include "environment.h"
+
+
+namespace bench
+  {
+
+    namespace environment_impl
+      {
+
+        //! default arguments for argument_cache, excluding the program name
+        static std::vector<std::string>& default_arguments()
+          {
+            static std::vector<std::string> args;
+            return args;
+          }
+
+
+        //! build an argument_cache from the default arguments
+        static argument_cache make_argument_cache()
+          {
+            std::vector<std::string> args{"LSSEFT_bench"};
+            const auto& defaults = default_arguments();
+            args.insert(args.end(), defaults.begin(), defaults.end());
+
+            std::vector<char*> argv;
+            for(auto& arg : args)
+              {
+                argv.push_back(&arg[0]);
+              }
+            argv.push_back(nullptr);
+
+            char** argv_ptr = argv.data();
+            return argument_cache{static_cast<int>(args.size()), argv_ptr};
+          }
+
+      }   // namespace environment_impl
+
+
+    void set_default_arguments(std::vector<std::string> args)
+      {
+        environment_impl::default_arguments() = std::move(args);
+      }
+
+
+    environment::environment()
+      : args(environment_impl::make_argument_cache()),
+        loc(args, sf)
+      {
+      }
+
+  }   // namespace bench
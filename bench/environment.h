@@ -0,0 +1,95 @@
+//
+// Created by David Seery on 08/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#ifndef LSSEFT_ANALYTIC_BENCH_ENVIRONMENT_H
+#define LSSEFT_ANALYTIC_BENCH_ENVIRONMENT_H
+
+
+#include <string>
+#include <vector>
+
+#include "services/symbol_factory.h"
+#include "services/argument_cache.h"
+#include "services/service_locator.h"
+
+
+namespace bench
+  {
+
+    //! set the command-line options used to construct the argument_cache for each environment;
+    //! these are options for LSSEFT_analytic (eg. --threads), forwarded by LSSEFT_bench
+    void set_default_arguments(std::vector<std::string> args);
+
+
+    //! environment owns a fresh set of service objects, so that benchmarks do not share caches
+    class environment
+      {
+
+        // CONSTRUCTOR, DESTRUCTOR
+
+      public:
+
+        //! constructor builds service objects from the default arguments
+        environment();
+
+        //! destructor is default
+        ~environment() = default;
+
+        //! disable copying
+        environment(const environment& obj) = delete;
+
+
+        // INTERFACE
+
+      public:
+
+        //! get symbol factory
+        symbol_factory& get_symbol_factory() { return this->sf; }
+
+        //! get service locator
+        service_locator& get_locator() { return this->loc; }
+
+
+        // INTERNAL DATA
+
+      private:
+
+        //! symbol factory
+        symbol_factory sf;
+
+        //! argument cache
+        argument_cache args;
+
+        //! service locator
+        service_locator loc;
+
+      };
+
+  }   // namespace bench
+
+
+#endif //LSSEFT_ANALYTIC_BENCH_ENVIRONMENT_H
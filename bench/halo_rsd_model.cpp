@@ -0,0 +1,94 @@
+//
+// Created by David Seery on 08/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#include "halo_rsd_model.h"
+
+#include "lib/vector.h"
+#include "lib/initial_value.h"
+
+
+namespace bench
+  {
+
+    halo_rsd_model::halo_rsd_model(service_locator& lc_, bool f_)
+      : loc(lc_),
+        full(f_),
+        r_sym(lc_.get_symbol_factory().make_symbol("r")),
+        mu(lc_.get_symbol_factory().make_symbol("mu")),
+        k(lc_.get_symbol_factory().make_symbol("k")),
+        delta(lc_.make_fourier_kernel<3>())
+      {
+        auto& sf = this->loc.get_symbol_factory();
+
+        sf.declare_parameter(this->r_sym);
+        sf.declare_parameter(this->mu);
+        sf.declare_parameter(this->k);
+
+        if(this->full)
+          {
+            this->bias_coeffs = std::make_unique<SPT::halo_bias>(sf);
+            this->bias = this->bias_coeffs->get_symbols();
+          }
+
+        auto deltaq = sf.make_initial_value("delta");
+        auto deltas = sf.make_initial_value("delta");
+        auto deltat = sf.make_initial_value("delta");
+
+        auto delta_sum = SPT::dark_matter_overdensity(deltaq, deltas, deltat, this->loc);
+        this->delta.swap(delta_sum);
+      }
+
+
+    std::unique_ptr<Pk_one_loop> halo_rsd_model::make_Pk() const
+      {
+        auto& sf = this->loc.get_symbol_factory();
+
+        auto r = sf.make_vector(this->r_sym);
+
+        auto phi = SPT::velocity_potential(this->delta);
+
+        // tracer overdensity; for the reduced model this is just the dark matter, but fourier_kernel cannot be
+        // copied, so use a trivially-scaled duplicate
+        auto deltah = this->full ? SPT::halo_overdensity(this->delta, phi, *this->bias_coeffs, this->loc)
+                                 : GiNaC::ex{1} * this->delta;
+
+        // redshift-space transformation
+        auto r_dot_v = dotgrad(r, phi);
+
+        auto deltah_rsd_k1 = SPT::redshift_space_overdensity(deltah, r_dot_v, this->k*this->mu, this->loc);
+        auto deltah_rsd_k2 = SPT::redshift_space_overdensity(deltah, r_dot_v, -this->k*this->mu, this->loc);
+
+        auto Pk = std::make_unique<Pk_one_loop>(this->full ? "1-loop halo RSD P(k)" : "1-loop dark matter RSD P(k)",
+                                                this->full ? "halo" : "dm", deltah_rsd_k1, deltah_rsd_k2, this->k, this->loc);
+
+        // simplify mu-dependence, and remove factors of the unit vector r
+        SPT::simplify_line_of_sight(*Pk, this->k, this->r_sym, this->mu);
+
+        return Pk;
+      }
+
+  }   // namespace bench
@@ -0,0 +1,118 @@
+//
+// Created by David Seery on 08/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#ifndef LSSEFT_ANALYTIC_BENCH_HALO_RSD_MODEL_H
+#define LSSEFT_ANALYTIC_BENCH_HALO_RSD_MODEL_H
+
+
+#include <memory>
+
+#include "services/service_locator.h"
+
+#include "lib/fourier_kernel.h"
+#include "lib/Pk_one_loop.h"
+
+#include "SPT/halo_model.h"
+
+#include "utilities/GiNaC_utils.h"
+
+
+namespace bench
+  {
+
+    //! halo_rsd_model builds the one-loop redshift-space power spectrum computed by LSSEFT_analytic.
+    //! The full model uses the same construction as main.cpp, and includes the halo bias expansion to third order.
+    //! The reduced model retains only the dark matter overdensity, which exercises the same pipeline
+    //! at a fraction of the cost
+    class halo_rsd_model
+      {
+
+        // CONSTRUCTOR, DESTRUCTOR
+
+      public:
+
+        //! constructor declares symbols and builds the dark matter overdensity
+        halo_rsd_model(service_locator& lc_, bool f_);
+
+        //! destructor is default
+        ~halo_rsd_model() = default;
+
+
+        // INTERFACE
+
+      public:
+
+        //! get the dark matter overdensity, to third order in SPT
+        const fourier_kernel<3>& get_delta() const { return this->delta; }
+
+        //! get RSD parameter mu
+        const GiNaC::symbol& get_mu() const { return this->mu; }
+
+        //! get external momentum k
+        const GiNaC::symbol& get_k() const { return this->k; }
+
+        //! get bias symbols; empty for the reduced model
+        const GiNaC_symbol_set& get_bias_symbols() const { return this->bias; }
+
+        //! build the one-loop power spectrum, with its mu-dependence simplified
+        std::unique_ptr<Pk_one_loop> make_Pk() const;
+
+
+        // INTERNAL DATA
+
+      private:
+
+        //! cache reference to service locator
+        service_locator& loc;
+
+        //! build the full halo model?
+        const bool full;
+
+        //! line-of-sight vector label
+        GiNaC::symbol r_sym;
+
+        //! RSD parameter
+        GiNaC::symbol mu;
+
+        //! external momentum
+        GiNaC::symbol k;
+
+        //! halo bias coefficients; null for the reduced model
+        std::unique_ptr<SPT::halo_bias> bias_coeffs;
+
+        //! bias symbols
+        GiNaC_symbol_set bias;
+
+        //! dark matter overdensity
+        fourier_kernel<3> delta;
+
+      };
+
+  }   // namespace bench
+
+
+#endif //LSSEFT_ANALYTIC_BENCH_HALO_RSD_MODEL_H
@@ -0,0 +1,219 @@
+//
+// Created by David Seery on 08/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <thread>
+
+#include "harness.h"
+
+#include "shared/common.h"
+#include "utilities/formatter.h"
+
+#include "boost/date_time/posix_time/posix_time.hpp"
+
+
+namespace bench
+  {
+
+    state::state(size_t n)
+      : iterations(n),
+        remaining(n)
+      {
+      }
+
+
+    bool state::keep_running()
+      {
+        if(!this->started)
+          {
+            this->started = true;
+            this->resume();
+          }
+
+        if(this->remaining == 0)
+          {
+            this->pause();
+            return false;
+          }
+
+        --this->remaining;
+        return true;
+      }
+
+
+    void state::pause()
+      {
+        if(!this->running) return;
+
+        auto now = std::chrono::steady_clock::now();
+        this->elapsed += std::chrono::duration<double, std::nano>(now - this->start).count();
+        this->running = false;
+      }
+
+
+    void state::resume()
+      {
+        if(this->running) return;
+
+        this->start = std::chrono::steady_clock::now();
+        this->running = true;
+      }
+
+
+    std::vector<benchmark>& registry()
+      {
+        static std::vector<benchmark> benchmarks;
+        return benchmarks;
+      }
+
+
+    registrar::registrar(std::string name, function_type f, bool heavy)
+      {
+        registry().push_back(benchmark{std::move(name), std::move(f), heavy});
+      }
+
+
+    //! execute a benchmark for a fixed number of iterations, returning the time per iteration in nanoseconds
+    static double execute(const benchmark& b, size_t n)
+      {
+        state s{n};
+        b.function(s);
+
+        return s.get_elapsed() / static_cast<double>(n);
+      }
+
+
+    std::vector<result> run(const run_options& opts)
+      {
+        std::vector<result> results;
+
+        // run in name order, so that results are comparable between builds
+        auto benchmarks = registry();
+        std::sort(benchmarks.begin(), benchmarks.end(),
+                  [](const benchmark& a, const benchmark& b) -> bool { return a.name < b.name; });
+
+        for(const auto& b : benchmarks)
+          {
+            if(!opts.filter.empty() && b.name.find(opts.filter) == std::string::npos) continue;
+            if(b.heavy && !opts.heavy) continue;
+
+            result r{b.name, 1, {}};
+
+            if(b.heavy)
+              {
+                // heavy benchmarks are timed once
+                r.samples.push_back(execute(b, 1));
+              }
+            else
+              {
+                // calibrate: grow the iteration count until a repetition takes at least the minimum time
+                double per_iter = execute(b, 1);
+                while(per_iter * static_cast<double>(r.iterations) < opts.min_time*1E9 && r.iterations < (1U << 30))
+                  {
+                    double target = opts.min_time*1E9 / std::max(per_iter, 1.0);
+                    r.iterations = std::max(2*r.iterations, std::min(static_cast<size_t>(1.2*target), 10*r.iterations));
+                    per_iter = execute(b, r.iterations);
+                  }
+
+                for(unsigned int i = 0; i < opts.repetitions; ++i)
+                  {
+                    r.samples.push_back(execute(b, r.iterations));
+                  }
+              }
+
+            auto best = *std::min_element(r.samples.begin(), r.samples.end());
+            std::cout << std::left << std::setw(40) << b.name << " "
+                      << std::right << std::setw(10) << r.iterations << " iterations  "
+                      << format_time(static_cast<boost::timer::nanosecond_type>(best)) << " per iteration (best of "
+                      << r.samples.size() << ")" << '\n';
+
+            results.push_back(std::move(r));
+          }
+
+        return results;
+      }
+
+
+    void write_json(const boost::filesystem::path& path, const std::vector<result>& results, const run_options& opts)
+      {
+        std::ofstream out{path.string(), std::ios_base::out | std::ios_base::trunc};
+
+        out << "{" << '\n';
+        out << "  \"context\": {" << '\n';
+        out << "    \"program\": \"LSSEFT_bench\"," << '\n';
+        out << "    \"version\": \"" << PROGRAM_VERSION << "\"," << '\n';
+        out << "    \"date\": \"" << boost::posix_time::to_iso_extended_string(boost::posix_time::second_clock::universal_time()) << "\"," << '\n';
+        out << "    \"hardware_concurrency\": " << std::thread::hardware_concurrency() << "," << '\n';
+        out << "    \"min_time_s\": " << opts.min_time << "," << '\n';
+        out << "    \"repetitions\": " << opts.repetitions << '\n';
+        out << "  }," << '\n';
+
+        // times are nanoseconds per iteration; samples are retained so that results can be compared statistically
+        out << "  \"benchmarks\": [";
+
+        out << std::fixed << std::setprecision(1);
+        for(size_t i = 0; i < results.size(); ++i)
+          {
+            const auto& r = results[i];
+
+            auto sorted = r.samples;
+            std::sort(sorted.begin(), sorted.end());
+
+            double mean = std::accumulate(sorted.begin(), sorted.end(), 0.0) / static_cast<double>(sorted.size());
+            double var = 0.0;
+            for(auto s : sorted)
+              {
+                var += (s - mean)*(s - mean);
+              }
+            double stddev = sorted.size() > 1 ? std::sqrt(var / static_cast<double>(sorted.size() - 1)) : 0.0;
+
+            size_t n = sorted.size();
+            double median = n % 2 == 1 ? sorted[n/2] : (sorted[n/2 - 1] + sorted[n/2]) / 2.0;
+
+            out << (i > 0 ? "," : "") << '\n';
+            out << "    { \"name\": \"" << r.name << "\", \"iterations\": " << r.iterations
+                << ", \"min_ns\": " << sorted.front() << ", \"median_ns\": " << median
+                << ", \"mean_ns\": " << mean << ", \"stddev_ns\": " << stddev
+                << ", \"samples_ns\": [";
+
+            for(size_t j = 0; j < r.samples.size(); ++j)
+              {
+                out << (j > 0 ? ", " : "") << r.samples[j];
+              }
+            out << "] }";
+          }
+
+        out << '\n' << "  ]" << '\n';
+        out << "}" << '\n';
+      }
+
+  }   // namespace bench
@@ -0,0 +1,197 @@
+//
+// Created by David Seery on 08/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#ifndef LSSEFT_ANALYTIC_BENCH_HARNESS_H
+#define LSSEFT_ANALYTIC_BENCH_HARNESS_H
+
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <chrono>
+
+#include "boost/filesystem/operations.hpp"
+
+
+namespace bench
+  {
+
+    //! state is passed to each benchmark function, and controls the number of timed iterations.
+    //! A benchmark performs any setup, then loops while keep_running() returns true;
+    //! only time spent inside the loop (and not between pause() and resume()) is measured
+    class state
+      {
+
+        // CONSTRUCTOR, DESTRUCTOR
+
+      public:
+
+        //! constructor accepts number of iterations to perform
+        explicit state(size_t n);
+
+        //! destructor is default
+        ~state() = default;
+
+
+        // INTERFACE
+
+      public:
+
+        //! advance to the next iteration; returns false when all iterations are complete
+        bool keep_running();
+
+        //! stop the timer, eg. to exclude per-iteration setup
+        void pause();
+
+        //! restart the timer
+        void resume();
+
+        //! get number of iterations
+        size_t get_iterations() const { return this->iterations; }
+
+        //! get measured time, in nanoseconds
+        double get_elapsed() const { return this->elapsed; }
+
+
+        // INTERNAL DATA
+
+      private:
+
+        //! number of iterations requested
+        const size_t iterations;
+
+        //! number of iterations remaining
+        size_t remaining;
+
+        //! has the loop started?
+        bool started{false};
+
+        //! is the timer running?
+        bool running{false};
+
+        //! time at which the timer was last started
+        std::chrono::steady_clock::time_point start;
+
+        //! accumulated time, in nanoseconds
+        double elapsed{0.0};
+
+      };
+
+
+    //! a benchmark function
+    using function_type = std::function<void(state&)>;
+
+
+    //! description of a registered benchmark
+    struct benchmark
+      {
+        //! benchmark name
+        std::string name;
+
+        //! benchmark function
+        function_type function;
+
+        //! heavy benchmarks (eg. full-size models) run only on request, and always for a single iteration
+        bool heavy;
+      };
+
+
+    //! result of running a benchmark
+    struct result
+      {
+        //! benchmark name
+        std::string name;
+
+        //! iterations per repetition
+        size_t iterations;
+
+        //! time per iteration for each repetition, in nanoseconds
+        std::vector<double> samples;
+      };
+
+
+    //! get the list of registered benchmarks
+    std::vector<benchmark>& registry();
+
+
+    //! registrar adds a benchmark to the registry during static initialization
+    class registrar
+      {
+
+      public:
+
+        //! constructor registers benchmark
+        registrar(std::string name, function_type f, bool heavy=false);
+
+      };
+
+
+    //! options controlling a benchmark run
+    struct run_options
+      {
+        //! run only benchmarks whose name contains this string
+        std::string filter;
+
+        //! minimum time per repetition, in seconds
+        double min_time{0.5};
+
+        //! number of repetitions
+        unsigned int repetitions{5};
+
+        //! include heavy benchmarks?
+        bool heavy{false};
+      };
+
+
+    //! run all registered benchmarks matching the supplied options, reporting progress to stdout
+    std::vector<result> run(const run_options& opts);
+
+    //! write results as JSON
+    void write_json(const boost::filesystem::path& path, const std::vector<result>& results, const run_options& opts);
+
+
+    //! prevent the compiler from optimizing away a value computed in a benchmark loop
+    template <typename T>
+    inline void do_not_optimize(const T& value)
+      {
+        asm volatile("" : : "g"(&value) : "memory");
+      }
+
+  }   // namespace bench
+
+
+#define LSSEFT_BENCH_CONCAT_IMPL(a, b) a##b
+#define LSSEFT_BENCH_CONCAT(a, b) LSSEFT_BENCH_CONCAT_IMPL(a, b)
+
+//! register a benchmark function
+#define BENCHMARK(f) static bench::registrar LSSEFT_BENCH_CONCAT(bench_registrar_, __LINE__){#f, f}
+
+//! register a heavy benchmark function, which runs only on request
+#define BENCHMARK_HEAVY(f) static bench::registrar LSSEFT_BENCH_CONCAT(bench_registrar_, __LINE__){#f, f, true}
+
+
+#endif //LSSEFT_ANALYTIC_BENCH_HARNESS_H
@@ -0,0 +1,86 @@
+//
+// Created by David Seery on 08/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#include "harness.h"
+#include "environment.h"
+#include "halo_rsd_model.h"
+
+#include "lib/Pk_rsd.h"
+
+#include "backends/LSSEFT.h"
+
+#include "boost/filesystem/operations.hpp"
+
+
+//! run the complete pipeline: construct the model, compute the one-loop power spectrum, decompose it
+//! into powers of mu and bias monomials, and write the backend output to a temporary directory
+static void run_pipeline(bench::state& st, bool full)
+  {
+    while(st.keep_running())
+      {
+        bench::environment env;
+        auto& loc = env.get_locator();
+
+        bench::halo_rsd_model model{loc, full};
+        auto Pk = model.make_Pk();
+
+        Pk_rsd_set_builder builder{*Pk, model.get_mu(), model.get_bias_symbols()};
+        builder.add("nobias", filter_list{});
+        if(full) builder.add_nonzero_monomials();
+
+        Pk_rsd_set Pks = builder.get();
+
+        st.pause();
+        auto root = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("LSSEFT_bench_%%%%-%%%%");
+        boost::filesystem::create_directories(root);
+        st.resume();
+
+        LSSEFT backend{root / "Pk", loc};
+        backend.add(Pks);
+        backend.write();
+
+        st.pause();
+        boost::filesystem::remove_all(root);
+        st.resume();
+      }
+  }
+
+
+//! dark matter only; small enough to run routinely
+static void halo_rsd_reduced(bench::state& st)
+  {
+    run_pipeline(st, false);
+  }
+BENCHMARK(halo_rsd_reduced);
+
+
+//! full halo model, as computed by LSSEFT_analytic
+static void halo_rsd_full(bench::state& st)
+  {
+    run_pipeline(st, true);
+  }
+BENCHMARK_HEAVY(halo_rsd_full);
@@ -0,0 +1,103 @@
+//
+// Created by David Seery on 08/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "harness.h"
+#include "environment.h"
+
+#include "shared/common.h"
+
+#include "boost/program_options.hpp"
+
+
+// switches specific to LSSEFT_bench; unrecognized switches are forwarded to the argument_cache
+// used by each benchmark, so that eg. --threads or --memoize-kernels can be benchmarked
+constexpr auto SWITCH_BENCH_HELP         = "help";
+constexpr auto HELP_BENCH_HELP           = "obtain brief description of options";
+
+constexpr auto SWITCH_BENCH_FILTER       = "filter";
+constexpr auto HELP_BENCH_FILTER         = "run only benchmarks whose name contains this string";
+
+constexpr auto SWITCH_BENCH_JSON         = "json";
+constexpr auto HELP_BENCH_JSON           = "write results as JSON to the specified file";
+
+constexpr auto SWITCH_BENCH_MIN_TIME     = "min-time";
+constexpr auto HELP_BENCH_MIN_TIME       = "minimum time per repetition, in seconds";
+
+constexpr auto SWITCH_BENCH_REPETITIONS  = "repetitions";
+constexpr auto HELP_BENCH_REPETITIONS    = "number of repetitions of each benchmark";
+
+constexpr auto SWITCH_BENCH_HEAVY        = "heavy";
+constexpr auto HELP_BENCH_HEAVY          = "include heavy benchmarks, such as the full-size halo RSD model";
+
+
+int main(int argc, char* argv[])
+  {
+    boost::program_options::options_description options{"LSSEFT_bench options"};
+    options.add_options()
+      (SWITCH_BENCH_HELP, HELP_BENCH_HELP)
+      (SWITCH_BENCH_FILTER, boost::program_options::value<std::string>(), HELP_BENCH_FILTER)
+      (SWITCH_BENCH_JSON, boost::program_options::value<std::string>(), HELP_BENCH_JSON)
+      (SWITCH_BENCH_MIN_TIME, boost::program_options::value<double>(), HELP_BENCH_MIN_TIME)
+      (SWITCH_BENCH_REPETITIONS, boost::program_options::value<unsigned int>(), HELP_BENCH_REPETITIONS)
+      (SWITCH_BENCH_HEAVY, HELP_BENCH_HEAVY)
+      ;
+
+    auto parsed = boost::program_options::command_line_parser(argc, argv).options(options).allow_unregistered().run();
+
+    boost::program_options::variables_map option_map;
+    boost::program_options::store(parsed, option_map);
+    boost::program_options::notify(option_map);
+
+    if(option_map.count(SWITCH_BENCH_HELP))
+      {
+        std::cout << "LSSEFT_bench " << PROGRAM_VERSION << " " << PROGRAM_COPYRIGHT << '\n';
+        std::cout << options << '\n';
+        return EXIT_SUCCESS;
+      }
+
+    bench::run_options opts;
+    if(option_map.count(SWITCH_BENCH_FILTER))      opts.filter = option_map[SWITCH_BENCH_FILTER].as<std::string>();
+    if(option_map.count(SWITCH_BENCH_MIN_TIME))    opts.min_time = option_map[SWITCH_BENCH_MIN_TIME].as<double>();
+    if(option_map.count(SWITCH_BENCH_REPETITIONS)) opts.repetitions = std::max(option_map[SWITCH_BENCH_REPETITIONS].as<unsigned int>(), 1U);
+    if(option_map.count(SWITCH_BENCH_HEAVY))       opts.heavy = true;
+
+    bench::set_default_arguments(boost::program_options::collect_unrecognized(parsed.options, boost::program_options::include_positional));
+
+    auto results = bench::run(opts);
+
+    if(option_map.count(SWITCH_BENCH_JSON))
+      {
+        bench::write_json(option_map[SWITCH_BENCH_JSON].as<std::string>(), results, opts);
+      }
+
+    return EXIT_SUCCESS;
+  }
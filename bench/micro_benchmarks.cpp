@@ -0,0 +1,220 @@
+//
+// Created by David Seery on 08/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#include <vector>
+
+#include "harness.h"
+#include "environment.h"
+#include "halo_rsd_model.h"
+
+#include "lib/Pk_rsd.h"
+#include "lib/one_loop_reduced_integral.h"
+#include "lib/detail/contractions.h"
+#include "lib/detail/legendre_utils.h"
+#include "lib/detail/special_functions.h"
+
+#include "backends/LSSEFT.h"
+
+#include "utilities/GiNaC_utils.h"
+
+
+//! product of the third-order dark matter overdensity with itself
+static void kernel_product(bench::state& st)
+  {
+    bench::environment env;
+    bench::halo_rsd_model model{env.get_locator(), false};
+
+    const auto& delta = model.get_delta();
+
+    while(st.keep_running())
+      {
+        auto deltasq = delta*delta;
+        bench::do_not_optimize(deltasq);
+      }
+  }
+BENCHMARK(kernel_product);
+
+
+//! index simplification of the third-order kernels of the dark matter overdensity
+static void simplify_index_delta3(bench::state& st)
+  {
+    bench::environment env;
+    bench::halo_rsd_model model{env.get_locator(), false};
+
+    std::vector< std::pair<GiNaC::ex, subs_list> > kernels;
+    for(const auto& item : model.get_delta().order(3))
+      {
+        for(const auto& s : item.second->get_structures())
+          {
+            kernels.emplace_back(s.second, item.second->get_substitution_list());
+          }
+      }
+
+    while(st.keep_running())
+      {
+        for(const auto& K : kernels)
+          {
+            auto result = simplify_index(K.first, K.second, env.get_locator());
+            bench::do_not_optimize(result);
+          }
+      }
+  }
+BENCHMARK(simplify_index_delta3);
+
+
+//! enumeration of Wick contractions between a cubic and a cubic cluster (the 33 contribution); the contraction
+//! template cache is cleared before each iteration, so every enumeration is performed from scratch
+static void contractions_33(bench::state& st)
+  {
+    bench::environment env;
+    auto& sf = env.get_symbol_factory();
+
+    auto q = sf.make_initial_value("delta");
+    auto s = sf.make_initial_value("delta");
+    auto t = sf.make_initial_value("delta");
+    auto u = sf.make_initial_value("delta");
+    auto v = sf.make_initial_value("delta");
+    auto w = sf.make_initial_value("delta");
+
+    auto k = sf.make_symbol("k");
+
+    detail::contractions::iv_group<2> clusters{ { initial_value_set{q, s, t}, initial_value_set{u, v, w} } };
+    detail::contractions::kext_group<2> kext{ { k, -k } };
+
+    while(st.keep_running())
+      {
+        // contraction templates are cached between instances; discard them, so each iteration
+        // enumerates the pairings from scratch
+        st.pause();
+        detail::contractions::clear_template_cache();
+        st.resume();
+
+        detail::contractions c{clusters, kext, env.get_locator()};
+        bench::do_not_optimize(c.get().size());
+      }
+  }
+BENCHMARK(contractions_33);
+
+
+//! one-loop reduction of the 13 and 22 loop integrals of the reduced model; the reduction cache is
+//! cleared before each iteration, so every reduction is performed from scratch
+static void one_loop_reduction(bench::state& st)
+  {
+    bench::environment env;
+    auto& loc = env.get_locator();
+
+    bench::halo_rsd_model model{loc, false};
+    auto Pk = model.make_Pk();
+
+    while(st.keep_running())
+      {
+        st.pause();
+        loc.get_reduction_cache().clear();
+        st.resume();
+
+        for(const auto* db : { &Pk->get_13(), &Pk->get_22() })
+          {
+            for(const auto& record : *db)
+              {
+                one_loop_reduced_integral ri{*record.second.first, loc, true};
+                bench::do_not_optimize(ri);
+              }
+          }
+      }
+  }
+BENCHMARK(one_loop_reduction);
+
+
+//! decomposition of the reduced model power spectrum into powers of mu
+static void Pk_rsd_filter(bench::state& st)
+  {
+    bench::environment env;
+
+    bench::halo_rsd_model model{env.get_locator(), false};
+    auto Pk = model.make_Pk();
+
+    while(st.keep_running())
+      {
+        Pk_rsd_set_builder builder{*Pk, model.get_mu(), model.get_bias_symbols()};
+        builder.add("nobias", filter_list{});
+
+        auto Pks = builder.get();
+        bench::do_not_optimize(Pks);
+      }
+  }
+BENCHMARK(Pk_rsd_filter);
+
+
+//! conversion of a polynomial in angular cosines to Legendre polynomials
+static void cosines_to_Legendre_poly(bench::state& st)
+  {
+    bench::environment env;
+    auto& sf = env.get_symbol_factory();
+
+    auto q = sf.make_symbol("q");
+    auto k = sf.make_symbol("k");
+    auto s = sf.make_symbol("s");
+
+    GiNaC::ex expr{0};
+    for(unsigned int i = 0; i <= 4; ++i)
+      {
+        for(unsigned int j = 0; j <= 4; ++j)
+          {
+            expr += GiNaC::pow(k, i) * GiNaC::pow(s, j)
+                    * GiNaC::pow(Angular::Cos(q, k), i) * GiNaC::pow(Angular::Cos(q, s), j);
+          }
+      }
+
+    while(st.keep_running())
+      {
+        auto result = cosines_to_Legendre(expr, q);
+        bench::do_not_optimize(result);
+      }
+  }
+BENCHMARK(cosines_to_Legendre_poly);
+
+
+//! formatting of a rational integrand, similar to those generated by the LSSEFT backend
+static void format_print_integrand(bench::state& st)
+  {
+    bench::environment env;
+    auto& sf = env.get_symbol_factory();
+
+    auto q = sf.make_symbol("q_");
+    auto z = sf.make_symbol("z_");
+    auto k = sf.make_symbol("k_");
+
+    auto expr = GiNaC::expand(GiNaC::pow(1 + q*z + k*z*z + q*q, 8))
+                / GiNaC::pow(k*k + q*q - 2*k*q*z, 3) / GiNaC::sqrt(k*k + q*q - 2*k*q*z);
+
+    while(st.keep_running())
+      {
+        auto result = LSSEFT_impl::format_print(expr);
+        bench::do_not_optimize(result);
+      }
+  }
+BENCHMARK(format_print_integrand);
@@ -0,0 +1,23 @@
+CMAKE_MINIMUM_REQUIRED(VERSION 3.0)
+
+# compute a SHA1 digest over the contents of a set of source files, specified by glob patterns
+# relative to the current source directory, and store it in VAR.
+# The files are added to the configure dependencies, so the digest is recomputed whenever one
+# of them changes
+FUNCTION(SOURCE_DIGEST VAR)
+
+  FILE(GLOB_RECURSE DIGEST_FILES RELATIVE ${CMAKE_CURRENT_SOURCE_DIR} ${ARGN})
+  LIST(SORT DIGEST_FILES)
+
+  SET(DIGEST_HASHES "")
+  FOREACH(DIGEST_FILE ${DIGEST_FILES})
+    FILE(SHA1 ${CMAKE_CURRENT_SOURCE_DIR}/${DIGEST_FILE} DIGEST_FILE_HASH)
+    SET(DIGEST_HASHES "${DIGEST_HASHES}${DIGEST_FILE}:${DIGEST_FILE_HASH};")
+  ENDFOREACH()
+
+  SET_PROPERTY(DIRECTORY APPEND PROPERTY CMAKE_CONFIGURE_DEPENDS ${DIGEST_FILES})
+
+  STRING(SHA1 DIGEST "${DIGEST_HASHES}")
+  SET(${VAR} ${DIGEST} PARENT_SCOPE)
+
+ENDFUNCTION()
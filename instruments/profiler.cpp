@@ -0,0 +1,309 @@
+//
+// Created by David Seery on 06/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <cstring>
+
+#include <time.h>
+
+#include "profiler.h"
+
+#include "utilities/hash_combine.h"
+#include "utilities/json_escape.h"
+
+
+namespace profiler_impl
+  {
+
+    //! maximum number of trace events retained per thread
+    constexpr size_t max_trace_events = 1U << 20;
+
+
+    //! get CPU time consumed by the calling thread, in nanoseconds
+    static uint64_t thread_cpu_time()
+      {
+        timespec ts;
+        if(clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) return 0;
+
+        return static_cast<uint64_t>(ts.tv_sec)*1000000000ULL + static_cast<uint64_t>(ts.tv_nsec);
+      }
+
+
+    //! data for a region, merged over threads
+    struct merged_region
+      {
+        uint64_t count{0};
+        uint64_t wall{0};
+        uint64_t cpu{0};
+
+        //! number of entries on each thread
+        std::map<unsigned int, uint64_t> threads;
+      };
+
+  }   // namespace profiler_impl
+
+
+constexpr profiler::node_id profiler::no_parent;
+
+
+size_t profiler::node_key_hasher::operator()(const node_key& k) const
+  {
+    size_t h = 0;
+    hash_impl::hash_combine(h, k.first, k.second);
+
+    return h;
+  }
+
+
+profiler& profiler::instance()
+  {
+    static profiler p;
+    return p;
+  }
+
+
+void profiler::enable(bool trace)
+  {
+    this->tracing = trace;
+    this->origin = std::chrono::steady_clock::now();
+    this->active.store(true);
+  }
+
+
+profiler::thread_record& profiler::local()
+  {
+    // thread records are owned by the profiler, so they outlive the threads which use them
+    thread_local thread_record* rec = nullptr;
+    if(rec != nullptr) return *rec;
+
+    std::lock_guard<std::mutex> lock{this->mtx};
+
+    this->threads.push_back(std::make_unique<thread_record>(static_cast<unsigned int>(this->threads.size())));
+    rec = this->threads.back().get();
+
+    return *rec;
+  }
+
+
+void profiler::begin(const char* name)
+  {
+    auto& rec = this->local();
+
+    // fold directly-recursive entries into the enclosing region
+    if(!rec.stack.empty() && std::strcmp(rec.stack.back().name, name) == 0)
+      {
+        ++rec.stack.back().recursion;
+        return;
+      }
+
+    open_region r;
+    r.name = name;
+    r.node = this->intern(rec, rec.stack.empty() ? no_parent : rec.stack.back().node, name);
+    r.cpu_start = profiler_impl::thread_cpu_time();
+    r.wall_start = std::chrono::steady_clock::now();
+
+    rec.stack.push_back(std::move(r));
+  }
+
+
+void profiler::begin(const std::string& name)
+  {
+    // names are interned per thread, so no lock is needed; thread records outlive their threads,
+    // so the interned name remains valid for the report and trace
+    auto& rec = this->local();
+    this->begin(rec.names.insert(name).first->c_str());
+  }
+
+
+profiler::node_id profiler::intern(thread_record& rec, node_id parent, const char* name)
+  {
+    auto t = rec.children.find(std::make_pair(parent, name));
+    if(t != rec.children.end()) return t->second;
+
+    auto id = static_cast<node_id>(rec.nodes.size());
+
+    // the node list is read when writing a report, so it must be extended under the record's lock
+      {
+        std::lock_guard<std::mutex> lock{rec.mtx};
+        rec.nodes.push_back(region_node{parent, name, region_stats{}});
+      }
+
+    rec.children.emplace(std::make_pair(parent, name), id);
+    return id;
+  }
+
+
+void profiler::end()
+  {
+    auto wall_end = std::chrono::steady_clock::now();
+    auto cpu_end = profiler_impl::thread_cpu_time();
+
+    auto& rec = this->local();
+    if(rec.stack.empty()) return;
+
+    auto& r = rec.stack.back();
+    if(r.recursion > 0)
+      {
+        --r.recursion;
+        return;
+      }
+
+    auto wall = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(wall_end - r.wall_start).count());
+    auto cpu = cpu_end > r.cpu_start ? cpu_end - r.cpu_start : 0;
+
+      {
+        std::lock_guard<std::mutex> lock{rec.mtx};
+
+        auto& stats = rec.nodes[r.node].stats;
+        ++stats.count;
+        stats.wall += wall;
+        stats.cpu += cpu;
+
+        if(this->tracing)
+          {
+            if(rec.events.size() < profiler_impl::max_trace_events)
+              {
+                auto start = std::chrono::duration_cast<std::chrono::nanoseconds>(r.wall_start - this->origin).count();
+                rec.events.push_back(trace_event{r.name, static_cast<uint64_t>(start), wall});
+              }
+            else
+              {
+                ++rec.dropped;
+              }
+          }
+      }
+
+    rec.stack.pop_back();
+  }
+
+
+void profiler::write_report(const boost::filesystem::path& path) const
+  {
+    std::map<std::string, profiler_impl::merged_region> regions;
+    uint64_t dropped = 0;
+
+      {
+        std::lock_guard<std::mutex> lock{this->mtx};
+
+        for(const auto& rec : this->threads)
+          {
+            std::lock_guard<std::mutex> rec_lock{rec->mtx};
+
+            // build the path to each node; parents precede their children, so a single pass suffices.
+            // Nodes with the same path (eg. the same name held at different addresses) are merged
+            std::vector<std::string> paths;
+            paths.reserve(rec->nodes.size());
+
+            for(const auto& node : rec->nodes)
+              {
+                paths.push_back(node.parent == no_parent ? std::string{node.name}
+                                                         : paths[node.parent] + "/" + node.name);
+
+                const auto& s = node.stats;
+                if(s.count == 0) continue;
+
+                auto& m = regions[paths.back()];
+                m.count += s.count;
+                m.wall += s.wall;
+                m.cpu += s.cpu;
+                m.threads[rec->tid] += s.count;
+              }
+
+            dropped += rec->dropped;
+          }
+      }
+
+    std::ofstream out{path.string(), std::ios_base::out | std::ios_base::trunc};
+
+    // regions are written in path order, so children immediately follow their parents
+    out << "{" << '\n';
+    out << "  \"dropped_trace_events\": " << dropped << "," << '\n';
+    out << "  \"regions\": [" << '\n';
+
+    unsigned int count = 0;
+    for(const auto& item : regions)
+      {
+        const std::string& p = item.first;
+        const auto& m = item.second;
+
+        auto pos = p.rfind('/');
+        std::string name = pos == std::string::npos ? p : p.substr(pos+1);
+        auto depth = std::count(p.begin(), p.end(), '/');
+
+        if(count++ > 0) out << "," << '\n';
+        out << "    { \"path\": \"" << json_escape(p) << "\", \"name\": \"" << json_escape(name) << "\""
+            << ", \"depth\": " << depth << ", \"count\": " << m.count
+            << std::fixed << std::setprecision(6)
+            << ", \"wall_s\": " << static_cast<double>(m.wall) / 1E9
+            << ", \"cpu_s\": " << static_cast<double>(m.cpu) / 1E9
+            << ", \"threads\": {";
+
+        unsigned int tc = 0;
+        for(const auto& t : m.threads)
+          {
+            if(tc++ > 0) out << ", ";
+            out << "\"" << t.first << "\": " << t.second;
+          }
+        out << "} }";
+      }
+
+    out << '\n' << "  ]" << '\n';
+    out << "}" << '\n';
+  }
+
+
+void profiler::write_trace(const boost::filesystem::path& path) const
+  {
+    std::ofstream out{path.string(), std::ios_base::out | std::ios_base::trunc};
+
+    out << "{" << '\n';
+    out << "  \"displayTimeUnit\": \"ms\"," << '\n';
+    out << "  \"traceEvents\": [" << '\n';
+
+    std::lock_guard<std::mutex> lock{this->mtx};
+
+    // trace-event timestamps and durations are in microseconds
+    unsigned int count = 0;
+    out << std::fixed << std::setprecision(3);
+    for(const auto& rec : this->threads)
+      {
+        std::lock_guard<std::mutex> rec_lock{rec->mtx};
+
+        for(const auto& e : rec->events)
+          {
+            if(count++ > 0) out << "," << '\n';
+            out << "    { \"name\": \"" << json_escape(e.name) << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << rec->tid
+                << ", \"ts\": " << static_cast<double>(e.start) / 1E3
+                << ", \"dur\": " << static_cast<double>(e.duration) / 1E3 << " }";
+          }
+      }
+
+    out << '\n' << "  ]" << '\n';
+    out << "}" << '\n';
+  }
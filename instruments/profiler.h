@@ -0,0 +1,292 @@
+//
+// Created by David Seery on 06/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#ifndef LSSEFT_ANALYTIC_PROFILER_H
+#define LSSEFT_ANALYTIC_PROFILER_H
+
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+#include "boost/filesystem/operations.hpp"
+
+
+//! profiler records nested, scoped regions on each thread. For each region it accumulates a call count,
+//! wall and CPU time, and the threads on which the region was entered. Results can be written as a JSON
+//! report, and optionally as a trace in Chrome's trace-event format.
+//! Profiling is disabled by default; while disabled, regions cost a single test of an atomic flag
+class profiler
+  {
+
+    // TYPES
+
+  protected:
+
+    //! timing data for a region
+    struct region_stats
+      {
+        //! number of (outermost) entries
+        uint64_t count{0};
+
+        //! accumulated wall time in nanoseconds
+        uint64_t wall{0};
+
+        //! accumulated CPU time in nanoseconds
+        uint64_t cpu{0};
+      };
+
+    //! a completed region, for the Chrome trace
+    struct trace_event
+      {
+        //! region name; points to a string literal or an interned name
+        const char* name;
+
+        //! start time in nanoseconds, measured from when profiling was enabled
+        uint64_t start;
+
+        //! duration in nanoseconds
+        uint64_t duration;
+      };
+
+    //! type for region node identifiers; nodes are numbered per thread in order of first entry,
+    //! so a node's parent always has a smaller identifier
+    using node_id = unsigned int;
+
+    //! parent identifier used for outermost regions
+    static constexpr node_id no_parent = static_cast<node_id>(-1);
+
+    //! a node in the tree of regions entered on a thread, identified by its parent and name
+    struct region_node
+      {
+        //! parent node, or no_parent for an outermost region
+        node_id parent;
+
+        //! region name
+        const char* name;
+
+        //! accumulated data
+        region_stats stats;
+      };
+
+    //! key identifying a node by its parent and name
+    using node_key = std::pair<node_id, const char*>;
+
+    //! hash a node key
+    struct node_key_hasher
+      {
+        size_t operator()(const node_key& k) const;
+      };
+
+    //! a region which has been entered, but not yet left
+    struct open_region
+      {
+        //! region name
+        const char* name;
+
+        //! node representing this region
+        node_id node;
+
+        //! wall time at entry
+        std::chrono::steady_clock::time_point wall_start;
+
+        //! thread CPU time at entry, in nanoseconds
+        uint64_t cpu_start;
+
+        //! number of directly-recursive entries folded into this region
+        unsigned int recursion{0};
+      };
+
+    //! per-thread profiling data
+    struct thread_record
+      {
+        //! constructor captures thread label
+        explicit thread_record(unsigned int t) : tid(t) { }
+
+        //! thread label, in order of first use
+        const unsigned int tid;
+
+        //! mutex protecting nodes and events; held only briefly by the owning thread,
+        //! so is normally uncontended
+        std::mutex mtx;
+
+        //! region nodes, indexed by node identifier; paths are built from these only when writing a report
+        std::vector<region_node> nodes;
+
+        //! map from (parent, name) pairs to node identifiers; accessed only by the owning thread
+        std::unordered_map<node_key, node_id, node_key_hasher> children;
+
+        //! names interned for regions entered on this thread with a transient name;
+        //! accessed only by the owning thread
+        std::set<std::string> names;
+
+        //! completed regions, for the Chrome trace
+        std::vector<trace_event> events;
+
+        //! number of trace events discarded because the buffer was full
+        uint64_t dropped{0};
+
+        //! stack of open regions; accessed only by the owning thread
+        std::vector<open_region> stack;
+      };
+
+
+    // CONSTRUCTOR, DESTRUCTOR
+
+  protected:
+
+    //! constructor is default; use instance() to obtain the profiler
+    profiler() = default;
+
+  public:
+
+    //! destructor is default
+    ~profiler() = default;
+
+    //! disable copying
+    profiler(const profiler& obj) = delete;
+
+
+    // INTERFACE
+
+  public:
+
+    //! get the process-wide profiler
+    static profiler& instance();
+
+    //! enable profiling; if trace is true, individual regions are also recorded for the Chrome trace
+    void enable(bool trace);
+
+    //! test whether profiling is enabled
+    bool enabled() const { return this->active.load(std::memory_order_relaxed); }
+
+    //! enter a region; name should have static storage duration (eg. a string literal).
+    //! A region entered directly inside another region of the same name is folded into it,
+    //! so recursive functions are reported as a single region
+    void begin(const char* name);
+
+    //! enter a region with a name that need not outlive the region
+    void begin(const std::string& name);
+
+    //! leave the innermost open region on this thread
+    void end();
+
+    //! write JSON report of accumulated timing data
+    void write_report(const boost::filesystem::path& path) const;
+
+    //! write Chrome trace-event file
+    void write_trace(const boost::filesystem::path& path) const;
+
+
+    // INTERNAL API
+
+  protected:
+
+    //! get profiling data for the current thread
+    thread_record& local();
+
+    //! get the node for a region with a given parent and name on the current thread, creating it if necessary
+    node_id intern(thread_record& rec, node_id parent, const char* name);
+
+
+    // INTERNAL DATA
+
+  private:
+
+    //! is profiling enabled?
+    std::atomic<bool> active{false};
+
+    //! is the Chrome trace enabled?
+    bool tracing{false};
+
+    //! time at which profiling was enabled
+    std::chrono::steady_clock::time_point origin;
+
+    //! mutex protecting thread records
+    mutable std::mutex mtx;
+
+    //! per-thread records
+    std::vector< std::unique_ptr<thread_record> > threads;
+
+  };
+
+
+//! profile_region enters a profiler region on construction, and leaves it on destruction
+class profile_region
+  {
+
+    // CONSTRUCTOR, DESTRUCTOR
+
+  public:
+
+    //! constructor enters region, if profiling is enabled
+    template <typename Name>
+    explicit profile_region(const Name& name)
+      : active(profiler::instance().enabled())
+      {
+        if(this->active) profiler::instance().begin(name);
+      }
+
+    //! destructor leaves region
+    ~profile_region()
+      {
+        if(this->active) profiler::instance().end();
+      }
+
+    //! disable copying
+    profile_region(const profile_region& obj) = delete;
+
+
+    // INTERNAL DATA
+
+  private:
+
+    //! was a region entered?
+    const bool active;
+
+  };
+
+
+#define LSSEFT_PROFILE_CONCAT_IMPL(a, b) a##b
+#define LSSEFT_PROFILE_CONCAT(a, b) LSSEFT_PROFILE_CONCAT_IMPL(a, b)
+
+//! profile the remainder of the enclosing scope as a region with the given name
+#define PROFILE_SCOPE(name) profile_region LSSEFT_PROFILE_CONCAT(profile_region_, __LINE__){name}
+
+//! profile the remainder of the enclosing function, labelled by its unqualified name
+#define PROFILE_FUNCTION() PROFILE_SCOPE(__func__)
+
+
+#endif //LSSEFT_ANALYTIC_PROFILER_H
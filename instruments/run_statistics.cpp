@@ -0,0 +1,169 @@
+//
+// Created by David Seery on 07/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#include <fstream>
+
+#include "run_statistics.h"
+
+#include "utilities/json_escape.h"
+
+#include <sys/resource.h>
+
+#if defined(__APPLE__)
+  #include <mach/mach.h>
+#elif defined(__linux__)
+  #include <unistd.h>
+#endif
+
+
+size_t run_statistics::current_rss()
+  {
+#if defined(__APPLE__)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if(task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) return 0;
+
+    return static_cast<size_t>(info.resident_size);
+#elif defined(__linux__)
+    // second field of /proc/self/statm is the resident set size, in pages
+    std::ifstream statm{"/proc/self/statm"};
+    size_t size = 0;
+    size_t resident = 0;
+    if(!(statm >> size >> resident)) return 0;
+
+    return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+#else
+    return 0;
+#endif
+  }
+
+
+size_t run_statistics::peak_rss()
+  {
+    rusage usage;
+    if(getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+
+#if defined(__APPLE__)
+    // macOS reports ru_maxrss in bytes
+    return static_cast<size_t>(usage.ru_maxrss);
+#else
+    // Linux reports ru_maxrss in kilobytes
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+  }
+
+
+void run_statistics::checkpoint(const std::string& stage)
+  {
+    if(!this->active) return;
+
+    this->stages.push_back(stage_record{stage, current_rss(), peak_rss()});
+  }
+
+
+void run_statistics::add(const std::string& label, const Pk_one_loop& Pk)
+  {
+    if(!this->active) return;
+
+    std::ostringstream data;
+    data << "{ \"tree\": " << Pk.get_tree().size() << ", \"13\": " << Pk.get_13().size()
+         << ", \"22\": " << Pk.get_22().size() << " }";
+
+    this->objects.push_back(object_record{label, "Pk_one_loop", data.str()});
+  }
+
+
+void run_statistics::add(const std::string& label, const Pk_rsd_set& Pks)
+  {
+    if(!this->active) return;
+
+    auto write_counts = [](std::ostream& out, const Pk_rsd_group& group) -> void
+      {
+        const auto counts = group.get_element_counts();
+
+        out << "[";
+        for(size_t i = 0; i < counts.size(); ++i)
+          {
+            if(i > 0) out << ", ";
+            out << counts[i];
+          }
+        out << "]";
+      };
+
+    // counts are given for mu^0, mu^2, ..., mu^8
+    std::ostringstream data;
+    data << "{";
+
+    unsigned int count = 0;
+    for(const auto& item : Pks)
+      {
+        const Pk_rsd& Pk = item.second.get();
+
+        if(count++ > 0) data << ",";
+        data << '\n' << "        \"" << json_escape(item.first) << "\": { \"tree\": ";
+        write_counts(data, Pk.get_tree());
+        data << ", \"13\": ";
+        write_counts(data, Pk.get_13());
+        data << ", \"22\": ";
+        write_counts(data, Pk.get_22());
+        data << " }";
+      }
+
+    data << '\n' << "      }";
+
+    this->objects.push_back(object_record{label, "Pk_rsd_set", data.str()});
+  }
+
+
+void run_statistics::write(const boost::filesystem::path& path) const
+  {
+    std::ofstream out{path.string(), std::ios_base::out | std::ios_base::trunc};
+
+    out << "{" << '\n';
+
+    out << "  \"stages\": [";
+    for(size_t i = 0; i < this->stages.size(); ++i)
+      {
+        const auto& s = this->stages[i];
+
+        out << (i > 0 ? "," : "") << '\n';
+        out << "    { \"name\": \"" << json_escape(s.name) << "\", \"rss_bytes\": " << s.rss << ", \"peak_rss_bytes\": " << s.peak_rss << " }";
+      }
+    out << '\n' << "  ]," << '\n';
+
+    out << "  \"objects\": [";
+    for(size_t i = 0; i < this->objects.size(); ++i)
+      {
+        const auto& o = this->objects[i];
+
+        out << (i > 0 ? "," : "") << '\n';
+        out << "    { \"label\": \"" << json_escape(o.label) << "\", \"type\": \"" << o.type << "\", \"data\": " << o.data << " }";
+      }
+    out << '\n' << "  ]" << '\n';
+
+    out << "}" << '\n';
+  }
@@ -0,0 +1,185 @@
+//
+// Created by David Seery on 07/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#ifndef LSSEFT_ANALYTIC_RUN_STATISTICS_H
+#define LSSEFT_ANALYTIC_RUN_STATISTICS_H
+
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <algorithm>
+
+#include "lib/fourier_kernel.h"
+#include "lib/Pk_one_loop.h"
+#include "lib/Pk_rsd.h"
+
+#include "utilities/GiNaC_utils.h"
+
+#include "boost/filesystem/operations.hpp"
+
+
+//! run_statistics records resident memory at stage boundaries, together with structural statistics
+//! for the principal objects of the calculation (Fourier kernels, one-loop power spectra and their
+//! RSD decompositions), and writes them as a JSON summary.
+//! Collection is disabled by default; while disabled, all operations do nothing
+class run_statistics
+  {
+
+    // TYPES
+
+  protected:
+
+    //! memory usage at the end of a stage
+    struct stage_record
+      {
+        //! stage name
+        std::string name;
+
+        //! resident set size at the end of the stage, in bytes
+        size_t rss;
+
+        //! peak resident set size up to the end of the stage, in bytes
+        size_t peak_rss;
+      };
+
+    //! structural statistics for an object
+    struct object_record
+      {
+        //! object label
+        std::string label;
+
+        //! object type
+        std::string type;
+
+        //! JSON fragment describing the object
+        std::string data;
+      };
+
+
+    // CONSTRUCTOR, DESTRUCTOR
+
+  public:
+
+    //! constructor is default
+    run_statistics() = default;
+
+    //! destructor is default
+    ~run_statistics() = default;
+
+
+    // INTERFACE
+
+  public:
+
+    //! enable collection
+    void enable() { this->active = true; }
+
+    //! test whether collection is enabled
+    bool enabled() const { return this->active; }
+
+    //! record memory usage at the end of the named stage
+    void checkpoint(const std::string& stage);
+
+    //! record the number of kernels at each order in a Fourier kernel, together with the
+    //! total node count and maximum depth of their expressions
+    template <unsigned int N>
+    void add(const std::string& label, const fourier_kernel<N>& ker);
+
+    //! record the number of loop integrals in each database of a one-loop power spectrum
+    void add(const std::string& label, const Pk_one_loop& Pk);
+
+    //! record the number of elements at each power of mu, for each group of an RSD power spectrum set
+    void add(const std::string& label, const Pk_rsd_set& Pks);
+
+    //! write JSON summary
+    void write(const boost::filesystem::path& path) const;
+
+
+    // INTERNAL API
+
+  protected:
+
+    //! get current resident set size, in bytes; zero if unavailable
+    static size_t current_rss();
+
+    //! get peak resident set size, in bytes; zero if unavailable
+    static size_t peak_rss();
+
+
+    // INTERNAL DATA
+
+  private:
+
+    //! is collection enabled?
+    bool active{false};
+
+    //! memory usage at stage boundaries, in order
+    std::vector<stage_record> stages;
+
+    //! structural statistics, in order of collection
+    std::vector<object_record> objects;
+
+  };
+
+
+template <unsigned int N>
+void run_statistics::add(const std::string& label, const fourier_kernel<N>& ker)
+  {
+    if(!this->active) return;
+
+    std::ostringstream data;
+    data << "[";
+
+    for(unsigned int ord = 1; ord <= N; ++ord)
+      {
+        auto view = ker.order(ord);
+
+        size_t nodes = 0;
+        size_t depth = 0;
+        for(const auto& item : view)
+          {
+            // measure each momentum structure with its coefficient, as they are stored
+            for(const auto& s : item.second->get_structures())
+              {
+                nodes += expression_nodes(s.first) + expression_nodes(s.second);
+                depth = std::max(depth, expression_depth(s.second));
+              }
+          }
+
+        if(ord > 1) data << ", ";
+        data << "{ \"order\": " << ord << ", \"kernels\": " << view.size()
+             << ", \"nodes\": " << nodes << ", \"max_depth\": " << depth << " }";
+      }
+
+    data << "]";
+
+    this->objects.push_back(object_record{label, "fourier_kernel", data.str()});
+  }
+
+
+#endif //LSSEFT_ANALYTIC_RUN_STATISTICS_H
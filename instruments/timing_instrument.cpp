@@ -34,7 +34,8 @@
 
 
 timing_instrument::timing_instrument(std::string name_)
-  : name(std::move(name_))
+  : name(std::move(name_)),
+    region(name)
   {
   }
 
@@ -30,11 +30,13 @@
 
 #include <string>
 
-#include "timing_instrument.h"
+#include "profiler.h"
 
 #include "boost/timer/timer.hpp"
 
 
+//! timing_instrument reports the wall-clock time spent in a stage of the calculation;
+//! each stage is also recorded as a top-level profiler region
 class timing_instrument
   {
 
@@ -59,6 +61,9 @@ class timing_instrument
     //! cache name
     const std::string name;
 
+    //! profiler region for this stage
+    profile_region region;
+
   };
 
 
@@ -24,8 +24,18 @@
 // --@@
 //
 
+#include <algorithm>
+#include <sstream>
+#include <vector>
+
 #include "Pk_one_loop.h"
 
+#include "services/checkpoint.h"
+
+#include "shared/defaults.h"
+#include "shared/error.h"
+#include "shared/exceptions.h"
+
 
 namespace Pk_one_loop_impl
   {
@@ -64,14 +74,128 @@ namespace Pk_one_loop_impl
 
     void Pk_db::reduce_angular_integrals(service_locator& loc, bool symmetrize)
       {
-        // walk through each subintegral in turn, performing angular reduction on it
+        // walk through each subintegral in turn, performing angular reduction on it.
+        // GiNaC expressions and the caches used during reduction cannot be shared between threads,
+        // so if several workers are available the reductions are divided between forked processes.
         // the 'symmetrize' flag allows optional symmetrization of the loop and Rayleigh integrals
         // to accommodate 22-type integrations
+
+        auto& ic = loc.get_integral_cache();
+
+        // subintegrals which were not found in the persistent reduction cache, with their fingerprints
+        std::vector< std::pair<db_type::value_type*, std::string> > pending;
+
+        // first, consult the persistent reduction cache, if it is in use; the reduction depends on the
+        // symmetrization flag as well as the integral, so both form part of the fingerprint
         for(auto& item : this->db)
           {
             const loop_integral& lp = *item.second.first;
             std::unique_ptr<one_loop_reduced_integral>& ri = item.second.second;
-            ri = std::make_unique<one_loop_reduced_integral>(lp, loc, symmetrize);    // will release any previous assignment
+            ri.reset();    // release any previous assignment
+
+            std::string fingerprint;
+            if(ic.enabled())
+              {
+                fingerprint = lp.fingerprint() + (symmetrize ? ";symmetrized" : ";unsymmetrized");
+
+                auto cached = ic.find(fingerprint, loc.get_symbol_factory());
+                if(cached)
+                  {
+                    try
+                      {
+                        ri = std::make_unique<one_loop_reduced_integral>(lp, *cached, loc);
+                      }
+                    catch(exception&)
+                      {
+                        // entry has unexpected form; fall back to performing the reduction
+                      }
+                  }
+              }
+
+            if(!ri) pending.emplace_back(&item, std::move(fingerprint));
+          }
+
+        // second, perform the remaining reductions
+        // set up progress counter; progress is reported approximately every 10%
+        // for databases large enough to make this worthwhile
+        const size_t total = pending.size();
+        const size_t stride = std::max(total / 10, size_t(1));
+        size_t completed = 0;
+        error_handler err;
+
+        auto report = [&](size_t done) -> void
+          {
+            const size_t previous = completed;
+            completed += done;
+
+            if(total >= LSSEFT_PROGRESS_REPORT_THRESHOLD && (completed / stride > previous / stride || completed == total))
+              {
+                std::ostringstream msg;
+                msg << LABEL_ANGULAR_REDUCTION_PROGRESS << " " << completed << "/" << total;
+
+                err.info(msg.str());
+              }
+          };
+
+        auto& pool = loc.get_process_pool();
+
+        if(!pool.parallel(total))
+          {
+            for(auto& record : pending)
+              {
+                const loop_integral& lp = *record.first->second.first;
+                record.first->second.second = std::make_unique<one_loop_reduced_integral>(lp, loc, symmetrize);
+
+                report(1);
+              }
+          }
+        else
+          {
+            // each worker returns its reductions in archived form, together with the state of its
+            // symbol factory; this is restored first, so that any symbols minted during reduction are
+            // known before the reductions are unarchived
+            auto work = [&](size_t begin, size_t end, checkpoint& out) -> void
+              {
+                GiNaC::lst reductions;
+                for(size_t n = begin; n < end; ++n)
+                  {
+                    one_loop_reduced_integral ri{*pending[n].first->second.first, loc, symmetrize};
+                    reductions.append(ri.to_archive());
+                  }
+
+                out.archive_ex("reductions", reductions);
+                loc.get_symbol_factory().archive(out);
+              };
+
+            auto collect = [&](size_t begin, size_t end, checkpoint& in) -> void
+              {
+                auto& sf = loc.get_symbol_factory();
+                sf.restore(in);
+                in.set_symbol_table(sf.get_symbol_table());
+
+                auto archived = in.unarchive_ex("reductions");
+                const auto& reductions = archive_list(archived, end - begin);
+
+                for(size_t n = begin; n < end; ++n)
+                  {
+                    const loop_integral& lp = *pending[n].first->second.first;
+                    pending[n].first->second.second =
+                      std::make_unique<one_loop_reduced_integral>(lp, reductions.op(n - begin), loc);
+                  }
+
+                report(end - begin);
+              };
+
+            pool.run(total, work, collect);
+          }
+
+        // finally, store the new reductions in the persistent cache
+        if(ic.enabled())
+          {
+            for(const auto& record : pending)
+              {
+                ic.insert(record.second, record.first->second.second->to_archive());
+              }
           }
       }
 
@@ -151,6 +275,45 @@ namespace Pk_one_loop_impl
       }
 
 
+    GiNaC::ex Pk_db::to_archive() const
+      {
+        // archived form is a list of pairs {loop integral, reduced integral}; an empty list stands for
+        // a missing reduced integral
+        GiNaC::lst list;
+
+        for(const auto& item : this->db)
+          {
+            const loop_pair& record = item.second;
+
+            GiNaC::lst pair;
+            pair.append(record.first->to_archive());
+            pair.append(record.second ? record.second->to_archive() : GiNaC::ex{GiNaC::lst{}});
+
+            list.append(pair);
+          }
+
+        return list;
+      }
+
+
+    void Pk_db::restore(const GiNaC::ex& ar, service_locator& loc)
+      {
+        for(const auto& item : archive_list(ar))
+          {
+            const auto& pair = archive_list(item, 2);
+
+            auto lp = std::make_unique<loop_integral>(pair.op(0), loc);
+
+            std::unique_ptr<one_loop_reduced_integral> ri;
+            if(pair.op(1).nops() > 0) ri = std::make_unique<one_loop_reduced_integral>(*lp, pair.op(1), loc);
+
+            loop_integral_key key{*lp};
+            auto res = this->db.emplace(std::move(key), std::make_pair(std::move(lp), std::move(ri)));
+            if(!res.second) throw exception(ERROR_LOOP_INTEGRAL_INSERT_FAILED, exception_code::Pk_error);
+          }
+      }
+
+
     void Pk_db::clear_reduced_integrals()
       {
         for(auto& record : this->db)
@@ -228,6 +391,96 @@ Pk_one_loop::Pk_one_loop(const Pk_one_loop& obj)
   }
 
 
+void Pk_one_loop::contract_pair(const kernel& ker1, const kernel& ker2, Pk_db& db)
+  {
+    const auto& tm1 = ker1.get_time_function();
+    const auto& tm2 = ker2.get_time_function();
+
+    // momentum structures are contracted individually, with their coefficients carried alongside;
+    // this keeps coefficient symbols out of the loop integrals, so that contraction and reduction work
+    // once per momentum structure rather than once per combination of coefficients
+    const auto& S1 = ker1.get_structures();
+    const auto& S2 = ker2.get_structures();
+
+    const auto& iv1 = ker1.get_initial_value_set();
+    const auto& iv2 = ker2.get_initial_value_set();
+    
+    const auto& rm1 = ker1.get_substitution_list();
+    const auto& rm2 = ker2.get_substitution_list();
+
+    detail::contractions ctrs(detail::contractions::iv_group<2>{ iv1, iv2 },
+                              detail::contractions::kext_group<2>{ this->k, -this->k }, this->loc);
+
+    // simplify dot products where possible
+    GiNaC::scalar_products dotp;
+    dotp.add(this->k, this->k, this->k*this->k);
+    // k.l, l.l and other inner products are supposed to be picked up later by
+    // loop integral transformations
+
+    const auto& Wicks = ctrs.get();
+    for(const auto& W : Wicks)
+      {
+        const auto& data = *W;
+        const auto& loops = data.get_loop_momenta();
+        
+        if(loops.size() > 1)
+          throw exception(ERROR_EXPECTED_ONE_LOOP_RESULT, exception_code::Pk_error);
+    
+        // before taking the product K1*K2 we must relabel indices in K2 if they clash with
+        // K1, otherwise we will get nonsensical results
+        const auto& subs_maps = data.get_substitution_rules();
+        if(subs_maps.size() != 2)
+          throw exception(ERROR_INCORRECT_SUBMAP_SIZE, exception_code::Pk_error);
+    
+        // merge lists of Rayleigh rules together; these depend only on the initial values and
+        // substitution lists, so are shared by all momentum structures
+        GiNaC::exmap Rayleigh_merged;
+        GiNaC_symbol_set reserved{this->k};
+        std::copy(loops.begin(), loops.end(), std::inserter(reserved, reserved.begin()));
+        
+        using detail::merge_Rayleigh_lists;
+        auto Ray_remap1 = merge_Rayleigh_lists(rm1, Rayleigh_merged, reserved, subs_maps[0], this->loc);
+        auto Ray_remap2 = merge_Rayleigh_lists(rm2, Rayleigh_merged, reserved, subs_maps[1], this->loc);
+        
+        using detail::remove_Rayleigh_trivial;
+        auto Rayleigh_triv = remove_Rayleigh_trivial(Rayleigh_merged);
+
+        for(const auto& s1 : S1)
+          {
+            // perform all relabellings
+            auto K1_remap = s1.second.subs(subs_maps[0]).subs(Ray_remap1);
+
+            for(const auto& s2 : S2)
+              {
+                auto K2_remap = s2.second.subs(subs_maps[1]).subs(Ray_remap2);
+        
+                // relabel indices
+                using detail::relabel_index_product;
+                auto K = relabel_index_product(K1_remap, K2_remap, this->loc);
+        
+                K = K.subs(Rayleigh_triv);
+
+                GiNaC::exmap Rayleigh_list = Rayleigh_merged;
+                K = simplify_index(K, dotp, Rayleigh_list, this->loc);
+
+                // prune Rayleigh list to remove momenta that have dropped out
+                using detail::prune_Rayleigh_list;
+                prune_Rayleigh_list(Rayleigh_list, K);
+        
+                if(static_cast<bool>(K != 0))
+                  {
+                    auto elt =
+                      std::make_unique<loop_integral>(tm1*tm2, (s1.first*s2.first).expand(), K,
+                                                      data.get_Wick_string(), loops, GiNaC_symbol_set{this->k},
+                                                      Rayleigh_list, this->loc);
+                    db.emplace(std::move(elt));
+                  }
+              }
+          }
+      }
+  }
+
+
 void Pk_one_loop::simplify(const GiNaC::exmap& map)
   {
     this->Ptree.simplify(map);
@@ -244,6 +497,30 @@ void Pk_one_loop::canonicalize_external_momenta()
   }
 
 
+Pk_one_loop::Pk_one_loop(const checkpoint& ckpt, const std::string& label, service_locator& lc_)
+  : loc(lc_),
+    k(archive_symbol(ckpt.unarchive_ex(label + "/k"))),
+    name(ckpt.get_string(label + "/name")),
+    tag(ckpt.get_string(label + "/tag"))
+  {
+    this->Ptree.restore(ckpt.unarchive_ex(label + "/tree"), this->loc);
+    this->P13.restore(ckpt.unarchive_ex(label + "/13"), this->loc);
+    this->P22.restore(ckpt.unarchive_ex(label + "/22"), this->loc);
+  }
+
+
+void Pk_one_loop::archive(checkpoint& ckpt, const std::string& label) const
+  {
+    ckpt.set_string(label + "/name", this->name);
+    ckpt.set_string(label + "/tag", this->tag);
+
+    ckpt.archive_ex(label + "/k", this->k);
+    ckpt.archive_ex(label + "/tree", this->Ptree.to_archive());
+    ckpt.archive_ex(label + "/13", this->P13.to_archive());
+    ckpt.archive_ex(label + "/22", this->P22.to_archive());
+  }
+
+
 void Pk_one_loop::write(std::ostream& out) const
   {
     out << LABEL_PK << ": '" << this->name << "'" << '\n';
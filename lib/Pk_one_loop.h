@@ -150,6 +150,20 @@ namespace Pk_one_loop_impl
         //! compute UV limit
         GiNaC::ex get_UV_limit(unsigned int order=2) const;
 
+        //! get number of loop integrals
+        size_t size() const { return this->db.size(); }
+
+
+        // CHECKPOINTING
+
+      public:
+
+        //! convert self to an archivable representation, including any reduced integrals
+        GiNaC::ex to_archive() const;
+
+        //! add the loop integrals (and reduced integrals) held in an archived representation
+        void restore(const GiNaC::ex& ar, service_locator& loc);
+
 
         // INTERNAL DATA
 
@@ -190,6 +204,9 @@ class Pk_one_loop
 
     //! copy constructor
     Pk_one_loop(const Pk_one_loop& obj);
+
+    //! constructor restores a power spectrum (including its reduced integrals) from a checkpoint
+    Pk_one_loop(const checkpoint& ckpt, const std::string& label, service_locator& lc_);
     
     //! destructor is default
     ~Pk_one_loop() = default;
@@ -203,6 +220,10 @@ class Pk_one_loop
     //! (assumed to be of a single order, but the algorithm doesn't enforce that)
     template <typename Kernel1, typename Kernel2>
     void cross_product(const Kernel1& ker1, const Kernel2& ker2, Pk_db& db);
+
+    //! construct the loop integrals generated by Wick contraction of a single pair of kernels,
+    //! and emplace them in db
+    void contract_pair(const kernel& ker1, const kernel& ker2, Pk_db& db);
     
     //! build tree power spectrum
     template <typename Kernel1, typename Kernel2>
@@ -269,6 +290,9 @@ class Pk_one_loop
     //! get tag
     const std::string& get_tag() const { return this->tag; }
 
+    //! store self in a checkpoint under the given label
+    void archive(checkpoint& ckpt, const std::string& label) const;
+
 
     // FRIEND DECLARATIONS
 
@@ -353,84 +377,15 @@ Pk_one_loop::Pk_one_loop(std::string n_, std::string t_, const fourier_kernel<N1
 template <typename Kernel1, typename Kernel2>
 void Pk_one_loop::cross_product(const Kernel1& ker1, const Kernel2& ker2, Pk_db& db)
   {
-    // multiply out all terms in ker1 and ker2, using the insertion operator 'ins'
-    // to store the results in a suitable Pk database
-    
+    // multiply out all terms in ker1 and ker2, storing the results in a suitable Pk database.
+    // GiNaC expressions are not safe to share between threads, so this work is always
+    // performed serially; pairs are visited in a fixed order so that symbols minted during
+    // contraction receive the same names on every run
     for(auto t1 = ker1.cbegin(); t1 != ker1.cend(); ++t1)
       {
         for(auto t2 = ker2.cbegin(); t2 != ker2.cend(); ++t2)
           {
-            const auto& tm1 = t1->second->get_time_function();
-            const auto& tm2 = t2->second->get_time_function();
-        
-            const auto& K1 = t1->second->get_kernel();
-            const auto& K2 = t2->second->get_kernel();
-        
-            const auto& iv1 = t1->second->get_initial_value_set();
-            const auto& iv2 = t2->second->get_initial_value_set();
-            
-            const auto& rm1 = t1->second->get_substitution_list();
-            const auto& rm2 = t2->second->get_substitution_list();
-        
-            detail::contractions ctrs(detail::contractions::iv_group<2>{ iv1, iv2 },
-                                      detail::contractions::kext_group<2>{ this->k, -this->k }, this->loc);
-        
-            const auto& Wicks = ctrs.get();
-            for(const auto& W : Wicks)
-              {
-                const auto& data = *W;
-                const auto& loops = data.get_loop_momenta();
-                
-                if(loops.size() > 1)
-                  throw exception(ERROR_EXPECTED_ONE_LOOP_RESULT, exception_code::Pk_error);
-    
-                // before taking the product K1*K2 we must relabel indices in K2 if they clash with
-                // K1, otherwise we will get nonsensical results
-                const auto& subs_maps = data.get_substitution_rules();
-                if(subs_maps.size() != 2)
-                  throw exception(ERROR_INCORRECT_SUBMAP_SIZE, exception_code::Pk_error);
-    
-                // merge lists of Rayleigh rules together
-                GiNaC::exmap Rayleigh_list;
-                GiNaC_symbol_set reserved{k};
-                std::copy(loops.begin(), loops.end(), std::inserter(reserved, reserved.begin()));
-                
-                using detail::merge_Rayleigh_lists;
-                auto Ray_remap1 = merge_Rayleigh_lists(rm1, Rayleigh_list, reserved, subs_maps[0], this->loc);
-                auto Ray_remap2 = merge_Rayleigh_lists(rm2, Rayleigh_list, reserved, subs_maps[1], this->loc);
-                
-                // perform all relabellings
-                auto K1_remap = K1.subs(subs_maps[0]).subs(Ray_remap1);
-                auto K2_remap = K2.subs(subs_maps[1]).subs(Ray_remap2);
-                
-                // relabel indices
-                using detail::relabel_index_product;
-                auto K = relabel_index_product(K1_remap, K2_remap, this->loc);
-                
-                using detail::remove_Rayleigh_trivial;
-                auto Rayleigh_triv = remove_Rayleigh_trivial(Rayleigh_list);
-                K = K.subs(Rayleigh_triv);
-                
-                // simplify dot products where possible
-                GiNaC::scalar_products dotp;
-                dotp.add(this->k, this->k, this->k*this->k);
-                // k.l, l.l and other inner products are supposed to be picked up later by
-                // loop integral transformations
-
-                K = simplify_index(K, dotp, Rayleigh_list, this->loc);
-
-                // prune Rayleigh list to remove momenta that have dropped out
-                using detail::prune_Rayleigh_list;
-                prune_Rayleigh_list(Rayleigh_list, K);
-                
-                if(static_cast<bool>(K != 0))
-                  {
-                    auto elt =
-                      std::make_unique<loop_integral>(tm1*tm2, K, data.get_Wick_string(), loops,
-                                                      GiNaC_symbol_set{this->k}, Rayleigh_list, this->loc);
-                    db.emplace(std::move(elt));
-                  }
-              }
+            this->contract_pair(*t1->second, *t2->second, db);
           }
       }
   }
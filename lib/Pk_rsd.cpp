@@ -25,6 +25,8 @@
 //
 
 #include <algorithm>
+#include <iterator>
+#include <sstream>
 
 #include "Pk_rsd.h"
 
@@ -74,6 +76,9 @@ void Pk_rsd_group::emplace(const one_loop_element& elt)
         // kill any remaining symbols (eg. if we are looking for the term linear in b1 we don't get b1 b2 contributions)
         f->simplify(this->filter_map);
 
+        // the coefficient is now free of filter symbols, so fold it into the integrand
+        f->absorb_coefficient();
+
         // filter for power of mu
         f->filter(this->mu, order);
 
@@ -88,6 +93,22 @@ void Pk_rsd_group::emplace(const one_loop_element& elt)
   }
 
 
+void Pk_rsd_group::emplace(std::unique_ptr<one_loop_element> elt, unsigned int mu_power)
+  {
+    switch(mu_power)
+      {
+        case 0: this->emplace(std::move(elt), this->mu0, 0); break;
+        case 2: this->emplace(std::move(elt), this->mu2, 2); break;
+        case 4: this->emplace(std::move(elt), this->mu4, 4); break;
+        case 6: this->emplace(std::move(elt), this->mu6, 6); break;
+        case 8: this->emplace(std::move(elt), this->mu8, 8); break;
+
+        // other powers of mu do not occur at one-loop, and are discarded (as in the filtering path)
+        default: break;
+      }
+  }
+
+
 GiNaC::exvector Pk_rsd_group::get_UV_limit(unsigned int order) const
   {
     GiNaC::exvector values;
@@ -154,6 +175,12 @@ std::vector< std::vector<time_function> > Pk_rsd_group::get_time_functions() con
   }
 
 
+std::array<size_t, 5> Pk_rsd_group::get_element_counts() const
+  {
+    return { this->mu0.size(), this->mu2.size(), this->mu4.size(), this->mu6.size(), this->mu8.size() };
+  }
+
+
 void Pk_rsd_group::prune()
   {
     this->prune(this->mu0, 0);
@@ -219,6 +246,44 @@ void Pk_rsd_group::emplace(std::unique_ptr<one_loop_element> elt, one_loop_eleme
   }
 
 
+GiNaC::ex Pk_rsd_group::to_archive() const
+  {
+    // archived form is a list of the elements at mu^0, mu^2, ..., mu^8
+    auto archive_db = [](const one_loop_element_db& db) -> GiNaC::ex
+      {
+        GiNaC::lst list;
+        for(const auto& record : db)
+          {
+            if(record.second) list.append(record.second->to_archive());
+          }
+        return list;
+      };
+
+    GiNaC::lst data;
+    data.append(archive_db(this->mu0));
+    data.append(archive_db(this->mu2));
+    data.append(archive_db(this->mu4));
+    data.append(archive_db(this->mu6));
+    data.append(archive_db(this->mu8));
+
+    return data;
+  }
+
+
+void Pk_rsd_group::restore(const GiNaC::ex& ar, service_locator& loc)
+  {
+    const auto& data = archive_list(ar, 5);
+
+    for(unsigned int i = 0; i < 5; ++i)
+      {
+        for(const auto& item : archive_list(data.op(i)))
+          {
+            this->emplace(std::make_unique<one_loop_element>(item, loc), 2*i);
+          }
+      }
+  }
+
+
 void Pk_rsd_group::write_Mathematica(std::ostream& out, std::string symbol, bool do_dx) const
   {
     this->write_Mathematica_block(out, this->mu0, symbol, "mu0", do_dx);
@@ -258,6 +323,20 @@ void Pk_rsd_group::write_Mathematica_block(std::ostream& out, const one_loop_ele
 
 Pk_rsd::Pk_rsd(const Pk_one_loop& Pk, const GiNaC::symbol& mu_,
                const filter_list pt_, const GiNaC_symbol_set sy_, bool v)
+  : Pk_rsd(Pk.get_tag(), mu_, pt_, sy_, v)
+  {
+    // filter elements (term by term) from parent Pk_one_loop according to whether they match
+    // the specific symbol set
+    this->filter(Ptree, Pk.get_tree());
+    this->filter(P13, Pk.get_13());
+    this->filter(P22, Pk.get_22());
+
+    this->finalize();
+  }
+
+
+Pk_rsd::Pk_rsd(const std::string& tg_, const GiNaC::symbol& mu_,
+               const filter_list pt_, const GiNaC_symbol_set sy_, bool v)
   : mu(mu_),
     pattern(pt_),
     Ptree(mu_, pt_, sy_, std::string{"tree"}, v),
@@ -267,7 +346,7 @@ Pk_rsd::Pk_rsd(const Pk_one_loop& Pk, const GiNaC::symbol& mu_,
   {
     // build tag from filter list
     std::ostringstream tag_str;
-    tag_str << Pk.get_tag();
+    tag_str << tg_;
 
     for(const auto& sym : pt_)
       {
@@ -289,13 +368,11 @@ Pk_rsd::Pk_rsd(const Pk_one_loop& Pk, const GiNaC::symbol& mu_,
       {
         symbolic_filter *= GiNaC::pow(item.first, item.second);
       }
+  }
 
-    // filter elements (term by term) from parent Pk_one_loop according to whether they match
-    // the specific symbol set
-    this->filter(Ptree, Pk.get_tree());
-    this->filter(P13, Pk.get_13());
-    this->filter(P22, Pk.get_22());
 
+void Pk_rsd::finalize()
+  {
     // remove empty records
     this->Ptree.prune();
     this->P13.prune();
@@ -357,6 +434,424 @@ void Pk_rsd::write_Mathematica(std::ostream& out) const
   }
 
 
+void Pk_rsd::archive(checkpoint& ckpt, const std::string& label) const
+  {
+    GiNaC::lst pat;
+    for(const auto& item : this->pattern)
+      {
+        GiNaC::lst term;
+        term.append(item.first);
+        term.append(item.second);
+
+        pat.append(term);
+      }
+
+    ckpt.archive_ex(label + "/pattern", pat);
+    ckpt.archive_ex(label + "/tree", this->Ptree.to_archive());
+    ckpt.archive_ex(label + "/13", this->P13.to_archive());
+    ckpt.archive_ex(label + "/22", this->P22.to_archive());
+  }
+
+
+Pk_rsd_set_builder::Pk_rsd_set_builder(const Pk_one_loop& Pk, GiNaC::symbol mu_, GiNaC_symbol_set sy_, bool v)
+  : tag(Pk.get_tag()),
+    mu(std::move(mu_)),
+    bias_symbols(std::move(sy_)),
+    verbose(v),
+    restored(false)
+  {
+    for(const auto& sym : this->bias_symbols)
+      {
+        this->zero_map[sym] = 0;
+      }
+
+    // decompose every element once; individual filters are populated from these decompositions
+    this->decompose(Pk.get_tree(), group_type::tree);
+    this->decompose(Pk.get_13(), group_type::P13);
+    this->decompose(Pk.get_22(), group_type::P22);
+  }
+
+
+Pk_rsd_set_builder::Pk_rsd_set_builder(const checkpoint& ckpt, const std::string& label, service_locator& loc)
+  : tag(ckpt.get_string(label + "/tag")),
+    mu(archive_symbol(ckpt.unarchive_ex(label + "/mu"))),
+    bias_symbols(restore_symbol_set(ckpt.unarchive_ex(label + "/bias_symbols"))),
+    verbose(false),
+    restored(true)
+  {
+    for(const auto& sym : this->bias_symbols)
+      {
+        this->zero_map[sym] = 0;
+      }
+
+    std::istringstream names{ckpt.get_string(label + "/names")};
+    std::string name;
+
+    while(std::getline(names, name))
+      {
+        if(name.empty()) continue;
+
+        const std::string root = label + "/" + name;
+
+        // rebuild filter pattern
+        const auto ar = ckpt.unarchive_ex(root + "/pattern");
+
+        filter_list pattern;
+        for(const auto& item : archive_list(ar))
+          {
+            const auto& term = archive_list(item, 2);
+            if(!GiNaC::is_a<GiNaC::numeric>(term.op(1)))
+              throw exception(ERROR_CHECKPOINT_UNEXPECTED_FORM, exception_code::checkpoint_error);
+
+            pattern.emplace_back(archive_symbol(term.op(0)), GiNaC::ex_to<GiNaC::numeric>(term.op(1)).to_int());
+          }
+
+        // Pk_rsd's populating constructor is accessible only to friends, so std::make_unique can't be used
+        std::unique_ptr<Pk_rsd> rsd{new Pk_rsd(this->tag, this->mu, pattern, this->bias_symbols, this->verbose)};
+
+        rsd->Ptree.restore(ckpt.unarchive_ex(root + "/tree"), loc);
+        rsd->P13.restore(ckpt.unarchive_ex(root + "/13"), loc);
+        rsd->P22.restore(ckpt.unarchive_ex(root + "/22"), loc);
+
+        this->requested.insert(this->to_monomial(pattern));
+        this->Pks.emplace(name, std::move(rsd));
+      }
+  }
+
+
+void Pk_rsd_set_builder::archive(checkpoint& ckpt, const std::string& label) const
+  {
+    ckpt.set_string(label + "/tag", this->tag);
+    ckpt.archive_ex(label + "/mu", this->mu);
+    ckpt.archive_ex(label + "/bias_symbols", archive_symbol_set(this->bias_symbols));
+
+    std::string names;
+    for(const auto& item : this->Pks)
+      {
+        if(!names.empty()) names += '\n';
+        names += item.first;
+
+        item.second->archive(ckpt, label + "/" + item.first);
+      }
+
+    ckpt.set_string(label + "/names", names);
+  }
+
+
+void Pk_rsd_set_builder::decompose(const Pk_one_loop_impl::Pk_db& db, group_type group)
+  {
+    for(const auto& item : db)
+      {
+        const std::unique_ptr<one_loop_reduced_integral>& ri = item.second.second;
+
+        if(!ri) continue;    // skip if pointer is empty
+
+        for(const auto& record : ri->get_db())
+          {
+            const std::unique_ptr<one_loop_element>& elt = record.second;
+            if(!elt) continue;
+
+            auto terms = this->decompose(*elt);
+            if(!terms.empty()) this->records.push_back(decomposition_record{group, *elt, std::move(terms)});
+          }
+      }
+  }
+
+
+Pk_rsd_set_builder::element_decomposition Pk_rsd_set_builder::decompose(const one_loop_element& elt) const
+  {
+    const auto& coefficient = elt.get_coefficient();
+    const auto& integrand = elt.get_integrand();
+
+    element_decomposition result;
+
+    // bias symbols are normally carried in the coefficient, leaving an integrand which is free of them
+    bool mixed = false;
+    for(const auto& sym : this->bias_symbols)
+      {
+        if(integrand.has(sym)) { mixed = true; break; }
+      }
+
+    // if the integrand does involve bias symbols, decompose the full product term by term
+    if(mixed)
+      {
+        auto polys = this->collect_monomials(coefficient * integrand);
+
+        for(auto& item : polys)
+          {
+            auto poly = item.second.expand();
+            if(poly.is_zero()) continue;
+
+            mu_coefficients coeffs;
+            bool nonzero = false;
+
+            for(unsigned int i = 0; i < coeffs.size(); ++i)
+              {
+                coeffs[i] = poly.coeff(this->mu, 2*i);
+                if(!coeffs[i].is_zero()) nonzero = true;
+              }
+
+            if(nonzero) result.emplace(item.first, std::move(coeffs));
+          }
+
+        return result;
+      }
+
+    // otherwise, split the integrand into powers of mu once, and scale by the coefficient of each bias monomial
+    auto polys = this->collect_monomials(coefficient);
+    if(polys.empty()) return result;
+
+    auto expr = integrand.expand();
+
+    mu_coefficients base;
+    bool nonzero = false;
+
+    for(unsigned int i = 0; i < base.size(); ++i)
+      {
+        base[i] = expr.coeff(this->mu, 2*i);
+        if(!base[i].is_zero()) nonzero = true;
+      }
+
+    if(!nonzero) return result;
+
+    for(auto& item : polys)
+      {
+        auto c = item.second.expand();
+        if(c.is_zero()) continue;
+
+        mu_coefficients coeffs;
+        for(unsigned int i = 0; i < coeffs.size(); ++i)
+          {
+            coeffs[i] = base[i].is_zero() ? base[i] : c * base[i];
+          }
+
+        result.emplace(item.first, std::move(coeffs));
+      }
+
+    return result;
+  }
+
+
+std::map< Pk_rsd_set_builder::bias_monomial, GiNaC::ex >
+Pk_rsd_set_builder::collect_monomials(const GiNaC::ex& expr) const
+  {
+    // collect terms by bias monomial; the expression is expanded only once
+    std::map< bias_monomial, GiNaC::ex > polys;
+
+    auto process = [&](const GiNaC::ex& term) -> void
+      {
+        bias_monomial m(this->bias_symbols.size(), 0);
+        GiNaC::ex rest{1};
+        bool zero_rest = false;
+
+        auto index = [&](const GiNaC::ex& s) -> size_t
+          {
+            if(!GiNaC::is_a<GiNaC::symbol>(s)) return this->bias_symbols.size();
+
+            auto t = this->bias_symbols.find(GiNaC::ex_to<GiNaC::symbol>(s));
+            return static_cast<size_t>(std::distance(this->bias_symbols.begin(), t));
+          };
+
+        auto visit = [&](const GiNaC::ex& f) -> void
+          {
+            // bias symbols appearing polynomially contribute to the monomial
+            if(GiNaC::is_a<GiNaC::symbol>(f))
+              {
+                auto i = index(f);
+                if(i < m.size()) { m[i] += 1; return; }
+              }
+            else if(GiNaC::is_a<GiNaC::power>(f) && f.op(1).info(GiNaC::info_flags::posint))
+              {
+                auto i = index(f.op(0));
+                if(i < m.size()) { m[i] += static_cast<unsigned int>(GiNaC::ex_to<GiNaC::numeric>(f.op(1)).to_int()); return; }
+              }
+
+            // bias symbols appearing in any other way are invisible to coeff(), and would be set to zero
+            // by the filter map; do the same here
+            if(!zero_rest)
+              {
+                for(const auto& sym : this->bias_symbols)
+                  {
+                    if(f.has(sym)) { zero_rest = true; break; }
+                  }
+              }
+
+            rest *= f;
+          };
+
+        if(GiNaC::is_exactly_a<GiNaC::mul>(term))
+          {
+            for(size_t i = 0; i < term.nops(); ++i)
+              {
+                visit(term.op(i));
+              }
+          }
+        else
+          {
+            visit(term);
+          }
+
+        if(zero_rest) rest = rest.subs(this->zero_map);
+        if(rest.is_zero()) return;
+
+        polys[m] += rest;
+      };
+
+    auto e = expr.expand();
+
+    if(GiNaC::is_exactly_a<GiNaC::add>(e))
+      {
+        for(size_t i = 0; i < e.nops(); ++i)
+          {
+            process(e.op(i));
+          }
+      }
+    else
+      {
+        process(e);
+      }
+
+    return polys;
+  }
+
+
+Pk_rsd_set_builder::bias_monomial Pk_rsd_set_builder::to_monomial(const filter_list& pattern) const
+  {
+    bias_monomial m(this->bias_symbols.size(), 0);
+
+    for(const auto& item : pattern)
+      {
+        auto t = this->bias_symbols.find(item.first);
+        if(t == this->bias_symbols.end())
+          {
+            std::ostringstream msg;
+            msg << ERROR_PK_RSD_FILTER_SYMBOL_NOT_BIAS << " '" << item.first << "'";
+            throw exception(msg.str(), exception_code::Pk_error);
+          }
+
+        m[std::distance(this->bias_symbols.begin(), t)] += item.second;
+      }
+
+    return m;
+  }
+
+
+filter_list Pk_rsd_set_builder::to_pattern(const bias_monomial& m) const
+  {
+    filter_list pattern;
+
+    auto t = this->bias_symbols.begin();
+    for(unsigned int i = 0; i < m.size(); ++i, ++t)
+      {
+        if(m[i] > 0) pattern.emplace_back(*t, m[i]);
+      }
+
+    return pattern;
+  }
+
+
+Pk_rsd_set_builder& Pk_rsd_set_builder::add(std::string name, filter_list pattern)
+  {
+    if(this->restored) throw exception(ERROR_PK_RSD_BUILDER_RESTORED, exception_code::Pk_error);
+
+    if(this->Pks.find(name) != this->Pks.end())
+      {
+        std::ostringstream msg;
+        msg << ERROR_PK_RSD_FILTER_ALREADY_REQUESTED_A << " '" << name << "' " << ERROR_PK_RSD_FILTER_ALREADY_REQUESTED_B;
+        throw exception(msg.str(), exception_code::Pk_error);
+      }
+
+    auto m = this->to_monomial(pattern);
+    this->populate(std::move(name), m, std::move(pattern));
+    this->requested.insert(std::move(m));
+
+    return *this;
+  }
+
+
+Pk_rsd_set_builder& Pk_rsd_set_builder::add_nonzero_monomials()
+  {
+    std::set<bias_monomial> found;
+
+    for(const auto& record : this->records)
+      {
+        for(const auto& item : record.terms)
+          {
+            if(this->requested.find(item.first) == this->requested.end()) found.insert(item.first);
+          }
+      }
+
+    for(const auto& m : found)
+      {
+        // build name from symbol names, eg. b1_1 b2_2 -> "b1_1_b2_2"; the monomial with no bias symbols is "nobias"
+        std::string name;
+
+        auto t = this->bias_symbols.begin();
+        for(unsigned int i = 0; i < m.size(); ++i, ++t)
+          {
+            for(unsigned int j = 0; j < m[i]; ++j)
+              {
+                if(!name.empty()) name += "_";
+                name += t->get_name();
+              }
+          }
+
+        if(name.empty()) name = "nobias";
+
+        this->add(std::move(name), this->to_pattern(m));
+      }
+
+    return *this;
+  }
+
+
+void Pk_rsd_set_builder::populate(std::string name, const bias_monomial& m, filter_list pattern)
+  {
+    // Pk_rsd's populating constructor is accessible only to friends, so std::make_unique can't be used
+    std::unique_ptr<Pk_rsd> rsd{new Pk_rsd(this->tag, this->mu, std::move(pattern), this->bias_symbols, this->verbose)};
+
+    for(const auto& record : this->records)
+      {
+        auto t = record.terms.find(m);
+        if(t == record.terms.end()) continue;
+
+        Pk_rsd_group& dest = record.group == group_type::tree ? rsd->Ptree
+                                                              : (record.group == group_type::P13 ? rsd->P13 : rsd->P22);
+
+        const mu_coefficients& coeffs = t->second;
+        for(unsigned int i = 0; i < coeffs.size(); ++i)
+          {
+            if(coeffs[i].is_zero()) continue;
+
+            // copy element and replace its integrand with the appropriate coefficient, which already
+            // includes the element's own coefficient; bias symbols are set to zero elsewhere, as in the filtering path
+            auto f = std::make_unique<one_loop_element>(record.elt);
+            f->set_integrand(coeffs[i]);
+            f->set_coefficient(1);
+            f->simplify(this->zero_map);
+
+            dest.emplace(std::move(f), 2*i);
+          }
+      }
+
+    rsd->finalize();
+    this->Pks.emplace(std::move(name), std::move(rsd));
+  }
+
+
+Pk_rsd_set Pk_rsd_set_builder::get() const
+  {
+    Pk_rsd_set set;
+
+    for(const auto& item : this->Pks)
+      {
+        set.emplace(item.first, std::ref(*item.second));
+      }
+
+    return set;
+  }
+
+
 std::ostream& operator<<(std::ostream& str, const Pk_rsd& obj)
   {
     obj.write(str);
@@ -30,6 +30,11 @@
 
 #include <iostream>
 #include <set>
+#include <map>
+#include <array>
+#include <vector>
+#include <memory>
+#include <functional>
 
 #include "Pk_one_loop.h"
 
@@ -64,6 +69,9 @@ class Pk_rsd_group
     //! accepts a one_loop_element and breaks it into individual powers of mu
     void emplace(const one_loop_element& elt);
 
+    //! accepts a one_loop_element which has already been filtered, and stores it with the specified power of mu
+    void emplace(std::unique_ptr<one_loop_element> elt, unsigned int mu_power);
+
   protected:
 
     //! perform emplace on a specific database (ie. the database for mu0, mu2, ...)
@@ -80,6 +88,9 @@ class Pk_rsd_group
     //! query number of distinct time functions at each mu
     std::vector< std::vector<time_function> > get_time_functions() const;
 
+    //! query number of elements at each mu (mu^0, mu^2, ..., mu^8)
+    std::array<size_t, 5> get_element_counts() const;
+
     //! prune empty records from the database
     void prune();
 
@@ -107,6 +118,17 @@ class Pk_rsd_group
     template <typename VisitorFunction>
     void visit(visit_list pattern, VisitorFunction f) const;
 
+
+    // CHECKPOINTING
+
+  public:
+
+    //! convert self to an archivable representation
+    GiNaC::ex to_archive() const;
+
+    //! add the elements held in an archived representation
+    void restore(const GiNaC::ex& ar, service_locator& loc);
+
   private:
 
     //! write Mathematica script for a specific mu database
@@ -190,6 +212,10 @@ void Pk_rsd_group::visit(visit_list pattern, VisitorFunction f) const
   }
 
 
+//! forward-declare Pk_rsd_set_builder
+class Pk_rsd_set_builder;
+
+
 class Pk_rsd
   {
 
@@ -205,6 +231,12 @@ class Pk_rsd
     //! destructor is default
     ~Pk_rsd() = default;
 
+  protected:
+
+    //! constructor builds an empty decomposition, to be populated by Pk_rsd_set_builder
+    Pk_rsd(const std::string& tg_, const GiNaC::symbol& mu_, const filter_list pt_, const GiNaC_symbol_set sy_,
+           bool v);
+
 
     // INTERNAL API
 
@@ -213,6 +245,9 @@ class Pk_rsd
     //! filter a Pk_db into a destination Pk_rsd_group
     void filter(Pk_rsd_group& dest, const Pk_one_loop_impl::Pk_db& source);
 
+    //! prune empty records once all contributions have been added, and warn if nothing remains
+    void finalize();
+
 
     // ACCESSORS
 
@@ -238,6 +273,9 @@ class Pk_rsd
     //! write Mathematica script for 13 and 22 integrals at each power of mu
     void write_Mathematica(std::ostream& out) const;
 
+    //! store self in a checkpoint under the given label
+    void archive(checkpoint& ckpt, const std::string& label) const;
+
 
     // INTERNAL DATA
 
@@ -270,6 +308,9 @@ class Pk_rsd
     //! 22 contributions
     Pk_rsd_group P22;
 
+
+    friend class Pk_rsd_set_builder;
+
   };
 
 
@@ -277,4 +318,138 @@ class Pk_rsd
 std::ostream& operator<<(std::ostream& str, const Pk_rsd& obj);
 
 
+//! a Pk_rsd_set is a named collection of Pk_rsd decompositions
+using Pk_rsd_set = std::map< std::string, std::reference_wrapper<Pk_rsd> >;
+
+
+//! Pk_rsd_set_builder decomposes a Pk_one_loop into many Pk_rsd filters in a single pass.
+//! Each one_loop_element is expanded once into a sparse polynomial in the bias symbols and mu,
+//! and its coefficients are scattered into every requested filter. Bias monomials are read from
+//! the element's coefficient, so its integrand is split into powers of mu only once.
+//! Optionally, all bias monomials with nonzero coefficients can be discovered automatically
+class Pk_rsd_set_builder
+  {
+
+    // TYPES
+
+  protected:
+
+    //! a bias monomial is represented by its list of exponents, in the order of the bias symbol set
+    using bias_monomial = std::vector<unsigned int>;
+
+    //! coefficients of mu^0, mu^2, ..., mu^8
+    using mu_coefficients = std::array<GiNaC::ex, 5>;
+
+    //! sparse decomposition of a single one_loop_element
+    using element_decomposition = std::map< bias_monomial, mu_coefficients >;
+
+    //! identifies which group (tree, 13, 22) an element belongs to
+    enum class group_type { tree, P13, P22 };
+
+    //! record of a decomposed element
+    struct decomposition_record
+      {
+        //! group
+        group_type group;
+
+        //! reference to source element
+        const one_loop_element& elt;
+
+        //! decomposition
+        element_decomposition terms;
+      };
+
+
+    // CONSTRUCTOR, DESTRUCTOR
+
+  public:
+
+    //! constructor captures the Pk_one_loop to be decomposed, the angular variable mu and the
+    //! set of bias symbols. The Pk_one_loop should not be modified while the builder is in use
+    Pk_rsd_set_builder(const Pk_one_loop& Pk, GiNaC::symbol mu_, GiNaC_symbol_set sy_, bool v=false);
+
+    //! constructor restores a set of decompositions from a checkpoint. The restored builder holds
+    //! no source power spectrum, so further filters cannot be requested
+    Pk_rsd_set_builder(const checkpoint& ckpt, const std::string& label, service_locator& loc);
+
+    //! destructor is default
+    ~Pk_rsd_set_builder() = default;
+
+
+    // INTERFACE
+
+  public:
+
+    //! request a named filter pattern
+    Pk_rsd_set_builder& add(std::string name, filter_list pattern);
+
+    //! request a filter for every bias monomial with a nonzero coefficient which has not
+    //! already been requested; names are generated from the symbol names
+    Pk_rsd_set_builder& add_nonzero_monomials();
+
+    //! get set of decompositions; these are owned by the builder and remain valid for its lifetime
+    Pk_rsd_set get() const;
+
+    //! store the set of decompositions in a checkpoint under the given label
+    void archive(checkpoint& ckpt, const std::string& label) const;
+
+
+    // INTERNAL API
+
+  protected:
+
+    //! decompose all elements of a Pk_db
+    void decompose(const Pk_one_loop_impl::Pk_db& db, group_type group);
+
+    //! decompose a single element into a sparse polynomial in the bias symbols and mu
+    element_decomposition decompose(const one_loop_element& elt) const;
+
+    //! collect the terms of an expression by bias monomial
+    std::map< bias_monomial, GiNaC::ex > collect_monomials(const GiNaC::ex& expr) const;
+
+    //! convert a filter pattern to a bias monomial
+    bias_monomial to_monomial(const filter_list& pattern) const;
+
+    //! convert a bias monomial to a filter pattern
+    filter_list to_pattern(const bias_monomial& m) const;
+
+    //! build a new Pk_rsd for a bias monomial, and populate it from the decomposition
+    void populate(std::string name, const bias_monomial& m, filter_list pattern);
+
+
+    // INTERNAL DATA
+
+  private:
+
+    //! cache tag of parent power spectrum
+    const std::string tag;
+
+    //! cache angular variable mu
+    const GiNaC::symbol mu;
+
+    //! set of bias symbols
+    const GiNaC_symbol_set bias_symbols;
+
+    //! substitution map setting all bias symbols to zero; used for bias symbols which appear
+    //! in non-polynomial factors
+    GiNaC::exmap zero_map;
+
+    //! verbose flag
+    bool verbose;
+
+    //! decompositions of all elements
+    std::vector<decomposition_record> records;
+
+    //! constructed Pk_rsd objects, indexed by name
+    std::map< std::string, std::unique_ptr<Pk_rsd> > Pks;
+
+    //! set of monomials which have been requested
+    std::set<bias_monomial> requested;
+
+    //! was this builder restored from a checkpoint?
+    bool restored;
+
+  };
+
+
 #endif //LSSEFT_ANALYTIC_PK_RSD_H
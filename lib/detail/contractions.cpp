@@ -24,6 +24,10 @@
 // --@@
 //
 
+#include <numeric>
+#include <algorithm>
+#include <list>
+
 #include "contractions.h"
 
 
@@ -60,137 +64,235 @@ namespace cfs
 namespace detail
   {
 
-    size_t double_factorial(size_t N)
+    namespace contractions_impl
       {
-        size_t x = 1;
-        for(size_t i = N; i > 1; i -= 2)
+
+        //! cluster_partition is a union-find structure that tracks which clusters have been joined by
+        //! Wick contractions, and how many fields in each group of joined clusters remain unpaired.
+        //! If a group is exhausted while more than one group remains, the Wick graph is certain to be
+        //! disconnected and the pairing can be abandoned
+        class cluster_partition
           {
-            x *= i;
-          }
 
-        return x;
-      }
+            // CONSTRUCTOR, DESTRUCTOR
 
+          public:
 
-    std::unique_ptr<contractions::contraction_set>
-    contractions::enumerate_contractions(size_t num, const iv_list& ivs) const
-      {
-        using detail::graph;
+            //! constructor accepts number of fields in each cluster; clusters containing no fields
+            //! do not participate in the Wick graph
+            explicit cluster_partition(const std::vector<size_t>& sizes)
+              : parent(sizes.size()),
+                open(sizes),
+                groups(0)
+              {
+                for(size_t i = 0; i < sizes.size(); ++i)
+                  {
+                    this->parent[i] = i;
+                    if(sizes[i] > 0) ++this->groups;
+                  }
+              }
 
-        // allocate a unique_ptr for the contraction set
-        auto ctrs = std::make_unique<contraction_set>();
+            //! destructor is default
+            ~cluster_partition() = default;
 
-        // compute number of possible contractions = (N-1)!! where N is the size of the set
-        size_t num_contractions = double_factorial(num-1);
 
-        // work through total number of contractions, building up the pairings associated with each item
-        for(size_t i = 0; i < num_contractions; ++i)
-          {
-            // allocate storage for this contraction group
-            auto group = std::make_unique<contraction_group>();
+            // INTERFACE
+
+          public:
+
+            //! record a contraction between fields in clusters a and b;
+            //! returns false if this guarantees the graph will be disconnected
+            bool contract(size_t a, size_t b)
+              {
+                auto ra = this->find(a);
+                auto rb = this->find(b);
 
-            // copy list of fields participating in the Wick product,
-            // which will be used to populate the contraction elements
-            auto ivs_copy = ivs;
+                if(ra != rb)
+                  {
+                    this->parent[rb] = ra;
+                    this->open[ra] += this->open[rb];
+                    --this->groups;
+                  }
+
+                this->open[ra] -= 2;
+
+                return this->open[ra] > 0 || this->groups == 1;
+              }
 
-            // use an edge database to represent the Feynman graph we are effectively setting up;
-            // we'll need to know whether it is connected
-            graph G;
+            //! determine whether all participating clusters have been joined
+            bool is_connected() const { return this->groups == 1; }
 
-            // divisor keeps track of numerical factor needed to strip out next term in the double factorial
-            size_t divisor = num_contractions;
-            size_t v = i;
 
-            for(size_t j = num - 1; j >= 1; j -= 2)
+            // INTERNAL API
+
+          protected:
+
+            //! find the representative of a cluster
+            size_t find(size_t c) const
               {
-                divisor /= j;
+                while(this->parent[c] != c) c = this->parent[c];
+                return c;
+              }
+
 
-                // compute which element we're going to pair with the first element remaining in ivs_copy;
-                // note the +1, because we start counting from the *second* element in ivs_copy
-                auto pair_elt = v / divisor + 1;
+            // INTERNAL DATA
 
-                // update for next pairing
-                v = v % divisor;
+          private:
 
-                // extract iv_element objects for each end of the pairing
-                const auto& p1 = ivs_copy[0];
-                const auto& p2 = ivs_copy[pair_elt];
+            //! parent of each cluster
+            std::vector<size_t> parent;
 
-                // add an edge from p1 to p2
-                G.add_edge(p1.second, p2.second);
+            //! number of unpaired fields in the group represented by each cluster
+            std::vector<size_t> open;
 
-                // store this pairing
-                group->emplace_back(p1, p2);
+            //! number of disjoint groups
+            size_t groups;
 
-                // remove this pair of fields from ivs_copy, ready for next contraction
-                ivs_copy.erase(ivs_copy.begin() + pair_elt);
-                ivs_copy.erase(ivs_copy.begin());
+          };
 
-                // manually break out of for-loop if j=1; subtracting two will wrap around since
-                // j is unsigned
-                if(j == 1) break;
+
+        //! recursively pair the first remaining field with each other remaining field,
+        //! abandoning a branch as soon as it is certain to produce a disconnected graph
+        template <typename PairingContainer>
+        void enumerate_pairings(const std::vector<size_t>& cluster_of, const std::vector<size_t>& remaining,
+                                const cluster_partition& P, std::vector< std::pair<size_t, size_t> >& current,
+                                PairingContainer& dest)
+          {
+            if(remaining.empty())
+              {
+                if(P.is_connected()) dest.push_back(current);
+                return;
               }
 
-            // if the graph we built was connected, store this contraction group
-            if(G.is_connected()) ctrs->push_back(std::move(group));
+            const auto first = remaining[0];
+
+            for(size_t k = 1; k < remaining.size(); ++k)
+              {
+                const auto second = remaining[k];
+
+                auto Q = P;
+                if(!Q.contract(cluster_of[first], cluster_of[second])) continue;
+
+                std::vector<size_t> rest;
+                rest.reserve(remaining.size() - 2);
+                for(size_t m = 1; m < remaining.size(); ++m)
+                  {
+                    if(m != k) rest.push_back(remaining[m]);
+                  }
+
+                current.emplace_back(first, second);
+                enumerate_pairings(cluster_of, rest, Q, current, dest);
+                current.pop_back();
+              }
           }
 
-        return ctrs;
-      }
+      }   // namespace contractions_impl
 
 
-    void graph::add_edge(size_t source, size_t dest)
+    std::unique_ptr<contractions::template_set>
+    contractions::build_templates(const cluster_signature& sig)
       {
-        // insert source and destination vertices if they have not already been encountered
-        this->vertices.insert(source);
-        this->vertices.insert(dest);
+        using contractions_impl::cluster_partition;
+        using contractions_impl::enumerate_pairings;
 
-        // insert source -> dest edge
-        auto& dest_set = this->edges[source];
-        dest_set.insert(dest);
-      }
+        // label each field by the cluster from which it comes, in the same order used to build
+        // the list of initial value items
+        std::vector<size_t> cluster_of;
+        for(size_t i = 0; i < sig.size(); ++i)
+          {
+            cluster_of.insert(cluster_of.end(), sig[i], i);
+          }
 
+        const size_t num = cluster_of.size();
 
-    template <typename EdgeContainer, typename VertexContainer>
-    void visit_all(const EdgeContainer& es, VertexContainer& vs, size_t v)
-      {
-        // if vs is already empty, return; we have already visited all nodes,
-        // so there is no need to carry on
-        if(vs.empty()) return;
+        std::vector<size_t> remaining(num);
+        std::iota(remaining.begin(), remaining.end(), 0);
 
-        // remove vertex v from the container; this means we cannot recurse infinitely if the
-        // graph contains a cycle
-        auto t = vs.find(v);
-        if(t == vs.end()) return;
+        // enumerate connected pairings
+        std::vector<abstract_pairing> pairings;
+        abstract_pairing current;
+        enumerate_pairings(cluster_of, remaining, cluster_partition{sig}, current, pairings);
 
-        vs.erase(t);
+        // count number of clusters containing fields
+        size_t clusters = std::count_if(sig.begin(), sig.end(), [](size_t n) -> bool { return n > 0; });
 
-        // find vertices that can be reached from this source; return if there are none -- this is a leaf node
-        auto u = es.find(v);
-        if(u == es.end()) return;
+        auto tmpls = std::make_unique<template_set>();
+        tmpls->reserve(pairings.size());
 
-        for(const auto& d : u->second)
+        for(auto& pairs : pairings)
           {
-            visit_all(es, vs, d);
+            contraction_template tmpl;
+
+            // there are #fields independent momentum integrals
+            // each contraction generates one momentum-conservation delta function
+            // there are also #clusters momentum-conservation delta functions, one for each cluster
+            // finally, one of these delta functions factorizes out to give global conservation of momentum
+
+            // so, the number of unconstrained momentum integrations is
+            // #fields - #clusters - #contractions + 1
+            size_t loop_order = num - clusters - pairs.size() + 1;
+
+            // track the number of momentum labels remaining unassigned in each cluster
+            auto unassigned = sig;
+
+            // a contraction can carry a loop momentum only if neither end is the last unassigned
+            // momentum in its cluster; otherwise, it must communicate with an external momentum
+            std::list<size_t> candidates(pairs.size());
+            std::iota(candidates.begin(), candidates.end(), 0);
+
+            auto is_candidate = [&](size_t c) -> bool
+              {
+                return unassigned[cluster_of[pairs[c].first]] > 1 && unassigned[cluster_of[pairs[c].second]] > 1;
+              };
+
+            for(size_t i = 0; i < loop_order; ++i)
+              {
+                auto t = std::find_if(candidates.begin(), candidates.end(), is_candidate);
+
+                if(t == candidates.end())
+                  throw exception(ERROR_COULD_NOT_ASSIGN_LOOP_MOMENTUM, exception_code::contraction_error);
+
+                --unassigned[cluster_of[pairs[*t].first]];
+                --unassigned[cluster_of[pairs[*t].second]];
+
+                tmpl.loops.push_back(*t);
+                candidates.erase(t);
+              }
+
+            tmpl.pairs = std::move(pairs);
+            tmpls->push_back(std::move(tmpl));
           }
+
+        return tmpls;
+      }
+
+
+    std::map< contractions::cluster_signature, std::shared_ptr<const contractions::template_set> >&
+    contractions::template_cache()
+      {
+        static std::map< cluster_signature, std::shared_ptr<const template_set> > cache;
+        return cache;
+      }
+
+
+    void contractions::clear_template_cache()
+      {
+        template_cache().clear();
       }
 
 
-    bool graph::is_connected() const
+    std::shared_ptr<const contractions::template_set>
+    contractions::get_templates(const cluster_signature& sig)
       {
-        // define an empty graph to be disconnected
-        if(this->edges.empty() || this->vertices.empty()) return false;
+        auto& cache = template_cache();
 
-        // can assume there is at least one vertex and at least one line.
-        // To determine whether the graph is connected we recursively visit all the vertices
-        // attached to any single vertex in the vertex set.
-        // If we visit all vertices then the graph is connected.
-        // If not then it is disconnected
-        vertex_db vs = this->vertices;
+        auto t = cache.find(sig);
+        if(t != cache.end()) return t->second;
 
-        visit_all(this->edges, vs, *vs.begin());
+        std::shared_ptr<const template_set> tmpls = build_templates(sig);
+        cache.emplace(sig, tmpls);
 
-        return vs.empty();
+        return tmpls;
       }
 
 
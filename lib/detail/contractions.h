@@ -63,69 +63,6 @@ namespace cfs
 namespace detail
   {
 
-    //! graph represents the Feynman graph built by performing Wick contractions;
-    //! we need it in order to know whether we have produced a connected or disconnected
-    //! correlation function
-    class graph
-      {
-
-        // TYPES
-
-      protected:
-
-        //! represent a graph as an list of edges source -> destination,
-        //! where source and destination label vertices
-        //! this is used to determine whether a given Wick contraction produces
-        //! a connected or disconnected graph
-        //! we store the edges as a map from source vertex to the list of destination
-        //! vertices available from that source
-        using edge_db = std::map< size_t, std::set<size_t> >;
-
-        //! represent list of vertices
-        using vertex_db = std::set<size_t>;
-
-
-        // CONSTRUCTOR, DESTRUCTOR
-
-      public:
-
-        //! constructor generates an empty graph
-        graph() = default;
-
-        //! destructor is default
-        ~graph() = default;
-
-
-        // EDGE HANDLING
-
-      public:
-
-        //! add an edge from source -> destination
-        //! (we track orientation of edges but this information isn't really used)
-        void add_edge(size_t source, size_t dest);
-
-
-        // QUERY
-
-      public:
-
-        //! determine whether the graph is connected
-        bool is_connected() const;
-
-
-        // INTERNAL DATA
-
-      private:
-
-        //! storage for the graph
-        edge_db edges;
-
-        //! storage for vertices
-        vertex_db vertices;
-
-      };
-    
-    
     //! type for substitution rules for Rayleigh momenta
     using subs_map = GiNaC::exmap;
 
@@ -223,8 +160,28 @@ namespace detail
         //! a contraction group of a list of contractions
         using contraction_group = std::vector<contraction>;
         
-        //! a contraction set of a list of contraction groups (usually representing all possible contractions of an index set)
-        using contraction_set = std::vector< std::unique_ptr<contraction_group> >;
+        //! an abstract contraction pairs two positions in the list of initial value items
+        using abstract_contraction = std::pair<size_t, size_t>;
+
+        //! an abstract pairing is a list of abstract contractions that pairs every initial value item
+        using abstract_pairing = std::vector<abstract_contraction>;
+
+        //! a contraction template describes a connected Wick pairing in a form that depends only on the
+        //! number of fields in each cluster
+        struct contraction_template
+          {
+            //! pairing of fields
+            abstract_pairing pairs;
+
+            //! contractions (labelled by position in pairs) that carry loop momenta, in order of assignment
+            std::vector<size_t> loops;
+          };
+
+        //! list of contraction templates, representing all connected pairings for a given signature
+        using template_set = std::vector<contraction_template>;
+
+        //! cluster-size signature used to key the template cache
+        using cluster_signature = std::vector<size_t>;
 
         //! an element of a string of power spectra generated by Wick products
         using Pk_element = std::pair<GiNaC::ex, size_t>;
@@ -264,22 +221,28 @@ namespace detail
         //! get data for available Wick contractions
         const Wick_set& get() const { return *this->items; }
 
+        //! discard all cached contraction templates, so they are rebuilt on next use
+        static void clear_template_cache();
+
 
         // INTERNAL API
 
       protected:
 
-        //! build and enumerate all possible contractions for a pair of index sets
-        std::unique_ptr<contraction_set>
-        enumerate_contractions(size_t num, const iv_list& ivs) const;
-        
-        //! compute the loop order of a given contraction group
-        template <size_t N>
-        size_t loop_order(const contraction_group& gp, const iv_group<N>& clusters);
+        //! obtain the set of contraction templates for a given cluster-size signature;
+        //! templates are computed once and then shared between all contractions with the same signature
+        static std::shared_ptr<const template_set> get_templates(const cluster_signature& sig);
+
+        //! get the cache of contraction templates, keyed by cluster-size signature
+        static std::map< cluster_signature, std::shared_ptr<const template_set> >& template_cache();
+
+        //! enumerate all connected pairings for a given cluster-size signature, and determine which
+        //! contractions carry loop momenta
+        static std::unique_ptr<template_set> build_templates(const cluster_signature& sig);
         
         //! assign loop momenta
         template <size_t N, typename LabelMap, typename UnassignedGroup>
-        void assign_loop_momenta(const contraction_group& gp, const iv_group <N>& clusters, LabelMap& mma_map,
+        void assign_loop_momenta(const contraction_template& tmpl, const contraction_group& gp, LabelMap& mma_map,
                                  UnassignedGroup& unassigned, GiNaC_symbol_set& loop_momenta);
         
         //! assign external momenta
@@ -292,9 +255,10 @@ namespace detail
         void evaluate_Wick_contractions(const contraction_group& gp, const iv_group<N>& clusters,
                                         LabelMap& mma_map, const UnassignedGroup& unassigned, Pk_string& Ps);
         
-        //! build the data needed to construct a Wick product from a contraction group
+        //! build the data needed to construct a Wick product from a contraction template
         template <size_t N>
-        void build_Wick_product(const contraction_group& gp, const iv_group<N>& clusters, const kext_group<N>& kext);
+        void build_Wick_product(const contraction_template& tmpl, const iv_list& ivs, const iv_group<N>& clusters,
+                                const kext_group<N>& kext);
 
         
         // INTERNAL DATA
@@ -318,9 +282,12 @@ namespace detail
         // total number of fields should be even since we currently include only Gaussian contractions
         // that pair together exactly two fields
         size_t num = 0;
+        cluster_signature sig;
+        sig.reserve(N);
         for(const auto& cluster : clusters)
           {
             num += cluster.size();
+            sig.push_back(cluster.size());
           }
 
         if(num % 2 != 0)
@@ -341,19 +308,17 @@ namespace detail
               }
           }
 
-        // now build all possible Wick pairs, keeping only those that produce connected
-        // correlation functions; we check this by building a representation of the
-        // Wick graph and checking it for connectedness
-        auto ctrs = this->enumerate_contractions(num, ivs);
+        // obtain all Wick pairings that produce connected correlation functions;
+        // these depend only on the number of fields in each cluster, so they are shared between
+        // all contractions with the same signature
+        auto tmpls = get_templates(sig);
 
-        // iterate over contractions groups held in ctrs
-        for(const auto& gpp : *ctrs)
+        // iterate over contraction templates
+        for(const auto& tmpl : *tmpls)
           {
-            const auto& gp = *gpp;
-
-            // convert this contraction group into the data we need to supply -- eg. GiNaC substitution lists,
-            // lists of external momenta, etc ...
-            this->build_Wick_product(gp, clusters, kext);
+            // relabel this template using the fields in ivs, and convert it into the data we need to
+            // supply -- eg. GiNaC substitution lists, lists of external momenta, etc ...
+            this->build_Wick_product(tmpl, ivs, clusters, kext);
           }
       }
     
@@ -403,48 +368,22 @@ namespace detail
     
     template <size_t N, typename LabelMap, typename UnassignedGroup>
     void
-    contractions::assign_loop_momenta(const contraction_group& gp, const iv_group<N>& clusters, LabelMap& mma_map,
-                                      UnassignedGroup& unassigned, GiNaC_symbol_set& loop_momenta)
+    contractions::assign_loop_momenta(const contraction_template& tmpl, const contraction_group& gp,
+                                      LabelMap& mma_map, UnassignedGroup& unassigned, GiNaC_symbol_set& loop_momenta)
       {
         auto& sf = this->loc.get_symbol_factory();
 
-        size_t loop_order = this->loop_order(gp, clusters);
-    
-        // take a working copy of the list of Wick contractions
-        std::list< contraction > gp_copy;
-        std::copy(gp.begin(), gp.end(), std::back_inserter(gp_copy));
-    
-        // predicate to search for candidate Wick contractions
-        auto find_candidate = [&](const contraction& c) -> bool
+        // the template records which contractions should carry loop momenta
+        for(const auto i : tmpl.loops)
           {
-            // work out which clusters the legs of this contraction belong to
+            const auto& c = gp[i];
+
+            // remove these momentum labels from the unassigned list
             const auto& clust1 = c.first.second;
             const auto& clust2 = c.second.second;
         
-            // if there is only a single momentum remaining unassigned at either vertex, then this
-            // contraction isn't a loop -- it must communicate with an external momentum
-            if(unassigned[clust1].size() <= 1) return false;
-            if(unassigned[clust2].size() <= 1) return false;
-        
-            // otherwise, we can assign a loop momentum
-            return true;
-          };
-    
-        // attempt to assign loop momentum labels
-        for(size_t i = 0; i < loop_order; ++i)
-          {
-            // search gp_copy for a candidate contraction to assign as a loop
-            auto t = std::find_if(gp_copy.begin(), gp_copy.end(), find_candidate);
-        
-            if(t == gp_copy.end())
-              throw exception(ERROR_COULD_NOT_ASSIGN_LOOP_MOMENTUM, exception_code::contraction_error);
-        
-            // remove these momentum labels from the unassigned list
-            const auto& clust1 = t->first.second;
-            const auto& clust2 = t->second.second;
-        
-            const auto& iv1 = *t->first.first;
-            const auto& iv2 = *t->second.first;
+            const auto& iv1 = *c.first.first;
+            const auto& iv2 = *c.second.first;
         
             auto t1 = unassigned[clust1].find(iv1.get_momentum());
             auto t2 = unassigned[clust2].find(iv2.get_momentum());
@@ -464,9 +403,6 @@ namespace detail
             
             // insert the label l in the list of loop momenta
             loop_momenta.insert(l);
-        
-            // remove this contraction from the candidate list
-            gp_copy.erase(t);
           }
       }
     
@@ -551,8 +487,17 @@ namespace detail
 
     template <size_t N>
     void
-    contractions::build_Wick_product(const contraction_group& gp, const iv_group<N>& clusters, const kext_group<N>& kext)
+    contractions::build_Wick_product(const contraction_template& tmpl, const iv_list& ivs, const iv_group<N>& clusters,
+                                     const kext_group<N>& kext)
       {
+        // relabel the abstract pairing using the fields in ivs
+        contraction_group gp;
+        gp.reserve(tmpl.pairs.size());
+        for(const auto& c : tmpl.pairs)
+          {
+            gp.emplace_back(ivs[c.first], ivs[c.second]);
+          }
+
         // need to build a string of power spectra representing the Wick product in gp
         Pk_string Ps;
 
@@ -572,7 +517,7 @@ namespace detail
             unassigned[i] = clusters[i].get_momenta();
           }
         
-        this->assign_loop_momenta(gp, clusters, mma_map, unassigned, loop_momenta);
+        this->assign_loop_momenta<N>(tmpl, gp, mma_map, unassigned, loop_momenta);
         this->assign_external_momenta(clusters, kext, mma_map, unassigned);
         
         // STEP 2. Construct Wick contractions
@@ -587,35 +532,6 @@ namespace detail
       }
     
     
-    template <size_t N>
-    size_t
-    contractions::loop_order(const contraction_group& gp, const iv_group<N>& clusters)
-      {
-        // determine number of contractions
-        size_t contractions = gp.size();
-        
-        // determine number of initial field in the full cluster size
-        size_t fields = 0;
-        for(const auto& cluster : clusters)
-          {
-            fields += cluster.size();
-          }
-    
-        // ensure #fields is a multiple of 2
-        if(fields % 2 != 0)
-          throw exception(ERROR_ODD_CONTRACTIONS, exception_code::contraction_error);
-    
-        // there are #fields independent momentum integrals
-        // each contraction generates one momentum-conservation delta function
-        // there are also #clusters momentum-conservation delta functions, one for each cluster
-        // finally, one of these delta functions factorizes out to give global conservation of momentum
-        
-        // so, the number of unconstrained momentum integrations is
-        // #fields - #clusters - #contractions + 1
-        return fields - clusters.size() - contractions + 1;
-      }
-    
-    
   }   // namespace detail
 
 
@@ -32,6 +32,7 @@
 #include "detail/relabel_product.h"
 #include "detail/Rayleigh_momenta.h"
 #include "utilities/GiNaC_utils.h"
+#include "instruments/profiler.h"
 
 
 namespace fourier_kernel_impl
@@ -39,53 +40,47 @@ namespace fourier_kernel_impl
 
     key::key(kernel& k)
       : tm(k.tm),
-        iv(k.iv)
+        iv(k.iv),
+        tm_id(k.loc.get_expression_registry().intern(k.tm))
       {
       }
 
 
-    key::key(const time_function& tm_, const initial_value_set& iv_)
+    key::key(const time_function& tm_, const initial_value_set& iv_, expression_registry& reg_)
       : tm(tm_),
-        iv(iv_)
+        iv(iv_),
+        tm_id(reg_.intern(tm_))
       {
       }
 
 
-    std::vector<GiNaC::symbol>
-    key::get_ordered_iv_symbols() const
+    key::iv_name_list
+    key::get_ordered_iv_names() const
       {
-        std::vector<GiNaC::symbol> symbols;
+        iv_name_list names;
         for(auto t = this->iv.value_cbegin(); t != this->iv.value_cend(); ++t)
           {
-            symbols.push_back(t->get_symbol());
+            names.push_back(t->get_symbol().get_name());
           }
         
-        std::sort(symbols.begin(), symbols.end(), std::less<GiNaC::symbol>{});
+        std::sort(names.begin(), names.end());
         
-        return symbols;
+        return names;
       }
 
 
     size_t key::hash() const
       {
-        // to hash the time expression, expand it completely and print
-        // we are guaranteed that the expressions comes in a canonical order, even if that order is unpredictable
-        std::ostringstream time_string;
-        time_string << this->tm.expand();
-
+        // the time expression was interned when this key was constructed, so we can hash on its identifier
         size_t h = 0;
-        hash_impl::hash_combine(h, time_string.str());
-
-        // to hash the initial value set, order its symbols lexicographically
-        const auto symbols = this->get_ordered_iv_symbols();
+        hash_impl::hash_combine(h, this->tm_id);
 
-        std::string symbol_string;
-        std::for_each(symbols.begin(), symbols.end(),
-                      [&](const GiNaC::symbol& e) -> void
-                        { symbol_string += e.get_name(); });
+        // to hash the initial value set, order its symbol names lexicographically and combine them
+        const auto names = this->get_ordered_iv_names();
 
-        // combine both hashes together
-        hash_impl::hash_combine(h, symbol_string);
+        std::for_each(names.begin(), names.end(),
+                      [&](const std::string& name) -> void
+                        { hash_impl::hash_combine(h, name); });
 
         // return final value
         return h;
@@ -94,29 +89,21 @@ namespace fourier_kernel_impl
 
     bool key::is_equal(const key& obj) const
       {
-        const auto& at = this->tm;
-        const auto& bt = obj.tm;
-
-        // test for equality of expressions
-        auto rt = (at == bt);
-        if(!static_cast<bool>(rt)) return false;
+        // test for equality of time expressions using their interned identifiers
+        if(this->tm_id != obj.tm_id) return false;
 
         // test for equality of initial-value strings
         // we do this by ordering their symbol names lexicographically
         // and testing for equality of those
-        auto a_symbols = this->get_ordered_iv_symbols();
-        auto b_symbols = obj.get_ordered_iv_symbols();
+        auto a_names = this->get_ordered_iv_names();
+        auto b_names = obj.get_ordered_iv_names();
 
-        return std::equal(a_symbols.cbegin(), a_symbols.cend(),
-                          b_symbols.cbegin(), b_symbols.cend(),
-                          [](const GiNaC::symbol& asym, const GiNaC::symbol& bsym) -> bool
-                            { return asym.get_name() == bsym.get_name(); });
+        return std::equal(a_names.cbegin(), a_names.cend(), b_names.cbegin(), b_names.cend());
       }
 
 
     kernel::kernel(GiNaC::ex K_, initial_value_set iv_, time_function tm_, subs_list vs_, service_locator& lc_)
-      : K(std::move(K_)),
-        tm(std::move(tm_)),
+      : tm(std::move(tm_)),
         iv(std::move(iv_)),
         vs(std::move(vs_)),
         loc(lc_)
@@ -124,18 +111,223 @@ namespace fourier_kernel_impl
         // normalize the time function, redistributing factors into the kernel if needed
         auto norm = get_normalization_factor(tm, loc);
         tm /= norm;
-        K *= norm;
+
+        // separate any coefficient symbols from the momentum structure
+        structures = split_coefficients(K_ * norm, loc.get_symbol_factory().get_coefficients());
       }
 
 
     kernel::kernel(initial_value_set iv_, service_locator& sl_)
-      : K(1),
+      : structures{ {GiNaC::ex{1}, GiNaC::ex{1}} },
         tm(1),
         iv(std::move(iv_)),
         loc(sl_)
       {
       }
 
+
+    kernel::kernel(const GiNaC::ex& ar, service_locator& lc_)
+      : loc(lc_)
+      {
+        // archived form is a list {time function, initial values, momentum structures, substitution list}
+        const auto& data = archive_list(ar, 4);
+
+        tm = data.op(0);
+
+        auto& sf = loc.get_symbol_factory();
+        for(const auto& item : archive_list(data.op(1)))
+          {
+            const auto& value = archive_list(item, 2);
+            iv.insert(sf.restore_initial_value(archive_symbol(value.op(0)), archive_symbol(value.op(1))));
+          }
+
+        for(const auto& item : archive_list(data.op(2)))
+          {
+            const auto& structure = archive_list(item, 2);
+            structures.emplace(structure.op(0), structure.op(1));
+          }
+
+        vs = restore_exmap(data.op(3));
+      }
+
+
+    GiNaC::ex kernel::get_kernel() const
+      {
+        GiNaC::ex K{0};
+
+        for(const auto& item : this->structures)
+          {
+            K += item.first * item.second;
+          }
+
+        return K;
+      }
+
+
+    void kernel::scale(const GiNaC::ex& f)
+      {
+        auto factors = split_coefficients(f, this->loc.get_symbol_factory().get_coefficients());
+
+        // if f involves no coefficient symbols, each structure can be rescaled in place
+        if(factors.size() == 1 && factors.begin()->first.is_equal(GiNaC::ex{1}))
+          {
+            const auto& g = factors.begin()->second;
+            for(auto& item : this->structures)
+              {
+                item.second *= g;
+              }
+
+            return;
+          }
+
+        coefficient_map temp;
+        for(const auto& a : this->structures)
+          {
+            for(const auto& b : factors)
+              {
+                accumulate_structure(temp, a.first * b.first, a.second * b.second);
+              }
+          }
+
+        this->structures.swap(temp);
+        this->prune();
+      }
+
+
+    void kernel::prune()
+      {
+        auto t = this->structures.begin();
+
+        while(t != this->structures.end())
+          {
+            if(t->second.is_zero()) t = this->structures.erase(t);
+            else ++t;
+          }
+      }
+
+
+    void kernel::permute_substitution_list(const GiNaC::exmap& perm)
+      {
+        subs_list perm_vs;
+        for(const auto& v : this->vs)
+          {
+            perm_vs[v.first] = v.second.subs(perm);
+          }
+
+        this->vs.swap(perm_vs);
+      }
+
+
+    kernel::coefficient_map split_coefficients(const GiNaC::ex& expr, const GiNaC_symbol_set& coeffs)
+      {
+        kernel::coefficient_map db;
+
+        // if no coefficient symbols are present, the whole expression is a single structure;
+        // this is the common case, and avoids expanding expr
+        bool has_coeffs = false;
+        for(const auto& sym : coeffs)
+          {
+            if(expr.has(sym)) { has_coeffs = true; break; }
+          }
+
+        if(!has_coeffs)
+          {
+            if(!expr.is_zero()) db.emplace(GiNaC::ex{1}, expr);
+            return db;
+          }
+
+        // otherwise, expand and separate each term into a coefficient monomial (including any numerical factor)
+        // and a remainder; coefficient symbols appearing non-polynomially are left in the remainder
+        auto is_coefficient = [&](const GiNaC::ex& f) -> bool
+          {
+            if(GiNaC::is_a<GiNaC::symbol>(f))
+              return coeffs.find(GiNaC::ex_to<GiNaC::symbol>(f)) != coeffs.end();
+
+            if(GiNaC::is_a<GiNaC::power>(f) && GiNaC::is_a<GiNaC::symbol>(f.op(0))
+               && f.op(1).info(GiNaC::info_flags::posint))
+              return coeffs.find(GiNaC::ex_to<GiNaC::symbol>(f.op(0))) != coeffs.end();
+
+            return GiNaC::is_a<GiNaC::numeric>(f);
+          };
+
+        auto process = [&](const GiNaC::ex& term) -> void
+          {
+            GiNaC::ex c{1};
+            GiNaC::ex rest{1};
+
+            if(GiNaC::is_exactly_a<GiNaC::mul>(term))
+              {
+                for(size_t i = 0; i < term.nops(); ++i)
+                  {
+                    const auto& f = term.op(i);
+                    if(is_coefficient(f)) c *= f;
+                    else rest *= f;
+                  }
+              }
+            else if(is_coefficient(term))
+              {
+                c = term;
+              }
+            else
+              {
+                rest = term;
+              }
+
+            accumulate_structure(db, c, rest);
+          };
+
+        auto e = expr.expand();
+
+        if(GiNaC::is_exactly_a<GiNaC::add>(e))
+          {
+            for(size_t i = 0; i < e.nops(); ++i)
+              {
+                process(e.op(i));
+              }
+          }
+        else
+          {
+            process(e);
+          }
+
+        // drop structures that have cancelled
+        auto t = db.begin();
+        while(t != db.end())
+          {
+            if(t->second.is_zero()) t = db.erase(t);
+            else ++t;
+          }
+
+        return db;
+      }
+
+
+    kernel::coefficient_map::iterator
+    accumulate_structure(kernel::coefficient_map& db, const GiNaC::ex& coeff, GiNaC::ex structure)
+      {
+        auto c = coeff.expand();
+        if(c.is_zero()) return db.end();
+
+        // normalize the coefficient by moving the numerical factor of its leading term (selected by content)
+        // into the structure, so that (eg.) b1 and 2*b1 are recognized as the same coefficient
+        auto n = canonical_numeric_factor(c);
+
+        if(!n.is_zero() && !n.is_equal(GiNaC::ex{1}))
+          {
+            c = (c / n).expand();
+            structure *= n;
+          }
+
+        auto it = db.find(c);
+        if(it != db.end())
+          {
+            it->second += structure;
+            return it;
+          }
+
+        return db.emplace(std::move(c), std::move(structure)).first;
+      }
+
     kernel& kernel::operator+=(const kernel& rhs)
       {
         // kernels can only be added if their time functions agree
@@ -171,11 +363,16 @@ namespace fourier_kernel_impl
         auto relabel_map = merge_Rayleigh_rules(this->vs, rhs.vs, this->iv.get_momenta(), mma_map, this->loc);
         std::copy(relabel_map.begin(), relabel_map.end(), std::inserter(mma_map, mma_map.begin()));
 
-        // now perform relabelling in the kernel
+        // now perform relabelling in the kernel, merging structures with matching coefficients
         // note there's no need to perform *index* relabelling since this is a sum -- relabelling indices
         // is needed only in a product
-        auto temp = simplify_index(this->K + rhs.K.subs(mma_map), this->vs, this->loc);
-        this->K = temp;
+        for(const auto& item : rhs.structures)
+          {
+            auto it = accumulate_structure(this->structures, item.first, item.second.subs(mma_map));
+            if(it != this->structures.end()) it->second = simplify_index(it->second, this->vs, this->loc);
+          }
+
+        this->prune();
 
         return *this;
       }
@@ -183,6 +380,8 @@ namespace fourier_kernel_impl
     
     kernel& kernel::operator*=(const kernel& rhs)
       {
+        PROFILE_SCOPE("kernel::operator*=");
+
         auto& sf = this->loc.get_symbol_factory();
 
         // product time function is just product of each individual time function
@@ -235,15 +434,37 @@ namespace fourier_kernel_impl
         auto relabel_map = merge_Rayleigh_rules(this->vs, rhs.vs, this->iv.get_momenta(), mma_map, this->loc);
         std::copy(relabel_map.begin(), relabel_map.end(), std::inserter(mma_map, mma_map.begin()));
 
-        // build final expression, performing any necessary index (or other) relabellings on RHS
+        // build final expression, performing any necessary index (or other) relabellings on RHS;
+        // coefficients multiply, and each product of momentum structures is formed separately
         using detail::relabel_index_product;
-        auto temp = simplify_index(relabel_index_product(this->K, rhs.K.subs(mma_map), this->loc), this->vs, this->loc);
-        this->K = temp;
+
+        coefficient_map rhs_structures;
+        for(const auto& item : rhs.structures)
+          {
+            rhs_structures.emplace(item.first, item.second.subs(mma_map));
+          }
+
+        coefficient_map temp;
+        for(const auto& a : this->structures)
+          {
+            for(const auto& b : rhs_structures)
+              {
+                accumulate_structure(temp, a.first * b.first, relabel_index_product(a.second, b.second, this->loc));
+              }
+          }
+
+        for(auto& item : temp)
+          {
+            item.second = simplify_index(item.second, this->vs, this->loc);
+          }
+
+        this->structures.swap(temp);
+        this->prune();
 
         // renormalize time function
         auto norm = get_normalization_factor(tm, loc);
         this->tm /= norm;
-        this->K *= norm;
+        this->scale(norm);
 
         return *this;
       }
@@ -269,7 +490,10 @@ namespace fourier_kernel_impl
     kernel operator-(const kernel& a)
       {
         kernel b = a;
-        b.K = -b.K;
+        for(auto& item : b.structures)
+          {
+            item.second = -item.second;
+          }
         return b;
       }
     
@@ -306,12 +530,12 @@ namespace fourier_kernel_impl
         std::tie(time_factor, integrand_factor) = partition_factor(a, b.loc);
 
         c.tm = GiNaC::collect_common_factors(c.tm.expand() * time_factor);
-        c.K *= integrand_factor;
+        c.scale(integrand_factor);
         
         // adjust normalization of time function if needed
         auto norm = get_normalization_factor(c.tm, c.loc);
         c.tm /= norm;
-        c.K *= norm;
+        c.scale(norm);
 
         return c;
       }
@@ -348,7 +572,7 @@ namespace fourier_kernel_impl
         // renormalize time function
         auto norm = get_normalization_factor(b.tm, b.loc);
         b.tm /= norm;
-        b.K *= norm;
+        b.scale(norm);
 
         return b;
       }
@@ -386,12 +610,12 @@ namespace fourier_kernel_impl
             throw exception(msg.str(), exception_code::kernel_error);
           }
 
-        this->K *= f;
+        this->scale(f);
 
         // renormalize time function
         auto norm = get_normalization_factor(tm, loc);
         this->tm /= norm;
-        this->K *= norm;
+        this->scale(norm);
 
         return *this;
       }
@@ -457,7 +681,7 @@ namespace fourier_kernel_impl
               }
           }
         
-        this->K *= f;
+        this->scale(f);
 
         // insert new rule if needed
         if(t == this->vs.end()) this->vs[s] = rule;
@@ -465,7 +689,7 @@ namespace fourier_kernel_impl
         // renormalize time function
         auto norm = get_normalization_factor(tm, loc);
         this->tm /= norm;
-        this->K *= norm;
+        this->scale(norm);
 
         return *this;
       }
@@ -492,7 +716,39 @@ namespace fourier_kernel_impl
             out << '\n';
           }
     
-        out << "  kernel = " << this->K << '\n';
+        out << "  kernel = " << this->get_kernel() << '\n';
+      }
+
+
+    GiNaC::ex kernel::to_archive() const
+      {
+        GiNaC::lst values;
+        for(auto u = this->iv.value_cbegin(); u != this->iv.value_cend(); ++u)
+          {
+            GiNaC::lst value;
+            value.append(u->get_momentum());
+            value.append(u->get_symbol());
+
+            values.append(value);
+          }
+
+        GiNaC::lst structs;
+        for(const auto& item : this->structures)
+          {
+            GiNaC::lst structure;
+            structure.append(item.first);
+            structure.append(item.second);
+
+            structs.append(structure);
+          }
+
+        GiNaC::lst data;
+        data.append(this->tm);
+        data.append(values);
+        data.append(structs);
+        data.append(archive_exmap(this->vs));
+
+        return data;
       }
 
 
@@ -749,7 +1005,7 @@ GiNaC::ex get_normalization_factor(const time_function& tm, service_locator& sl)
   }
 
 
-symmetrization_db build_symmetrizations(const GiNaC::ex& K, const initial_value_set& s)
+symmetrization_db build_symmetrizations(const initial_value_set& s)
   {
     // bin initial values by their symbol name
     // this gives us the individual groups over which we need to symmetrize
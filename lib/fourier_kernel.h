@@ -30,13 +30,18 @@
 
 #include <sstream>
 #include <vector>
+#include <array>
+#include <memory>
+#include <initializer_list>
 #include <set>
+#include <map>
 #include <unordered_map>
 
 #include "initial_value.h"
 #include "vector.h"
 
 #include "services/service_locator.h"
+#include "services/checkpoint.h"
 
 #include "utilities/hash_combine.h"
 #include "utilities/GiNaC_utils.h"
@@ -94,6 +99,13 @@ namespace fourier_kernel_impl
         
         // TYPES
         
+      public:
+        
+        //! a coefficient_map associates a coefficient (a polynomial in the symbols declared as coefficients,
+        //! normalized to have unit leading numerical factor) with a momentum structure that is free of
+        //! coefficient symbols. The full kernel is the sum of coefficient*structure over all entries
+        using coefficient_map = std::map< GiNaC::ex, GiNaC::ex, GiNaC::ex_is_less >;
+        
       protected:
         
         //! a momenta_list is a list of initial_value references, ordered by symbol name
@@ -113,6 +125,9 @@ namespace fourier_kernel_impl
         //! alternative constructor accepts just an initial_value_set and a symbol factory refernce;
         //! sets momentum kernel and time function to unity
         kernel(initial_value_set iv_, service_locator& sl_);
+
+        //! constructor rebuilds a kernel from its archived representation; no normalization is applied
+        kernel(const GiNaC::ex& ar, service_locator& lc_);
         
         //! destructor us default
         ~kernel() = default;
@@ -129,7 +144,7 @@ namespace fourier_kernel_impl
         vector get_total_momentum() const;
         
         //! allow implicit conversion to a GiNaC::ex
-        explicit operator GiNaC::ex() const { return this->K; }
+        explicit operator GiNaC::ex() const { return this->get_kernel(); }
     
     
         // ACCESSORS
@@ -145,8 +160,11 @@ namespace fourier_kernel_impl
         //! get substitution list
         const subs_list& get_substitution_list() const { return this->vs; }
         
-        //! get kernel expression
-        const GiNaC::ex& get_kernel() const { return this->K; }
+        //! get kernel expression, recombining coefficients with their momentum structures
+        GiNaC::ex get_kernel() const;
+        
+        //! get momentum structures, indexed by coefficient
+        const coefficient_map& get_structures() const { return this->structures; }
         
         
         // OPERATIONS
@@ -168,6 +186,13 @@ namespace fourier_kernel_impl
         //! convert to EdS approximation in which all time-dependent factors are multiples of D_lin
         void to_EdS();
         
+        //! apply a permutation of the momentum labels to the right-hand sides of the substitution list
+        void permute_substitution_list(const GiNaC::exmap& perm);
+        
+        //! apply an operation to each momentum structure; the operation should not introduce coefficient symbols
+        template <typename Operator>
+        kernel& transform_structures(Operator op);
+        
         
         // SERVICES
         
@@ -175,6 +200,9 @@ namespace fourier_kernel_impl
         
         //! write self to stream
         void write(std::ostream& out) const;
+
+        //! convert self to an archivable representation
+        GiNaC::ex to_archive() const;
         
         
         // INTERNAL API
@@ -184,6 +212,12 @@ namespace fourier_kernel_impl
         //! get list of momentum labels, in order corresponding to lexical order of symbols
         momenta_list get_ordered_momenta() const;
         
+        //! multiply all momentum structures by a factor, which may involve coefficient symbols
+        void scale(const GiNaC::ex& f);
+        
+        //! remove momentum structures which have become zero
+        void prune();
+        
         
         // INTERNAL DATA
         
@@ -197,8 +231,8 @@ namespace fourier_kernel_impl
         
         // KERNEL DATA
         
-        //! cache kernel expression
-        GiNaC::ex K;
+        //! momentum structures, indexed by coefficient
+        coefficient_map structures;
         
         //! time function
         time_function tm;
@@ -221,6 +255,28 @@ namespace fourier_kernel_impl
       };
     
     
+    //! split an expression into a coefficient_map, by collecting powers of the coefficient symbols
+    kernel::coefficient_map split_coefficients(const GiNaC::ex& expr, const GiNaC_symbol_set& coeffs);
+    
+    //! add coefficient*structure to a coefficient_map, normalizing the coefficient and merging
+    //! with any existing structure that has the same coefficient; returns an iterator to the entry
+    kernel::coefficient_map::iterator
+    accumulate_structure(kernel::coefficient_map& db, const GiNaC::ex& coeff, GiNaC::ex structure);
+    
+    
+    template <typename Operator>
+    kernel& kernel::transform_structures(Operator op)
+      {
+        for(auto& item : this->structures)
+          {
+            item.second = op(item.second);
+          }
+        
+        this->prune();
+        return *this;
+      }
+    
+    
     //! key is a flyweight that captures the time and initial value combinations
     //! from a given kernel, which we use to index the database
     class key
@@ -233,8 +289,8 @@ namespace fourier_kernel_impl
         //! constructor accepts a kernel object and captures its data
         explicit key(kernel& k);
         
-        //! alternative constructor accepts explicit references
-        key(const time_function& tm_, const initial_value_set& iv_);
+        //! alternative constructor accepts explicit references and the registry used to intern the time function
+        key(const time_function& tm_, const initial_value_set& iv_, expression_registry& reg_);
         
         //! destructor is default
         ~key() = default;
@@ -252,9 +308,12 @@ namespace fourier_kernel_impl
 
       protected:
 
-        //! get lexicographically-ordered list of symbols in the initial value set;
+        //! list of symbol names
+        using iv_name_list = boost::container::small_vector< std::string, 6 >;
+
+        //! get lexicographically-ordered list of symbol names in the initial value set;
         //! used for ordering and comparison
-        std::vector<GiNaC::symbol> get_ordered_iv_symbols() const;
+        iv_name_list get_ordered_iv_names() const;
         
         
         // INTERNAL DATA
@@ -267,11 +326,11 @@ namespace fourier_kernel_impl
         //! reference to initial value set
         const initial_value_set& iv;
         
+        //! interned identifier for time function
+        expression_registry::id_type tm_id;
+        
       };
     
-    //! the kernel database is an unordered map of keys to kernel expressions
-    using kernel_db = std::unordered_map< key, std::unique_ptr<kernel> >;
-    
   }   // namespace fourier_kernel_impl
 
 
@@ -301,6 +360,87 @@ namespace std
   }   // namespace std
 
 
+namespace fourier_kernel_impl
+  {
+    
+    //! the kernel database is an unordered map of keys to kernel expressions
+    using kernel_db = std::unordered_map< key, std::unique_ptr<kernel> >;
+    
+    
+    //! kernel_view is a lightweight, non-owning view of a kernel database;
+    //! it is used to expose kernels of a fixed order without copying them.
+    //! The view is invalidated if its parent fourier_kernel is modified or destroyed
+    class kernel_view
+      {
+        
+        // TYPES
+        
+      public:
+        
+        //! iterator type
+        using const_iterator = kernel_db::const_iterator;
+        
+        
+        // CONSTRUCTOR, DESTRUCTOR
+        
+      public:
+        
+        //! constructor captures a kernel database; the default is an empty database
+        explicit kernel_view(const kernel_db& db_ = empty_db())
+          : db(&db_)
+          {
+          }
+        
+        //! destructor is default
+        ~kernel_view() = default;
+        
+        
+        // ITERATORS
+        
+      public:
+        
+        const_iterator begin() const  { return this->db->cbegin(); }
+        const_iterator end() const    { return this->db->cend(); }
+        
+        const_iterator cbegin() const { return this->db->cbegin(); }
+        const_iterator cend() const   { return this->db->cend(); }
+        
+        
+        // INTERFACE
+        
+      public:
+        
+        //! get number of kernels in view
+        size_t size() const { return this->db->size(); }
+        
+        //! determine whether view is empty
+        bool empty() const { return this->db->empty(); }
+        
+        
+        // INTERNAL API
+        
+      private:
+        
+        //! shared empty database, used for views of orders which cannot be present
+        static const kernel_db& empty_db()
+          {
+            static const kernel_db db;
+            return db;
+          }
+        
+        
+        // INTERNAL DATA
+        
+      private:
+        
+        //! pointer to viewed database
+        const kernel_db* db;
+        
+      };
+    
+  }   // namespace fourier_kernel_impl
+
+
 // pull in 'kernel' concept since it has wider utility
 using fourier_kernel_impl::kernel;
 
@@ -322,6 +462,13 @@ namespace fourier_kernel_impl
     template <unsigned int N, typename Operator>
     fourier_kernel<N> transform_kernel(const fourier_kernel<N>& a, const fourier_kernel<N>& b, Operator op);
 
+    //! obtain the result of an operation on the given operands from the kernel cache if possible;
+    //! otherwise, build it and store it in the cache. Does nothing unless memoization is enabled
+    template <unsigned int N, typename Builder>
+    fourier_kernel<N> memoize(service_locator& loc, kernel_cache::op o,
+                              std::initializer_list<const fourier_kernel<N>*> operands,
+                              kernel_cache::expression_list exprs, Builder build);
+
   }   // namespace fourier_kernel_impl
 
 //! unary - on a Fourier kernel
@@ -414,6 +561,15 @@ class fourier_kernel
     
     //! pull in kernel_db
     using kernel_db = fourier_kernel_impl::kernel_db;
+    
+    //! pull in kernel_view
+    using order_view = fourier_kernel_impl::kernel_view;
+    
+    //! kernels are stored in an array of per-order buckets; bucket i holds kernels of order i+1
+    using bucket_array = std::array< kernel_db, N >;
+
+    //! bucket arrays are shared between Fourier kernels (and the kernel cache) until one of them is modified
+    using bucket_ptr = std::shared_ptr<bucket_array>;
 
     
     // CONSTRUCTOR, DESTRUCTOR
@@ -436,17 +592,20 @@ class fourier_kernel
     
     //! constructor captures symbol_factory class and creates an empty Fourier representation
     explicit fourier_kernel(service_locator& lc_)
-      : loc(lc_)
+      : loc(lc_),
+        kernels(std::make_shared<bucket_array>())
       {
       }
-    
-    
-    // ITERATORS
-    
-  public:
-    
-    kernel_db::const_iterator cbegin() const { return this->kernels.cbegin(); }
-    kernel_db::const_iterator cend() const   { return this->kernels.cend(); }
+
+    //! constructor shares an existing kernel database
+    fourier_kernel(service_locator& lc_, bucket_ptr k_)
+      : loc(lc_),
+        kernels(std::move(k_))
+      {
+      }
+
+    //! constructor restores a Fourier representation from a checkpoint
+    fourier_kernel(service_locator& lc_, const checkpoint& ckpt, const std::string& label);
     
     
     // KERNEL FUNCTIONS
@@ -477,21 +636,38 @@ class fourier_kernel
     fourier_kernel& add(kernel_type ker, bool silent);
 
     //! insert a symmetrized kernel into the database
-    void insert_symmetric(time_function t, initial_value_set s, GiNaC::ex K, subs_list vs);
+    void insert_symmetric(const kernel_type& ker);
 
     //! insert a unsymmetrized kernel into the database
-    void insert_raw(time_function t, initial_value_set s, GiNaC::ex K, subs_list vs);
+    void insert_raw(std::unique_ptr<kernel_type> ker);
+
+
+    // INTERNAL API
+
+  protected:
+
+    //! get read-only access to the kernel database
+    const bucket_array& buckets() const { return *this->kernels; }
+
+    //! get writeable access to the kernel database; if it is shared, a private copy is taken first
+    bucket_array& mutable_buckets();
+
+    //! copy the kernels in one database into another
+    static void copy_db(const kernel_db& src, kernel_db& dest);
     
     
     // OPERATIONS
     
   public:
     
+    //! get a non-owning view of the elements of fixed order
+    order_view order(unsigned int ord) const;
+
     //! extract list of elements of fixed order as a new Fourier kernel
-    fourier_kernel order(unsigned int ord) const;
+    fourier_kernel extract_order(unsigned int ord) const;
 
     //! get size
-    size_t size() const { return this->kernels.size(); }
+    size_t size() const;
 
     //! convert to EdS approximation in which all time-dependent functions are multiples of D_lin
     fourier_kernel<N> to_EdS();
@@ -506,6 +682,9 @@ class fourier_kernel
     
     //! write self to a stream
     void write(std::ostream& out) const;
+
+    //! store self in a checkpoint under the given label
+    void archive(checkpoint& ckpt, const std::string& label) const;
     
     
     // INTERNAL DATA
@@ -515,8 +694,8 @@ class fourier_kernel
     //! cache reference to service locator
     service_locator& loc;
     
-    //! database of kernels
-    kernel_db kernels;
+    //! database of kernels, bucketed by order
+    bucket_ptr kernels;
     
     
     friend class service_locator;
@@ -526,6 +705,10 @@ class fourier_kernel
     friend fourier_kernel<M> fourier_kernel_impl::transform_kernel(const fourier_kernel<M>& a, Operator op);
     template <unsigned int M, typename Operator>
     friend fourier_kernel<M> fourier_kernel_impl::transform_kernel(const fourier_kernel<M>& a, const fourier_kernel<M>& b, Operator op);
+    template <unsigned int M, typename Builder>
+    friend fourier_kernel<M> fourier_kernel_impl::memoize(service_locator& loc, kernel_cache::op o,
+                                                          std::initializer_list<const fourier_kernel<M>*> operands,
+                                                          kernel_cache::expression_list exprs, Builder build);
     
     friend fourier_kernel operator-<>(const fourier_kernel& a);
     friend fourier_kernel operator+<>(const fourier_kernel& a, const fourier_kernel& b);
@@ -570,7 +753,7 @@ GiNaC::ex get_normalization_factor(const time_function& tm, service_locator& sl)
 
 //! perform symmetrization of kernel
 using symmetrization_db = std::vector< GiNaC::exmap >;
-symmetrization_db build_symmetrizations(const GiNaC::ex& K, const initial_value_set& s);
+symmetrization_db build_symmetrizations(const initial_value_set& s);
 
 //! partition a GiNaC expression into factors, one for the
 //! time factor (first member of pair) and one for the integrand (second member of pair)
@@ -580,45 +763,45 @@ std::pair<GiNaC::ex, GiNaC::ex> partition_factor(const GiNaC::ex& expr, service_
 template <unsigned int N>
 fourier_kernel<N>& fourier_kernel<N>::add(kernel_type k)
   {
-    return this->add(k.get_time_function(), k.get_initial_value_set(), k.get_kernel(), k.get_substitution_list(), false);
+    return this->add(std::move(k), false);
   }
 
 
 template <unsigned int N>
-fourier_kernel<N>& fourier_kernel<N>::add(kernel_type k, bool silent)
+fourier_kernel<N>&
+fourier_kernel<N>::add(time_function t, initial_value_set s, GiNaC::ex K, subs_list vs)
   {
-    return this->add(k.get_time_function(), k.get_initial_value_set(), k.get_kernel(), k.get_substitution_list(), silent);
+    return this->add(std::move(t), std::move(s), std::move(K), std::move(vs), false);
   }
 
 
 template <unsigned int N>
 fourier_kernel<N>&
-fourier_kernel<N>::add(time_function t, initial_value_set s, GiNaC::ex K, subs_list vs)
+fourier_kernel<N>::add(time_function t, initial_value_set s, GiNaC::ex K, subs_list vs, bool silent)
   {
-    return this->add(std::move(t), std::move(s), std::move(K), std::move(vs), false);
+    // the kernel constructor normalizes the time function and separates any coefficient symbols from K
+    return this->add(kernel_type{std::move(K), std::move(s), std::move(t), std::move(vs), this->loc}, silent);
   }
 
 
 template <unsigned int N>
-fourier_kernel<N>&
-fourier_kernel<N>::add(time_function t, initial_value_set s, GiNaC::ex K, subs_list vs, bool silent)
+fourier_kernel<N>& fourier_kernel<N>::add(kernel_type k, bool silent)
   {
+    const auto& s = k.get_initial_value_set();
+    const auto& vs = k.get_substitution_list();
+
     // warn if initial value set is empty
-    if(!validate_ivset_nonempty(s, K, silent)) return *this;
+    if(!validate_ivset_nonempty(s, k.get_kernel(), silent)) return *this;
 
     // ensure that the substitution list (used to specify remappings for Rayleigh momenta)
     // is of the correct format
     validate_subslist(s, vs);
 
-    // normalize the time function, redistributing factors into the kernel if needed
-    auto norm = get_normalization_factor(t, this->loc);
-    t /= norm;
-    K *= norm;
-
-    // simplify index structure in K if possible
-    K = simplify_index(K, vs, this->loc);
+    // simplify index structure in each momentum structure if possible
+    k.transform_structures([&](const GiNaC::ex& K) -> GiNaC::ex { return simplify_index(K, vs, this->loc); });
 
     // validate that K is structurally OK (scalar, rational)
+    auto K = k.get_kernel();
     validate_structure(K);
     
     // validate that momentum variables used in K match those listed in the stochastic terms
@@ -626,20 +809,20 @@ fourier_kernel<N>::add(time_function t, initial_value_set s, GiNaC::ex K, subs_l
 
     if(this->loc.get_argument_cache().get_auto_symmetrize())
       {
-        this->insert_symmetric(std::move(t), std::move(s), std::move(K), std::move(vs));
+        this->insert_symmetric(k);
         return *this;
       }
 
-    this->insert_raw(std::move(t), std::move(s), std::move(K), std::move(vs));
+    this->insert_raw(std::make_unique<kernel_type>(std::move(k)));
     return *this;
   }
 
 
 template <unsigned int N>
-void fourier_kernel<N>::insert_symmetric(time_function t, initial_value_set s, GiNaC::ex K, subs_list vs)
+void fourier_kernel<N>::insert_symmetric(const kernel_type& ker)
   {
     // build list of symmetrizations for this initial value set
-    auto sym_groups = build_symmetrizations(K, s);
+    auto sym_groups = build_symmetrizations(ker.get_initial_value_set());
 
     // get size of symmetrization set
     size_t perms = sym_groups.size();
@@ -648,66 +831,120 @@ void fourier_kernel<N>::insert_symmetric(time_function t, initial_value_set s, G
     // loop over all perms, perform symmetrization, and insert in the kernel list
     for(const auto& perm : sym_groups)
       {
-        // permute K
-        auto perm_K = K.subs(perm) / perms_N;
+        // permute each momentum structure of K; coefficients are unaffected
+        auto perm_ker = std::make_unique<kernel_type>(ker);
+        perm_ker->transform_structures([&](const GiNaC::ex& K) -> GiNaC::ex { return K.subs(perm) / perms_N; });
 
         // permute substitution list
-        subs_list perm_vs;
-        for(const auto& v : vs)
-          {
-            perm_vs[v.first] = v.second.subs(perm);
-          }
+        perm_ker->permute_substitution_list(perm);
 
-        this->insert_raw(t, s, std::move(perm_K), std::move(perm_vs));
+        this->insert_raw(std::move(perm_ker));
       }
   }
 
 
 template <unsigned int N>
-void fourier_kernel<N>::insert_raw(time_function t, initial_value_set s, GiNaC::ex K, subs_list vs)
+void fourier_kernel<N>::insert_raw(std::unique_ptr<kernel_type> ker)
   {
     // construct a key for this record
-    auto ker = std::make_unique<kernel_type>(std::move(K), std::move(s), std::move(t), std::move(vs), this->loc);
     key_type key{*ker};
 
+    // kernels of order higher than N are not retained
+    auto ord = ker->order();
+    if(ord > N) return;
+
+    // the order is part of the key (via the initial value set), so a matching element can
+    // only occur in the bucket for this order
+    auto& bucket = this->mutable_buckets()[ord-1];
+
     // now need to insert this kernel into the database; first, check whether an entry with this
     // key already exists
-    auto it = this->kernels.find(key);
+    auto it = bucket.find(key);
 
     // if so, then a matching element already exists and we should add the current kernel to it
     // notice that momentum relabelling, if needed, is handled by the kernel addition implementation
-    if(it != this->kernels.end())
+    if(it != bucket.end())
       {
         *it->second += *ker;
         return;
       }
 
     // otherwise, we can insert directly
-    auto res = this->kernels.emplace(key, std::move(ker));
+    auto res = bucket.emplace(key, std::move(ker));
     if(!res.second) throw exception(ERROR_KERNEL_INSERT_FAILED, exception_code::kernel_error);
   }
 
 
 template <unsigned int N>
-fourier_kernel<N> fourier_kernel<N>::order(unsigned int ord) const
+typename fourier_kernel<N>::order_view fourier_kernel<N>::order(unsigned int ord) const
+  {
+    if(ord < 1 || ord > N) return order_view{};
+
+    return order_view{this->buckets()[ord-1]};
+  }
+
+
+template <unsigned int N>
+fourier_kernel<N> fourier_kernel<N>::extract_order(unsigned int ord) const
   {
     auto r = this->loc.template make_fourier_kernel<N>();
     
-    if(ord > N) return std::move(r);
+    if(ord < 1 || ord > N) return std::move(r);
     
-    for(const auto& t : this->kernels)
+    // make a copy of each kernel in the bucket for this order
+    copy_db(this->buckets()[ord-1], r.mutable_buckets()[ord-1]);
+    
+    return std::move(r);
+  }
+
+
+template <unsigned int N>
+typename fourier_kernel<N>::bucket_array& fourier_kernel<N>::mutable_buckets()
+  {
+    // if the database is shared (with another Fourier kernel, or the kernel cache), take a private copy
+    // before it is modified
+    if(this->kernels.use_count() > 1)
       {
-        // if order matches required value, make a copy of the kernel and emplace it
-        if(t.second->order() == ord)
+        auto copy = std::make_shared<bucket_array>();
+        
+        for(unsigned int i = 0; i < N; ++i)
           {
-            auto copy_ker = std::make_unique<kernel_type>(*t.second);
-            key_type copy_key{*copy_ker};
-            auto res = r.kernels.emplace(std::move(copy_key), std::move(copy_ker));
-            if(!res.second) throw exception(ERROR_KERNEL_COPY_INSERT_FAILED, exception_code::kernel_error);
+            copy_db((*this->kernels)[i], (*copy)[i]);
           }
+        
+        this->kernels = std::move(copy);
       }
     
-    return std::move(r);
+    return *this->kernels;
+  }
+
+
+template <unsigned int N>
+void fourier_kernel<N>::copy_db(const kernel_db& src, kernel_db& dest)
+  {
+    // make a copy of each kernel in the source database, and emplace it;
+    // keys refer to data owned by the kernel, so must be rebuilt
+    for(const auto& t : src)
+      {
+        auto copy_ker = std::make_unique<kernel_type>(*t.second);
+        key_type copy_key{*copy_ker};
+        auto res = dest.emplace(std::move(copy_key), std::move(copy_ker));
+        if(!res.second) throw exception(ERROR_KERNEL_COPY_INSERT_FAILED, exception_code::kernel_error);
+      }
+  }
+
+
+template <unsigned int N>
+size_t fourier_kernel<N>::size() const
+  {
+    size_t count = 0;
+    
+    for(const auto& bucket : this->buckets())
+      {
+        count += bucket.size();
+      }
+    
+    return count;
   }
 
 
@@ -716,23 +953,49 @@ void fourier_kernel<N>::write(std::ostream& out) const
   {
     unsigned int count = 0;
     
-    for(const auto& t : this->kernels)
+    for(const auto& bucket : this->buckets())
       {
-        const auto& key = t.first;
-        const auto& ker = *t.second;
-        
-        const time_function& tm = ker.get_time_function();
-        const initial_value_set& ivs = ker.get_initial_value_set();
-        const subs_list& vs = ker.get_substitution_list();
-        
-        out << "Kernel " << count << "." << '\n';
-        t.second->write(out);
-        
-        ++count;
+        for(const auto& t : bucket)
+          {
+            out << "Kernel " << count << "." << '\n';
+            t.second->write(out);
+            
+            ++count;
+          }
       }
   }
 
 
+template <unsigned int N>
+fourier_kernel<N>::fourier_kernel(service_locator& lc_, const checkpoint& ckpt, const std::string& label)
+  : fourier_kernel(lc_)
+  {
+    const auto ar = ckpt.unarchive_ex(label);
+
+    for(const auto& item : archive_list(ar))
+      {
+        this->insert_raw(std::make_unique<kernel_type>(item, this->loc));
+      }
+  }
+
+
+template <unsigned int N>
+void fourier_kernel<N>::archive(checkpoint& ckpt, const std::string& label) const
+  {
+    GiNaC::lst list;
+
+    for(const auto& bucket : this->buckets())
+      {
+        for(const auto& t : bucket)
+          {
+            list.append(t.second->to_archive());
+          }
+      }
+
+    ckpt.archive_ex(label, list);
+  }
+
+
 template <unsigned int N>
 std::ostream& operator<<(std::ostream& str, const fourier_kernel<N>& obj)
   {
@@ -748,15 +1011,18 @@ fourier_kernel<N> fourier_kernel_impl::transform_kernel(const fourier_kernel<N>&
     auto r = a.loc.template make_fourier_kernel<N>();
     
     // copy elements from a into this blank kernel, applying op as we go
-    for(const auto& t : a.kernels)
+    for(const auto& bucket : a.buckets())
       {
-        const auto& old_ker = *t.second;
-        
-        // apply operator to kernel
-        auto new_ker = op(old_ker);
-        
-        // insert new kernel
-        r.add(new_ker, true);
+        for(const auto& t : bucket)
+          {
+            const auto& old_ker = *t.second;
+            
+            // apply operator to kernel
+            auto new_ker = op(old_ker);
+            
+            // insert new kernel
+            r.add(new_ker, true);
+          }
       }
     
     return std::move(r);
@@ -770,28 +1036,66 @@ fourier_kernel<N> fourier_kernel_impl::transform_kernel(const fourier_kernel<N>&
     auto r = fourier_kernel_impl::transform_kernel(a, op);
     
     // now copy elements from b into this kernel, applying op
-    for(const auto& t : b.kernels)
+    for(const auto& bucket : b.buckets())
       {
-        const auto& old_ker = *t.second;
-        
-        // apply operator to kernel
-        auto new_ker = op(old_ker);
-        
-        // insert this new kernel
-        r.add(new_ker, true);
+        for(const auto& t : bucket)
+          {
+            const auto& old_ker = *t.second;
+            
+            // apply operator to kernel
+            auto new_ker = op(old_ker);
+            
+            // insert this new kernel
+            r.add(new_ker, true);
+          }
       }
     
     return std::move(r);
   }
 
 
+template <unsigned int N, typename Builder>
+fourier_kernel<N> fourier_kernel_impl::memoize(service_locator& loc, kernel_cache::op o,
+                                               std::initializer_list<const fourier_kernel<N>*> operands,
+                                               kernel_cache::expression_list exprs, Builder build)
+  {
+    auto& cache = loc.get_kernel_cache();
+    if(!cache.is_enabled()) return build();
+    
+    // operands are identified by their kernel database; kernels which share a database are identical
+    kernel_cache::handle_list handles;
+    for(const auto* k : operands)
+      {
+        handles.push_back(k->kernels);
+      }
+    
+    auto h = cache.find(o, N, handles, exprs);
+    if(h)
+      {
+        // the result shares the cached database, which will be copied if it is later modified
+        using bucket_array = typename fourier_kernel<N>::bucket_array;
+        auto db = std::const_pointer_cast<bucket_array>(std::static_pointer_cast<const bucket_array>(h));
+        return fourier_kernel<N>{loc, std::move(db)};
+      }
+    
+    auto r = build();
+    cache.insert(o, N, std::move(handles), std::move(exprs), r.kernels);
+    
+    return std::move(r);
+  }
+
+
 template <unsigned int N>
 fourier_kernel<N> operator-(const fourier_kernel<N>& a)
   {
     using fourier_kernel_impl::kernel;
     using fourier_kernel_impl::transform_kernel;
-    
-    return transform_kernel(a, [](const kernel& b) -> kernel { return -b; });
+    using fourier_kernel_impl::memoize;
+
+    return memoize(a.loc, kernel_cache::op::negate, {&a}, {}, [&]() -> fourier_kernel<N>
+      {
+        return transform_kernel(a, [](const kernel& b) -> kernel { return -b; });
+      });
   }
 
 
@@ -800,8 +1104,12 @@ fourier_kernel<N> operator*(const fourier_kernel<N>& a, const GiNaC::ex b)
   {
     using fourier_kernel_impl::kernel;
     using fourier_kernel_impl::transform_kernel;
-    
-    return transform_kernel(a, [&](const kernel& c) -> kernel { return b*c; });
+    using fourier_kernel_impl::memoize;
+
+    return memoize(a.loc, kernel_cache::op::scale, {&a}, { a.loc.get_expression_registry().intern(b) }, [&]() -> fourier_kernel<N>
+      {
+        return transform_kernel(a, [&](const kernel& c) -> kernel { return b*c; });
+      });
   }
 
 
@@ -824,8 +1132,12 @@ fourier_kernel<N> operator+(const fourier_kernel<N>& a, const fourier_kernel<N>&
   {
     using fourier_kernel_impl::kernel;
     using fourier_kernel_impl::transform_kernel;
-    
-    return transform_kernel(a, b, [](const kernel& c) -> kernel { return c; });
+    using fourier_kernel_impl::memoize;
+
+    return memoize(a.loc, kernel_cache::op::sum, {&a, &b}, {}, [&]() -> fourier_kernel<N>
+      {
+        return transform_kernel(a, b, [](const kernel& c) -> kernel { return c; });
+      });
   }
 
 
@@ -858,7 +1170,7 @@ void KernelProduct(const fourier_kernel<N>& a, const fourier_kernel<N>& b, Inser
         // j labels order to extract from first factor
         for(unsigned int j = 1; j <= i-1; ++j)
           {
-            // extract terms of order j from a and order (i-j) from b
+            // obtain views of terms of order j from a and order (i-j) from b
             auto a_set = a.order(j);
             auto b_set = b.order(i-j);
             
@@ -892,7 +1204,7 @@ void KernelProduct(const fourier_kernel<N>& a, const fourier_kernel<N>& b, const
             // j2 labels order to extract from second factor
             for(unsigned int j2 = 1; j2 <= i-j1-1; ++j2)
               {
-                // extract terms
+                // obtain views of terms at each order
                 auto a_set = a.order(j1);
                 auto b_set = b.order(j2);
                 auto c_set = c.order(i-j1-j2);
@@ -918,20 +1230,24 @@ template <unsigned int N>
 fourier_kernel<N> operator*(const fourier_kernel<N>& a, const fourier_kernel<N>& b)
   {
     using fourier_kernel_impl::kernel;
-    
-    // manufacture a blank fourier kernel of max order N
-    auto r = a.loc.template make_fourier_kernel<N>();
+    using fourier_kernel_impl::memoize;
 
-    // insert step is trivial and should just copy each kernel product into the new container r
-    auto ins = [&](const kernel& c, const kernel& d) -> void
+    return memoize(a.loc, kernel_cache::op::product, {&a, &b}, {}, [&]() -> fourier_kernel<N>
       {
-        auto ker = c*d;
-        r.add(ker, true);
-      };
-    
-    KernelProduct(a, b, ins);
-    
-    return std::move(r);
+        // manufacture a blank fourier kernel of max order N
+        auto r = a.loc.template make_fourier_kernel<N>();
+
+        // insert step is trivial and should just copy each kernel product into the new container r
+        auto ins = [&](const kernel& c, const kernel& d) -> void
+          {
+            auto ker = c*d;
+            r.add(ker, true);
+          };
+
+        KernelProduct(a, b, ins);
+
+        return std::move(r);
+      });
   }
 
 
@@ -949,8 +1265,12 @@ fourier_kernel<N> diff_z(const fourier_kernel<N>& a)
   {
     using fourier_kernel_impl::kernel;
     using fourier_kernel_impl::transform_kernel;
-    
-    return transform_kernel(a, [](const kernel& b) -> kernel { return diff_z(b); });
+    using fourier_kernel_impl::memoize;
+
+    return memoize(a.loc, kernel_cache::op::diff_z, {&a}, {}, [&]() -> fourier_kernel<N>
+      {
+        return transform_kernel(a, [](const kernel& b) -> kernel { return diff_z(b); });
+      });
   }
 
 
@@ -959,17 +1279,21 @@ fourier_kernel<N> Laplacian(const fourier_kernel<N>& a)
   {
     using fourier_kernel_impl::kernel;
     using fourier_kernel_impl::transform_kernel;
-    
-    return transform_kernel(a, [](kernel b) -> kernel
+    using fourier_kernel_impl::memoize;
+
+    return memoize(a.loc, kernel_cache::op::Laplacian, {&a}, {}, [&]() -> fourier_kernel<N>
       {
-        // extract -k^2 for this kernel
-        // it's preferable to avoid introducing a new substitution rule here; those are best kept
-        // for factors in the denominator
-        auto vsum = b.get_total_momentum();
-        auto vsq = -vsum.norm_square();
-        
-        b.multiply_kernel(vsq);
-        return b;
+        return transform_kernel(a, [](kernel b) -> kernel
+          {
+            // extract -k^2 for this kernel
+            // it's preferable to avoid introducing a new substitution rule here; those are best kept
+            // for factors in the denominator
+            auto vsum = b.get_total_momentum();
+            auto vsq = -vsum.norm_square();
+
+            b.multiply_kernel(vsq);
+            return b;
+          });
       });
   }
 
@@ -979,22 +1303,26 @@ fourier_kernel<N> InverseLaplacian(const fourier_kernel<N>& a)
   {
     using fourier_kernel_impl::kernel;
     using fourier_kernel_impl::transform_kernel;
-    
-    return transform_kernel(a, [&](kernel b) -> kernel
+    using fourier_kernel_impl::memoize;
+
+    return memoize(a.loc, kernel_cache::op::InverseLaplacian, {&a}, {}, [&]() -> fourier_kernel<N>
       {
-        // extract -k^2 for this kernel
-        auto vsum = b.get_total_momentum();
-        
-        // generate a new substitution rule because we are introducing
-        // a potentially non-rotationally invariant denominator
-        auto& sf = a.loc.get_symbol_factory();
-        auto label_sym = sf.make_unique_Rayleigh_momentum();
-        vector label = sf.make_vector(label_sym);
+        return transform_kernel(a, [&](kernel b) -> kernel
+          {
+            // extract -k^2 for this kernel
+            auto vsum = b.get_total_momentum();
+
+            // generate a new substitution rule because we are introducing
+            // a potentially non-rotationally invariant denominator
+            auto& sf = a.loc.get_symbol_factory();
+            auto label_sym = sf.make_unique_Rayleigh_momentum();
+            vector label = sf.make_vector(label_sym);
 
-        auto rsq = -label.norm_square();
-        b.multiply_kernel(GiNaC::ex(1)/rsq, label_sym, vsum.get_expr());
+            auto rsq = -label.norm_square();
+            b.multiply_kernel(GiNaC::ex(1)/rsq, label_sym, vsum.get_expr());
 
-        return b;
+            return b;
+          });
       });
   }
 
@@ -1003,34 +1331,38 @@ template <unsigned int N>
 fourier_kernel<N> gradgrad(const fourier_kernel<N>& a, const fourier_kernel<N>& b)
   {
     using fourier_kernel_impl::kernel;
+    using fourier_kernel_impl::memoize;
 
-    auto& sf = a.loc.get_symbol_factory();
-    
-    // manufacture a blank fourier kernel of max order N
-    auto r = a.loc.template make_fourier_kernel<N>();
-    
-    // insert step should multiply each product kernel by -ka.kb
-    auto ins = [&](kernel c, kernel d) -> void
+    return memoize(a.loc, kernel_cache::op::gradgrad, {&a, &b}, {}, [&]() -> fourier_kernel<N>
       {
-        auto idx = sf.make_unique_index();
-        
-        auto kc = c.get_total_momentum();
-        auto kc_idx = kc[idx];
-        
-        auto kd = d.get_total_momentum();
-        auto kd_idx = -kd[idx];
-        
-        // this implementation relies on kernels not noticing the dangling index during multiplication
-        c.multiply_kernel(kc_idx);
-        d.multiply_kernel(kd_idx);
-        
-        auto ker = c*d;
-        r.add(ker, true);
-      };
-    
-    KernelProduct(a, b, ins);
-    
-    return std::move(r);
+        auto& sf = a.loc.get_symbol_factory();
+
+        // manufacture a blank fourier kernel of max order N
+        auto r = a.loc.template make_fourier_kernel<N>();
+
+        // insert step should multiply each product kernel by -ka.kb
+        auto ins = [&](kernel c, kernel d) -> void
+          {
+            auto idx = sf.make_unique_index();
+
+            auto kc = c.get_total_momentum();
+            auto kc_idx = kc[idx];
+
+            auto kd = d.get_total_momentum();
+            auto kd_idx = -kd[idx];
+
+            // this implementation relies on kernels not noticing the dangling index during multiplication
+            c.multiply_kernel(kc_idx);
+            d.multiply_kernel(kd_idx);
+
+            auto ker = c*d;
+            r.add(ker, true);
+          };
+
+        KernelProduct(a, b, ins);
+
+        return std::move(r);
+      });
   }
 
 
@@ -1039,15 +1371,19 @@ fourier_kernel<N> dotgrad(const vector& a, const fourier_kernel<N>& b)
   {
     using fourier_kernel_impl::kernel;
     using fourier_kernel_impl::transform_kernel;
+    using fourier_kernel_impl::memoize;
 
-    // insert step should dot each product kernel with i a.kb
-    return transform_kernel(b, [&](kernel c) -> kernel
+    return memoize(b.loc, kernel_cache::op::dotgrad, {&b}, { b.loc.get_expression_registry().intern(a.get_expr()) }, [&]() -> fourier_kernel<N>
       {
-        auto kc = c.get_total_momentum();
-        
-        c.multiply_kernel(GiNaC::I*dot(a, kc));
-        
-        return c;
+        // insert step should dot each product kernel with i a.kb
+        return transform_kernel(b, [&](kernel c) -> kernel
+          {
+            auto kc = c.get_total_momentum();
+
+            c.multiply_kernel(GiNaC::I*dot(a, kc));
+
+            return c;
+          });
       });
   }
 
@@ -1058,66 +1394,70 @@ fourier_kernel<N> convective_bias_term(const fourier_kernel<N>& vp, const fourie
     static_assert(N == 3, "convective_bias_term() is currently configured only for N=3 kernels");
 
     using fourier_kernel_impl::kernel;
+    using fourier_kernel_impl::memoize;
 
-    auto& sf = delta.loc.get_symbol_factory();
+    return memoize(delta.loc, kernel_cache::op::convective_bias_term, {&vp, &delta}, {}, [&]() -> fourier_kernel<N>
+      {
+        auto& sf = delta.loc.get_symbol_factory();
 
-    // manufacture a blank fourier kernel of max order N
-    auto r = delta.loc.template make_fourier_kernel<N>();
+        // manufacture a blank fourier kernel of max order N
+        auto r = delta.loc.template make_fourier_kernel<N>();
 
-    // get linear kernels from vp and delta
-    auto vp_1 = vp.order(1);
-    auto delta_1 = delta.order(1);
+        // get views of linear kernels from vp and delta
+        auto vp_1 = vp.order(1);
+        auto delta_1 = delta.order(1);
 
-    for(auto ta = vp_1.cbegin(); ta != vp_1.cend(); ++ta)
-      {
-        for(auto tb = vp_1.cbegin(); tb != vp_1.cend(); ++tb)
+        for(auto ta = vp_1.cbegin(); ta != vp_1.cend(); ++ta)
           {
-            for(auto tc = delta_1.cbegin(); tc != delta_1.cend(); ++tc)
+            for(auto tb = vp_1.cbegin(); tb != vp_1.cend(); ++tb)
               {
-                auto idx_i = sf.make_unique_index();
-                auto idx_j = sf.make_unique_index();
+                for(auto tc = delta_1.cbegin(); tc != delta_1.cend(); ++tc)
+                  {
+                    auto idx_i = sf.make_unique_index();
+                    auto idx_j = sf.make_unique_index();
 
-                auto ker_a = *ta->second;
-                auto ker_b = *tb->second;
-                auto ker_c = *tc->second;
+                    auto ker_a = *ta->second;
+                    auto ker_b = *tb->second;
+                    auto ker_c = *tc->second;
 
-                auto k_a = ker_a.get_total_momentum();
-                auto k_b = ker_b.get_total_momentum();
-                auto k_c = ker_c.get_total_momentum();
+                    auto k_a = ker_a.get_total_momentum();
+                    auto k_b = ker_b.get_total_momentum();
+                    auto k_c = ker_c.get_total_momentum();
 
-                auto k_a_i = k_a[idx_i];
-                auto k_b_i = k_b[idx_i];
-                auto k_b_j = k_b[idx_j];
-                auto k_c_j = k_c[idx_j];
+                    auto k_a_i = k_a[idx_i];
+                    auto k_b_i = k_b[idx_i];
+                    auto k_b_j = k_b[idx_j];
+                    auto k_c_j = k_c[idx_j];
 
-                auto ker_d = ker_a;
-                auto ker_e = ker_b;
-                auto ker_f = ker_c;
+                    auto ker_d = ker_a;
+                    auto ker_e = ker_b;
+                    auto ker_f = ker_c;
 
-                auto k_d = ker_d.get_total_momentum();
-                auto k_e = ker_e.get_total_momentum();
-                auto k_f = ker_f.get_total_momentum();
+                    auto k_d = ker_d.get_total_momentum();
+                    auto k_e = ker_e.get_total_momentum();
+                    auto k_f = ker_f.get_total_momentum();
 
-                auto k_d_i = k_d[idx_i];
-                auto k_e_j = k_e[idx_j];
-                auto k_f_i = k_f[idx_i];
-                auto k_f_j = k_f[idx_j];
+                    auto k_d_i = k_d[idx_i];
+                    auto k_e_j = k_e[idx_j];
+                    auto k_f_i = k_f[idx_i];
+                    auto k_f_j = k_f[idx_j];
 
-                ker_a.multiply_kernel(GiNaC::I*k_a_i);
-                ker_b.multiply_kernel(-k_b_i*k_b_j);
-                ker_c.multiply_kernel(GiNaC::I*k_c_j);
+                    ker_a.multiply_kernel(GiNaC::I*k_a_i);
+                    ker_b.multiply_kernel(-k_b_i*k_b_j);
+                    ker_c.multiply_kernel(GiNaC::I*k_c_j);
 
-                ker_d.multiply_kernel(GiNaC::I*k_d_i);
-                ker_e.multiply_kernel(GiNaC::I*k_e_j);
-                ker_f.multiply_kernel(-k_f_i*k_f_j);
+                    ker_d.multiply_kernel(GiNaC::I*k_d_i);
+                    ker_e.multiply_kernel(GiNaC::I*k_e_j);
+                    ker_f.multiply_kernel(-k_f_i*k_f_j);
 
-                auto ker = ker_a*ker_b*ker_c + ker_d*ker_e*ker_f;
-                r.add(ker, true);
+                    auto ker = ker_a*ker_b*ker_c + ker_d*ker_e*ker_f;
+                    r.add(ker, true);
+                  }
               }
           }
-      }
 
-    return std::move(r);
+        return std::move(r);
+      });
   }
 
 
@@ -1125,45 +1465,48 @@ template <unsigned int N>
 fourier_kernel<N> Galileon2(const fourier_kernel<N>& a)
   {
     using fourier_kernel_impl::kernel;
-    using fourier_kernel_impl::transform_kernel;
+    using fourier_kernel_impl::memoize;
 
-    auto& sf = a.loc.get_symbol_factory();
+    return memoize(a.loc, kernel_cache::op::Galileon2, {&a}, {}, [&]() -> fourier_kernel<N>
+      {
+        auto& sf = a.loc.get_symbol_factory();
 
-    // manufacture a blank fourier kernel of max order N
-    auto r = a.loc.template make_fourier_kernel<N>();
+        // manufacture a blank fourier kernel of max order N
+        auto r = a.loc.template make_fourier_kernel<N>();
 
-    auto ins = [&](kernel c, kernel d) -> void
-      {
-        auto idx_i = sf.make_unique_index();
-        auto idx_j = sf.make_unique_index();
+        auto ins = [&](kernel c, kernel d) -> void
+          {
+            auto idx_i = sf.make_unique_index();
+            auto idx_j = sf.make_unique_index();
 
-        auto kc = c.get_total_momentum();
-        auto kc_i = kc[idx_i];
-        auto kc_j = kc[idx_j];
+            auto kc = c.get_total_momentum();
+            auto kc_i = kc[idx_i];
+            auto kc_j = kc[idx_j];
 
-        auto kd = d.get_total_momentum();
-        auto kd_i = kd[idx_i];
-        auto kd_j = kd[idx_j];
+            auto kd = d.get_total_momentum();
+            auto kd_i = kd[idx_i];
+            auto kd_j = kd[idx_j];
 
-        auto e = c;
-        auto f = d;
+            auto e = c;
+            auto f = d;
 
-        auto ke = e.get_total_momentum();
-        auto kf = f.get_total_momentum();
+            auto ke = e.get_total_momentum();
+            auto kf = f.get_total_momentum();
 
-        c.multiply_kernel(-kc_i*kc_j);
-        d.multiply_kernel(-kd_i*kd_j);
+            c.multiply_kernel(-kc_i*kc_j);
+            d.multiply_kernel(-kd_i*kd_j);
 
-        e.multiply_kernel(-ke.norm_square());
-        f.multiply_kernel(-kf.norm_square());
+            e.multiply_kernel(-ke.norm_square());
+            f.multiply_kernel(-kf.norm_square());
 
-        auto ker = c*d - e*f;
-        r.add(ker, true);
-      };
+            auto ker = c*d - e*f;
+            r.add(ker, true);
+          };
 
-    KernelProduct(a, a, ins);
+        KernelProduct(a, a, ins);
 
-    return std::move(r);
+        return std::move(r);
+      });
   }
 
 
@@ -1171,73 +1514,76 @@ template <unsigned int N>
 fourier_kernel<N> Galileon3(const fourier_kernel<N>& a)
   {
     using fourier_kernel_impl::kernel;
-    using fourier_kernel_impl::transform_kernel;
+    using fourier_kernel_impl::memoize;
 
-    auto& sf = a.loc.get_symbol_factory();
+    return memoize(a.loc, kernel_cache::op::Galileon3, {&a}, {}, [&]() -> fourier_kernel<N>
+      {
+        auto& sf = a.loc.get_symbol_factory();
 
-    // manufacture a blank fourier kernel of max order N
-    auto r = a.loc.template make_fourier_kernel<N>();
+        // manufacture a blank fourier kernel of max order N
+        auto r = a.loc.template make_fourier_kernel<N>();
 
-    // insert step should dot each product kernel with i a.kb
-    auto ins = [&](kernel c, kernel d, kernel e) -> void
-      {
-        auto idx_i = sf.make_unique_index();
-        auto idx_j = sf.make_unique_index();
-        auto idx_k = sf.make_unique_index();
+        // insert step should dot each product kernel with i a.kb
+        auto ins = [&](kernel c, kernel d, kernel e) -> void
+          {
+            auto idx_i = sf.make_unique_index();
+            auto idx_j = sf.make_unique_index();
+            auto idx_k = sf.make_unique_index();
 
-        auto kc = c.get_total_momentum();
-        auto kc_i = kc[idx_i];
-        auto kc_j = kc[idx_j];
+            auto kc = c.get_total_momentum();
+            auto kc_i = kc[idx_i];
+            auto kc_j = kc[idx_j];
 
-        auto kd = d.get_total_momentum();
-        auto kd_j = kd[idx_j];
-        auto kd_k = kd[idx_k];
+            auto kd = d.get_total_momentum();
+            auto kd_j = kd[idx_j];
+            auto kd_k = kd[idx_k];
 
-        auto ke = e.get_total_momentum();
-        auto ke_k = ke[idx_k];
-        auto ke_i = ke[idx_i];
+            auto ke = e.get_total_momentum();
+            auto ke_k = ke[idx_k];
+            auto ke_i = ke[idx_i];
 
-        auto f = c;
-        auto g = d;
-        auto h = e;
+            auto f = c;
+            auto g = d;
+            auto h = e;
 
-        auto kf = f.get_total_momentum();
-        auto kg = g.get_total_momentum();
-        auto kh = h.get_total_momentum();
+            auto kf = f.get_total_momentum();
+            auto kg = g.get_total_momentum();
+            auto kh = h.get_total_momentum();
 
-        auto i = c;
-        auto j = d;
-        auto k = e;
+            auto i = c;
+            auto j = d;
+            auto k = e;
 
-        auto ki = i.get_total_momentum();
-        auto ki_i = ki[idx_i];
-        auto ki_j = ki[idx_j];
+            auto ki = i.get_total_momentum();
+            auto ki_i = ki[idx_i];
+            auto ki_j = ki[idx_j];
 
-        auto kj = j.get_total_momentum();
-        auto kj_i = kj[idx_i];
-        auto kj_j = kj[idx_j];
+            auto kj = j.get_total_momentum();
+            auto kj_i = kj[idx_i];
+            auto kj_j = kj[idx_j];
 
-        auto kk = k.get_total_momentum();
+            auto kk = k.get_total_momentum();
 
-        c.multiply_kernel(-kc_i*kc_j);
-        d.multiply_kernel(-kd_j*kd_k);
-        e.multiply_kernel(-ke_k*ke_i);
+            c.multiply_kernel(-kc_i*kc_j);
+            d.multiply_kernel(-kd_j*kd_k);
+            e.multiply_kernel(-ke_k*ke_i);
 
-        f.multiply_kernel(-kf.norm_square());
-        g.multiply_kernel(-kg.norm_square());
-        h.multiply_kernel(-kh.norm_square());
+            f.multiply_kernel(-kf.norm_square());
+            g.multiply_kernel(-kg.norm_square());
+            h.multiply_kernel(-kh.norm_square());
 
-        i.multiply_kernel(-ki_i*ki_j);
-        j.multiply_kernel(-kj_i*kj_j);
-        k.multiply_kernel(-kk.norm_square());
+            i.multiply_kernel(-ki_i*ki_j);
+            j.multiply_kernel(-kj_i*kj_j);
+            k.multiply_kernel(-kk.norm_square());
 
-        auto ker = -(2*c*d*e + f*g*h - 3*i*j*k)/2;
-        r.add(ker, true);
-      };
+            auto ker = -(2*c*d*e + f*g*h - 3*i*j*k)/2;
+            r.add(ker, true);
+          };
 
-    KernelProduct(a, a, a, ins);
+        KernelProduct(a, a, a, ins);
 
-    return std::move(r);
+        return std::move(r);
+      });
   }
 
 
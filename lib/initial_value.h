@@ -115,8 +115,7 @@ namespace std
             // have to perform lexical comparison on name ourselves, since GiNaC doesn't
             // automatically provide an ordering on symbols (ie. usually both a < b and b < a,
             // so they compare equal to std::set<>)
-            if(a_sym.get_name() < b_sym.get_name()) return true;
-            return false;
+            return a_sym.get_name() < b_sym.get_name();
           }
       };
     
@@ -28,6 +28,7 @@
 #include <sstream>
 #include <vector>
 #include <algorithm>
+#include <set>
 
 #include "loop_integral.h"
 
@@ -42,9 +43,6 @@
 namespace loop_integral_impl
   {
 
-    //! order a set of symbols
-    std::vector<GiNaC::symbol> order_symbol_set(const GiNaC_symbol_set& syms);
-
     //! order a set of Rayleigh momenta
     std::vector<subs_list::const_iterator> order_Rayleigh_set(const subs_list& syms);
 
@@ -58,9 +56,10 @@ std::ostream& operator<<(std::ostream& str, const loop_integral& obj)
   }
 
 
-loop_integral::loop_integral(time_function tm_, GiNaC::ex K_, GiNaC::ex ws_, GiNaC_symbol_set lm_,
+loop_integral::loop_integral(time_function tm_, GiNaC::ex cf_, GiNaC::ex K_, GiNaC::ex ws_, GiNaC_symbol_set lm_,
                              GiNaC_symbol_set em_, subs_list rm_, service_locator& lc_)
   : tm(std::move(tm_)),
+    coefficient(std::move(cf_)),
     K(std::move(K_)),
     WickProduct(std::move(ws_)),
     loop_momenta(std::move(lm_)),
@@ -83,16 +82,91 @@ loop_integral::loop_integral(time_function tm_, GiNaC::ex K_, GiNaC::ex ws_, GiN
   }
 
 
+loop_integral::loop_integral(const GiNaC::ex& ar, service_locator& lc_)
+  : loc(lc_)
+  {
+    // archived form is a list {time function, coefficient, kernel, Wick product, loop momenta, external momenta,
+    // Rayleigh momenta}
+    const auto& data = archive_list(ar, 7);
+
+    tm = data.op(0);
+    coefficient = data.op(1);
+    K = data.op(2);
+    WickProduct = data.op(3);
+    loop_momenta = restore_symbol_set(data.op(4));
+    external_momenta = restore_symbol_set(data.op(5));
+    Rayleigh_momenta = restore_exmap(data.op(6));
+  }
+
+
+GiNaC::ex loop_integral::to_archive() const
+  {
+    GiNaC::lst data;
+    data.append(this->tm);
+    data.append(this->coefficient);
+    data.append(this->K);
+    data.append(this->WickProduct);
+    data.append(archive_symbol_set(this->loop_momenta));
+    data.append(archive_symbol_set(this->external_momenta));
+    data.append(archive_exmap(this->Rayleigh_momenta));
+
+    return data;
+  }
+
+
+std::string loop_integral::fingerprint() const
+  {
+    std::ostringstream str;
+
+    // the coefficient is not included; reductions are archived relative to it, so integrals which
+    // differ only in their coefficient can share a reduction
+    str << canonical_print(this->tm) << ";"
+        << canonical_print(this->K) << ";" << canonical_print(this->WickProduct) << ";";
+
+    // print names in lexical order, independently of the container ordering
+    auto print_names = [&](const GiNaC_symbol_set& syms) -> void
+      {
+        std::set<std::string> names;
+        for(const auto& s : syms)
+          {
+            names.insert(s.get_name());
+          }
+        for(const auto& n : names)
+          {
+            str << n << ",";
+          }
+        str << ";";
+      };
+
+    print_names(this->loop_momenta);
+    print_names(this->external_momenta);
+
+    // the same applies to the Rayleigh substitution rules
+    std::set<std::string> rules;
+    for(const auto& item : this->Rayleigh_momenta)
+      {
+        rules.insert(canonical_print(item.first) + "->" + canonical_print(item.second));
+      }
+    for(const auto& r : rules)
+      {
+        str << r << ",";
+      }
+
+    return str.str();
+  }
+
+
 void loop_integral::write(std::ostream& out) const
   {
     std::cout << "  time function = " << this->tm << '\n';
+    std::cout << "  coefficient = " << this->coefficient << '\n';
     std::cout << "  momentum kernel = " << this->K << '\n';
     std::cout << "  Wick product = " << this->WickProduct << '\n';
 
     if(!this->loop_momenta.empty())
       {
         std::cout << "  loop momenta =";
-        for(const auto& sym : this->loop_momenta)
+        for(const auto& sym : order_symbol_set(this->loop_momenta))
           {
             std::cout << " " << sym;
           }
@@ -118,9 +192,10 @@ void loop_integral::canonicalize_loop_labels()
 
     auto& sf = this->loc.get_symbol_factory();
 
-    // step through loop momenta, relabelling to canonicalized variables
+    // step through loop momenta in lexical order, relabelling to canonicalized variables;
+    // the order of the set itself depends on creation order, which would make the labels unstable
     unsigned int count = 0;
-    for(const auto& l : this->loop_momenta)
+    for(const auto& l : order_symbol_set(this->loop_momenta))
       {
         const auto L = sf.make_canonical_loop_momentum(count++);
         relabel[l] = L;
@@ -239,36 +314,31 @@ void loop_integral::match_Wick_to_Rayleigh()
 
 bool loop_integral::is_matching_type(const loop_integral& obj) const
   {
-    using loop_integral_impl::order_symbol_set;
     using loop_integral_impl::order_Rayleigh_set;
 
-    // test for equality of time function, Wick product, loop momenta, external momenta and Rayleigh momenta
+    // test for equality of time function, coefficient, Wick product, loop momenta, external momenta and Rayleigh momenta
     const auto& at = this->tm;
     const auto& bt = obj.tm;
 
     if(!static_cast<bool>(at == bt)) return false;
 
+    // test for equality of coefficient
+    const auto& ac = this->coefficient;
+    const auto& bc = obj.coefficient;
+
+    if(!static_cast<bool>(ac == bc)) return false;
+
     // test for equality of Wick product
     const auto& aw = this->WickProduct;
     const auto& bw = obj.WickProduct;
 
     if(!static_cast<bool>(aw == bw)) return false;
 
-    // test for equality of loop momenta
-    auto a_lm = order_symbol_set(this->loop_momenta);
-    auto b_lm = order_symbol_set(obj.loop_momenta);
-
-    if(!std::equal(a_lm.cbegin(), a_lm.cend(), b_lm.cbegin(), b_lm.cend(),
-                   [](const GiNaC::symbol& asym, const GiNaC::symbol& bsym) -> bool
-                     { return asym.get_name() == bsym.get_name(); })) return false;
+    // test for equality of loop momenta; symbol sets compare by name
+    if(this->loop_momenta != obj.loop_momenta) return false;
 
     // test for equality of external momenta
-    auto a_em = order_symbol_set(this->external_momenta);
-    auto b_em = order_symbol_set(obj.external_momenta);
-
-    if(!std::equal(a_em.cbegin(), a_em.cend(), b_em.cbegin(), b_em.cend(),
-                   [](const GiNaC::symbol& asym, const GiNaC::symbol& bsym) -> bool
-                     { return asym.get_name() == bsym.get_name(); })) return false;
+    if(this->external_momenta != obj.external_momenta) return false;
 
     // test for equality of Rayleigh momenta
     auto a_rm = order_Rayleigh_set(this->Rayleigh_momenta);
@@ -287,7 +357,7 @@ loop_integral& loop_integral::operator+=(const loop_integral& rhs)
     if(!this->is_matching_type(rhs))
       throw exception(ERROR_COMPOSE_LOOP_INTEGRAL_MISMATCHING_TYPE, exception_code::loop_integral_error);
 
-    // we know all variables and Wick product strings agree, so can just add the kernels
+    // we know all variables, coefficients and Wick product strings agree, so can just add the kernels
     this->K += rhs.K;
 
     return *this;
@@ -295,61 +365,27 @@ loop_integral& loop_integral::operator+=(const loop_integral& rhs)
 
 
 loop_integral_key::loop_integral_key(const loop_integral& l)
-  : loop(l)
+  : loop(l),
+    tm_id(l.loc.get_expression_registry().intern(l.tm)),
+    coeff_id(l.loc.get_expression_registry().intern(l.coefficient)),
+    Wick_id(l.loc.get_expression_registry().intern(l.WickProduct)),
+    Rayleigh_id(l.loc.get_expression_registry().intern(l.Rayleigh_momenta))
   {
   }
 
 
 size_t loop_integral_key::hash() const
   {
-    using loop_integral_impl::order_symbol_set;
-    using loop_integral_impl::order_Rayleigh_set;
-
-    // we need to hash on: time function, Wick product, loop momenta, external momenta and Rayleigh momenta
-
-    // to hash the time expression, expand it completely and print
-    // we are guaranteed that the expressions comes in a canonical order, even if that order is unpredictable
-    std::ostringstream time_string;
-    time_string << this->loop.get_time_function().expand();
+    // we need to hash on: time function, coefficient, Wick product, loop momenta, external momenta and Rayleigh momenta
 
+    // the time function, coefficient, Wick product and Rayleigh rules were interned when this key was constructed,
+    // so we can hash on their identifiers
     size_t h = 0;
-    hash_impl::hash_combine(h, time_string.str());
-
-    // to hash the Wick product, expand it completely and print
-    std::ostringstream Wick_string;
-    Wick_string << this->loop.get_Wick_product().expand();
-
-    hash_impl::hash_combine(h, Wick_string.str());
-
-    // order loop momenta lexicographically, convert to a string, and hash
-    auto ordered_lm = order_symbol_set(this->loop.get_loop_momenta());
-
-    std::string lm_string;
-    std::for_each(ordered_lm.begin(), ordered_lm.end(),
-                  [&](const GiNaC::symbol& e) -> void
-                    { lm_string += e.get_name(); });
-
-    hash_impl::hash_combine(h, lm_string);
-
-    // order external momenta lexicographically, convert to a string, and hash
-    auto ordered_em = order_symbol_set(this->loop.get_external_momenta());
-
-    std::string em_string;
-    std::for_each(ordered_em.begin(), ordered_em.end(),
-                  [&](const GiNaC::symbol& e) -> void
-                    { em_string += e.get_name(); });
+    hash_impl::hash_combine(h, this->tm_id, this->coeff_id, this->Wick_id, this->Rayleigh_id);
 
-    hash_impl::hash_combine(h, em_string);
-
-    // order Rayleigh momenta lexicographically, convert to a string, and hash
-    auto ordered_rm = order_Rayleigh_set(this->loop.get_Rayleigh_momenta());
-
-    std::string rm_string;
-    std::for_each(ordered_rm.begin(), ordered_rm.end(),
-                  [&](const decltype(ordered_rm)::value_type& rule) -> void
-                    { std::ostringstream str; str << rule->first << rule->second; rm_string += str.str(); });
-
-    hash_impl::hash_combine(h, rm_string);
+    // symbol sets are ordered by identifier, so can be hashed directly
+    hash_impl::hash_combine(h, this->loop.get_loop_momenta());
+    hash_impl::hash_combine(h, this->loop.get_external_momenta());
 
     return h;
   }
@@ -357,28 +393,21 @@ size_t loop_integral_key::hash() const
 
 bool loop_integral_key::is_equal(const loop_integral_key& obj) const
   {
-    return this->loop.is_matching_type(obj.loop);
+    // test for equality of interned time function, coefficient, Wick product and Rayleigh momenta
+    if(this->tm_id != obj.tm_id) return false;
+    if(this->coeff_id != obj.coeff_id) return false;
+    if(this->Wick_id != obj.Wick_id) return false;
+    if(this->Rayleigh_id != obj.Rayleigh_id) return false;
+
+    // test for equality of loop momenta and external momenta
+    if(this->loop.get_loop_momenta() != obj.loop.get_loop_momenta()) return false;
+    return this->loop.get_external_momenta() == obj.loop.get_external_momenta();
   }
 
 
 namespace loop_integral_impl
   {
 
-    std::vector<GiNaC::symbol> order_symbol_set(const GiNaC_symbol_set& syms)
-      {
-        std::vector<GiNaC::symbol> ordered_set;
-
-        for(const auto& sym : syms)
-          {
-            ordered_set.push_back(sym);
-          }
-
-        std::sort(ordered_set.begin(), ordered_set.end(), std::less<GiNaC::symbol>{});
-
-        return ordered_set;
-      }
-
-
     std::vector<subs_list::const_iterator> order_Rayleigh_set(const subs_list& syms)
       {
         std::vector<subs_list::const_iterator> ordered_set;
@@ -29,9 +29,11 @@
 
 
 #include <iostream>
+#include <string>
 
 #include "shared/common.h"
 #include "services/service_locator.h"
+#include "services/checkpoint.h"
 #include "utilities/GiNaC_utils.h"
 
 
@@ -50,11 +52,16 @@ class loop_integral
 
   public:
 
-    //! constructor accepts a time function, momentum kernel, Wick product string, set of loop momenta,
+    //! constructor accepts a time function, coefficient, momentum kernel, Wick product string, set of loop momenta,
     //! set of external momenta, set of Rayleigh momenta (and mappings), and a symbol factory.
-    //! After construction, the variable names are canonicalized
-    loop_integral(time_function tm_, GiNaC::ex K_, GiNaC::ex ws_, GiNaC_symbol_set lm_, GiNaC_symbol_set em_,
-                  subs_list rm_, service_locator& lc_);
+    //! The coefficient is a polynomial in the symbols declared as coefficients, and the kernel
+    //! should be free of them. After construction, the variable names are canonicalized
+    loop_integral(time_function tm_, GiNaC::ex cf_, GiNaC::ex K_, GiNaC::ex ws_, GiNaC_symbol_set lm_,
+                  GiNaC_symbol_set em_, subs_list rm_, service_locator& lc_);
+
+    //! constructor rebuilds a loop_integral from its archived representation; the variable names
+    //! are already canonical, so no transformations are applied
+    loop_integral(const GiNaC::ex& ar, service_locator& lc_);
 
     //! destructor is default
     ~loop_integral() = default;
@@ -83,6 +90,9 @@ class loop_integral
     //! get time function
     const time_function& get_time_function() const { return this->tm; }
 
+    //! get coefficient multiplying the momentum kernel
+    const GiNaC::ex& get_coefficient() const { return this->coefficient; }
+
     //! get momentum kernel
     const GiNaC::ex& get_kernel() const { return this->K; }
 
@@ -121,9 +131,16 @@ class loop_integral
     void write(std::ostream& out) const;
 
     //! test whether another loop_integral object is of matching type
-    //! (ie. shares time functiom, Wick product, loop momenta, external momenta, Rayleigh momenta)
+    //! (ie. shares time functiom, coefficient, Wick product, loop momenta, external momenta, Rayleigh momenta)
     bool is_matching_type(const loop_integral& obj) const;;
 
+    //! convert self to an archivable representation
+    GiNaC::ex to_archive() const;
+
+    //! get a textual fingerprint identifying this integral; unlike loop_integral_key, it depends only on
+    //! symbol names, so it is the same in every run. The coefficient is not included
+    std::string fingerprint() const;
+
 
     // INTERNAL DATA
 
@@ -140,6 +157,9 @@ class loop_integral
     //! time function
     time_function tm;
 
+    //! coefficient multiplying the kernel, built from the symbols declared as coefficients
+    GiNaC::ex coefficient;
+
     //! kernel
     GiNaC::ex K;
 
@@ -156,6 +176,8 @@ class loop_integral
     subs_list Rayleigh_momenta;
 
 
+    friend class loop_integral_key;
+
   };
 
 
@@ -193,6 +215,18 @@ class loop_integral_key
     //! reference to loop_integral objects
     const loop_integral& loop;
 
+    //! interned identifier for time function
+    expression_registry::id_type tm_id;
+
+    //! interned identifier for coefficient
+    expression_registry::id_type coeff_id;
+
+    //! interned identifier for Wick product
+    expression_registry::id_type Wick_id;
+
+    //! interned identifier for Rayleigh momenta and their substitution rules
+    expression_registry::id_type Rayleigh_id;
+
   };
 
 
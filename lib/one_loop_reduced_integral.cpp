@@ -31,13 +31,18 @@
 #include "detail/special_functions.h"
 #include "detail/legendre_utils.h"
 
+#include "instruments/profiler.h"
+
 #include "shared/exceptions.h"
 #include "localizations/messages.h"
 
 
-one_loop_element::one_loop_element(GiNaC::ex ig_, GiNaC::ex ms_, GiNaC::ex wp_, time_function tm_,
-                                   GiNaC_symbol_set vs_, GiNaC::symbol ang_, GiNaC_symbol_set em_)
-  : integrand(std::move(ig_)),
+one_loop_element::one_loop_element(GiNaC::ex cf_, GiNaC::ex ig_, GiNaC::ex ms_, GiNaC::ex wp_, time_function tm_,
+                                   GiNaC_symbol_set vs_, GiNaC::symbol ang_, GiNaC_symbol_set em_,
+                                   service_locator& lc_)
+  : loc(lc_),
+    coefficient(std::move(cf_)),
+    integrand(std::move(ig_)),
     measure(std::move(ms_)),
     WickProduct(std::move(wp_)),
     tm(std::move(tm_)),
@@ -48,10 +53,41 @@ one_loop_element::one_loop_element(GiNaC::ex ig_, GiNaC::ex ms_, GiNaC::ex wp_,
   }
 
 
+one_loop_element::one_loop_element(const GiNaC::ex& ar, service_locator& lc_)
+  : one_loop_element(archive_list(ar, 8).op(0), ar.op(1), ar.op(2), ar.op(3), ar.op(4), restore_symbol_set(ar.op(5)),
+                     archive_symbol(ar.op(6)), restore_symbol_set(ar.op(7)), lc_)
+  {
+  }
+
+
+GiNaC::ex one_loop_element::to_archive(const GiNaC::ex& cf) const
+  {
+    // store coefficient relative to cf; after reduction every element carries the coefficient of its
+    // parent integral, so in the common case the ratio is unity
+    GiNaC::ex rel_cf = this->coefficient;
+    if(this->coefficient.is_equal(cf)) rel_cf = 1;
+    else if(!cf.is_zero() && !cf.is_equal(1)) rel_cf = (this->coefficient / cf).normal();
+
+    // archived form is a list {coefficient, integrand, measure, Wick product, time function, integration variables,
+    // angular integration variable, external momenta}
+    GiNaC::lst data;
+    data.append(rel_cf);
+    data.append(this->integrand);
+    data.append(this->measure);
+    data.append(this->WickProduct);
+    data.append(this->tm);
+    data.append(archive_symbol_set(this->variables));
+    data.append(this->angular_dx);
+    data.append(archive_symbol_set(this->external_momenta));
+
+    return data;
+  }
+
+
 void one_loop_element::write(std::ostream& str) const
   {
     str << "integral";
-    for(const auto& sym : this->variables)
+    for(const auto& sym : order_symbol_set(this->variables))
       {
         str << " d" << sym;
       }
@@ -60,12 +96,14 @@ void one_loop_element::write(std::ostream& str) const
     str << "  time function = " << GiNaC::collect_common_factors(this->tm) << '\n';
     str << "  measure = " << this->measure << '\n';
     str << "  Wick product = " << this->WickProduct << '\n';
+    str << "  coefficient = " << this->coefficient << '\n';
     str << "  integrand = " << GiNaC::collect_common_factors(this->integrand) << '\n';
   }
 
 
 void one_loop_element::simplify(const GiNaC::exmap& map)
   {
+    this->coefficient = this->coefficient.subs(map);
     this->integrand = this->integrand.subs(map);
     this->measure = this->measure.subs(map);
     this->WickProduct = this->WickProduct.subs(map);
@@ -84,11 +122,11 @@ void one_loop_element::canonicalize_external_momenta()
 
 GiNaC::ex one_loop_element::get_UV_limit(unsigned int order) const
   {
-    // the total contribution from this element is the product of the integrand, the measure, the
+    // the total contribution from this element is the product of the coefficient, the integrand, the measure, the
     // Wick product.
     // (Since the time function is canonicalized it should probably be independent of the external momenta anyway,
     // but we include it to be safe)
-    auto prod = this->tm * this->integrand * this->measure * this->WickProduct;
+    auto prod = this->tm * this->coefficient * this->integrand * this->measure * this->WickProduct;
 
     // the UV limit occurs when the loop momentum is much greater than any of the external
     // momenta. We can achieve the same result by making a series expansion
@@ -123,20 +161,44 @@ GiNaC::ex one_loop_element::get_UV_limit(unsigned int order) const
 
 void one_loop_element::filter(const GiNaC::symbol& pattern, unsigned int order)
   {
+    // coefficient symbols normally appear only in the coefficient, and everything else only in the integrand,
+    // so the filter need be applied to just one of them
+    if(!this->integrand.has(pattern))
+      {
+        this->coefficient = this->coefficient.expand().coeff(pattern, order);
+        return;
+      }
+
+    // otherwise, fold the coefficient into the integrand so the filter sees the complete expression
+    if(this->coefficient.has(pattern)) this->absorb_coefficient();
+
     // rewrite integrand as the coefficient of the specified pattern
     auto temp = this->integrand.expand().coeff(pattern, order);
     this->integrand = temp;
   }
 
 
+void one_loop_element::absorb_coefficient()
+  {
+    this->integrand *= this->coefficient;
+    this->coefficient = 1;
+  }
+
+
 bool one_loop_element::is_matching_type(const one_loop_element& obj) const
   {
-    // test for equality of time function, measure, Wick product, integration variables, external momenta
+    // test for equality of time function, coefficient, measure, Wick product, integration variables, external momenta
     const auto& at = this->tm;
     const auto& bt = obj.tm;
 
     if(!static_cast<bool>(at == bt)) return false;
 
+    // test for equality of coefficient
+    const auto& ac = this->coefficient;
+    const auto& bc = obj.coefficient;
+
+    if(!static_cast<bool>(ac == bc)) return false;
+
     // test for equality of measure
     const auto& am = this->measure;
     const auto& bm = obj.measure;
@@ -149,21 +211,11 @@ bool one_loop_element::is_matching_type(const one_loop_element& obj) const
 
     if(!static_cast<bool>(aw == bw)) return false;
 
-    // test for equality of integration variables
-    auto a_iv = order_symbol_set(this->variables);
-    auto b_iv = order_symbol_set(obj.variables);
-
-    if(!std::equal(a_iv.cbegin(), a_iv.cend(), b_iv.cbegin(), b_iv.cend(),
-                   [](const GiNaC::symbol& asym, const GiNaC::symbol& bsym) -> bool
-                     { return asym.get_name() == bsym.get_name(); })) return false;
+    // test for equality of integration variables; symbol sets compare by name
+    if(this->variables != obj.variables) return false;
 
     // test for equality of external momenta
-    auto a_em = order_symbol_set(this->external_momenta);
-    auto b_em = order_symbol_set(obj.external_momenta);
-
-    if(!std::equal(a_em.cbegin(), a_em.cend(), b_em.cbegin(), b_em.cend(),
-                   [](const GiNaC::symbol& asym, const GiNaC::symbol& bsym) -> bool
-                     { return asym.get_name() == bsym.get_name(); })) return false;
+    if(this->external_momenta != obj.external_momenta) return false;
 
     // test for equality of angular variable
     if(!static_cast<bool>(this->angular_dx == obj.angular_dx)) return false;
@@ -279,6 +331,8 @@ static std::string print_constant(const GiNaC::ex& expr)
 
 static std::string format_print(const GiNaC::ex& expr)
   {
+    PROFILE_SCOPE("format_print");
+
     std::string name;
 
     if(GiNaC::is_a<GiNaC::function>(expr)) name = GiNaC::ex_to<GiNaC::function>(expr).get_name();
@@ -328,7 +382,7 @@ std::string one_loop_element::to_Mathematica(bool do_dx) const
     if(xint) result << "Integrate[";
     else     result << "(";
 
-    result << format_print(this->measure*this->integrand);
+    result << format_print(this->coefficient*this->measure*this->integrand);
 
     if(xint)
       {
@@ -337,13 +391,13 @@ std::string one_loop_element::to_Mathematica(bool do_dx) const
         std::ostringstream assume_list;
         unsigned int count = 0;
 
-        for(const auto& sym : this->variables)
+        for(const auto& sym : order_symbol_set(this->variables))
           {
             if(count >> 0) assume_list << " && ";
             assume_list << sym << ">0";
             ++count;
           }
-        for(const auto& sym : this->external_momenta)
+        for(const auto& sym : order_symbol_set(this->external_momenta))
           {
             if(count >> 0) assume_list << " && ";
             assume_list << sym << ">0";
@@ -364,51 +418,25 @@ std::string one_loop_element::to_Mathematica(bool do_dx) const
 
 
 one_loop_element_key::one_loop_element_key(const one_loop_element& elt_)
-  : elt(elt_)
+  : elt(elt_),
+    tm_id(elt_.loc.get_expression_registry().intern(elt_.tm)),
+    coeff_id(elt_.loc.get_expression_registry().intern(elt_.coefficient)),
+    measure_id(elt_.loc.get_expression_registry().intern(elt_.measure)),
+    Wick_id(elt_.loc.get_expression_registry().intern(elt_.WickProduct))
   {
   }
 
 
 size_t one_loop_element_key::hash() const
   {
-    // print time function to string and hash it
-    std::ostringstream time_string;
-    time_string << this->elt.get_time_function().expand();
-
+    // time function, coefficient, measure and Wick product were interned when this key was constructed,
+    // so we can hash on their identifiers
     size_t h = 0;
-    hash_impl::hash_combine(h, time_string.str());
-
-    // print measure to string and hash it
-    std::ostringstream measure_string;
-    measure_string << this->elt.get_measure().expand();
-
-    hash_impl::hash_combine(h, measure_string.str());
+    hash_impl::hash_combine(h, this->tm_id, this->coeff_id, this->measure_id, this->Wick_id);
 
-    // print Wick product to string and hash it
-    std::ostringstream Wick_string;
-    Wick_string << this->elt.get_Wick_product().expand();
-
-    hash_impl::hash_combine(h, Wick_string.str());
-
-    // order integration variables lexically, convert to a string, and hash
-    auto ordered_iv = order_symbol_set(this->elt.get_integration_variables());
-
-    std::string iv_string;
-    std::for_each(ordered_iv.begin(), ordered_iv.end(),
-                  [&](const GiNaC::symbol& e) -> void
-                    { iv_string += e.get_name(); });
-
-    hash_impl::hash_combine(h, iv_string);
-
-    // order external momenta lexically, convert to a string, and hash
-    auto ordered_em = order_symbol_set(this->elt.get_external_momenta());
-
-    std::string em_string;
-    std::for_each(ordered_em.begin(), ordered_em.end(),
-                  [&](const GiNaC::symbol& e) -> void
-                    { em_string += e.get_name(); });
-
-    hash_impl::hash_combine(h, em_string);
+    // symbol sets are ordered by identifier, so can be hashed directly
+    hash_impl::hash_combine(h, this->elt.get_integration_variables());
+    hash_impl::hash_combine(h, this->elt.get_external_momenta());
 
     return h;
   }
@@ -416,7 +444,18 @@ size_t one_loop_element_key::hash() const
 
 bool one_loop_element_key::is_equal(const one_loop_element_key& obj) const
   {
-    return this->elt.is_matching_type(obj.elt);
+    // test for equality of interned time function, coefficient, measure and Wick product
+    if(this->tm_id != obj.tm_id) return false;
+    if(this->coeff_id != obj.coeff_id) return false;
+    if(this->measure_id != obj.measure_id) return false;
+    if(this->Wick_id != obj.Wick_id) return false;
+
+    // test for equality of integration variables and external momenta
+    if(this->elt.get_integration_variables() != obj.elt.get_integration_variables()) return false;
+    if(this->elt.get_external_momenta() != obj.elt.get_external_momenta()) return false;
+
+    // test for equality of angular variable
+    return static_cast<bool>(this->elt.angular_dx == obj.elt.angular_dx);
   }
 
 
@@ -438,6 +477,7 @@ one_loop_reduced_integral::one_loop_reduced_integral(const loop_integral& i_, se
     Rayleigh_momenta(i_.get_Rayleigh_momenta()),
     WickProduct(i_.get_Wick_product()),
     tm(i_.get_time_function()),
+    coefficient(i_.get_coefficient()),
     external_momenta(i_.get_external_momenta()),
     symmetrize(s_),
     loc(lc_),
@@ -479,8 +519,8 @@ one_loop_reduced_integral::one_loop_reduced_integral(const loop_integral& i_, se
     else
       {
         auto elt =
-          std::make_unique<one_loop_element>(K, 1, this->WickProduct, this->tm,
-                                             GiNaC_symbol_set{}, this->x, this->external_momenta);
+          std::make_unique<one_loop_element>(this->coefficient, K, 1, this->WickProduct, this->tm,
+                                             GiNaC_symbol_set{}, this->x, this->external_momenta, this->loc);
 
         // insert in database
         this->emplace(std::move(elt));
@@ -490,6 +530,8 @@ one_loop_reduced_integral::one_loop_reduced_integral(const loop_integral& i_, se
 
 void one_loop_reduced_integral::reduce(const GiNaC::ex& term)
   {
+    PROFILE_SCOPE("one_loop_reduced_integral::reduce");
+
     // find which Rayleigh momenta this term depends on, if any
     // need to remember that Rayleigh momenta can occur in the momentum kernel but also in the Wick product
     GiNaC_symbol_set Rayleigh_mma;
@@ -519,19 +561,86 @@ void one_loop_reduced_integral::reduce(const GiNaC::ex& term)
   }
 
 
+//! split a term into a coefficient (first member of pair) and its angular skeleton (second member of pair).
+//! The skeleton contains all factors built from angular functions, and the coefficient contains everything else.
+//! Angular reduction is linear in the coefficient, so terms which share a skeleton share a reduction
+static std::pair<GiNaC::ex, GiNaC::ex> split_angular_skeleton(const GiNaC::ex& term)
+  {
+    auto is_angular = [](const GiNaC::ex& f) -> bool
+      {
+        if(GiNaC::is_a<GiNaC::function>(f)) return true;
+        return GiNaC::is_a<GiNaC::power>(f) && GiNaC::is_a<GiNaC::function>(f.op(0));
+      };
+
+    if(!GiNaC::is_a<GiNaC::mul>(term))
+      {
+        if(is_angular(term)) return std::make_pair(GiNaC::ex{1}, term);
+        return std::make_pair(term, GiNaC::ex{1});
+      }
+
+    GiNaC::ex coeff{1};
+    GiNaC::ex skeleton{1};
+
+    for(size_t i = 0; i < term.nops(); ++i)
+      {
+        const GiNaC::ex& f = term.op(i);
+
+        if(is_angular(f)) skeleton *= f;
+        else              coeff *= f;
+      }
+
+    return std::make_pair(coeff, skeleton);
+  }
+
+
+//! get the factors of a term; a term which is not a product is treated as a single factor
+static GiNaC::exvector get_factors(const GiNaC::ex& expr)
+  {
+    if(GiNaC::is_a<GiNaC::mul>(expr)) return to_exvector(expr);
+
+    return GiNaC::exvector{expr};
+  }
+
+
 void one_loop_reduced_integral::one_loop_reduce_zero_Rayleigh(const GiNaC::ex& term)
   {
-    // first, convert all angular terms involving the loop momentum to Legendre representation
-    auto temp = Legendre_to_cosines(term, this->loop_q);
-    temp = cosines_to_Legendre(temp, this->loop_q);
+    // separate angular skeleton from coefficient, and check whether the skeleton has already been reduced
+    auto parts = split_angular_skeleton(term);
+    const GiNaC::ex& coeff = parts.first;
+    const GiNaC::ex& skeleton = parts.second;
+
+    // the reduction depends only on the skeleton and the loop momentum
+    GiNaC::lst key;
+    key.append(skeleton);
+    key.append(this->loop_q);
+
+    auto& cache = this->loc.get_reduction_cache();
+    auto cached = cache.find(key);
 
-    // step through expression, identifying terms with zero, one, two or more Legendre polynomials
-    // and using the generalized orthogonality relation to perform the angular integrations
-    temp = this->integrate_Legendre(temp, this->loop_q,
-      [&](auto temp, auto q) -> auto
-        {
-          return this->apply_Legendre_orthogonality(temp, q);
-        });
+    GiNaC::ex reduced;
+
+    if(cached)
+      {
+        reduced = *cached;
+      }
+    else
+      {
+        // first, convert all angular terms involving the loop momentum to Legendre representation
+        reduced = Legendre_to_cosines(skeleton, this->loop_q);
+        reduced = cosines_to_Legendre(reduced, this->loop_q);
+
+        // step through expression, identifying terms with zero, one, two or more Legendre polynomials
+        // and using the generalized orthogonality relation to perform the angular integrations
+        reduced = this->integrate_Legendre(reduced, this->loop_q,
+          [&](auto temp, auto q) -> auto
+            {
+              return this->apply_Legendre_orthogonality(temp, q);
+            });
+
+        cache.insert(key, reduced);
+      }
+
+    auto temp = (coeff * reduced).expand();
 
     // store result if it is nonzero
     if(temp != 0)
@@ -540,8 +649,8 @@ void one_loop_reduced_integral::one_loop_reduce_zero_Rayleigh(const GiNaC::ex& t
         auto measure = this->loop_q*this->loop_q / GiNaC::pow(2*GiNaC::Pi, 3);
 
         auto elt =
-          std::make_unique<one_loop_element>(temp, measure, this->WickProduct, this->tm,
-                                             GiNaC_symbol_set{this->loop_q}, this->x, this->external_momenta);
+          std::make_unique<one_loop_element>(this->coefficient, temp, measure, this->WickProduct, this->tm,
+                                             GiNaC_symbol_set{this->loop_q}, this->x, this->external_momenta, this->loc);
 
         // insert in database
         this->emplace(std::move(elt));
@@ -594,38 +703,67 @@ void one_loop_reduced_integral::one_loop_reduce_one_Rayleigh(const GiNaC::ex& te
     if(kext_coeff.size() > 1)
       throw exception(ERROR_TOO_MANY_KEXT_IN_RAYLEIGH, exception_code::loop_transformation_error);
 
-    // first task is to perform the Rayleigh angular integration
-    // there should not be any angular dependence in the momentum kernel, making the integral trivial
-    auto temp = Legendre_to_cosines(term, R);
-    temp = cosines_to_Legendre(temp, R);
-
-    auto R_pairs = get_LegP_pairs(temp, R);
-    if(!R_pairs.empty())
-      throw exception(ERROR_KERNEL_DEPENDS_ON_ANGULAR_RAYLEIGH_MOMENTUM, exception_code::loop_transformation_error);
+    // separate angular skeleton from coefficient, and check whether the skeleton has already been reduced
+    auto parts = split_angular_skeleton(term);
+    const GiNaC::ex& coeff = parts.first;
+    const GiNaC::ex& skeleton = parts.second;
 
-    // since the integral is trivial we just get a factor of 4pi; factors of (2l+1) are all unity
-    temp *= GiNaC::numeric{4} * GiNaC::Pi;
+    // the reduction depends on the skeleton, the loop and Rayleigh momenta, and the Rayleigh expansion
+    // (which determines the external momentum and the coefficients of L and k)
+    GiNaC::lst key;
+    key.append(skeleton);
+    key.append(this->loop_q);
+    key.append(R);
+    key.append(Rexp);
 
-    // at this stage we can do the \hat{x} integral
-    // it will couple together the angular terms in the Rayleigh plane wave expansion for k and L
-    // (with suitable factors of 4pi/(2l+1)
-    // this doesn't make any difference to the kernel, as long as we remember that it has been done
+    auto& cache = this->loc.get_reduction_cache();
+    auto cached = cache.find(key);
 
-    // it generates a sum of the form
-    // sum_{n=1}^\infty (-1)^n 4pi (2n+1) LegP(n, k.L)
-    // times a sign factor generated by the sign of k and L
+    GiNaC::ex reduced;
 
-    temp = Legendre_to_cosines(temp, this->loop_q);
-    temp = cosines_to_Legendre(temp, this->loop_q);
+    if(cached)
+      {
+        reduced = *cached;
+      }
+    else
+      {
+        // first task is to perform the Rayleigh angular integration
+        // there should not be any angular dependence in the momentum kernel, making the integral trivial
+        reduced = Legendre_to_cosines(skeleton, R);
+        reduced = cosines_to_Legendre(reduced, R);
+
+        auto R_pairs = get_LegP_pairs(reduced, R);
+        if(!R_pairs.empty())
+          throw exception(ERROR_KERNEL_DEPENDS_ON_ANGULAR_RAYLEIGH_MOMENTUM, exception_code::loop_transformation_error);
+
+        // since the integral is trivial we just get a factor of 4pi; factors of (2l+1) are all unity
+        reduced *= GiNaC::numeric{4} * GiNaC::Pi;
+
+        // at this stage we can do the \hat{x} integral
+        // it will couple together the angular terms in the Rayleigh plane wave expansion for k and L
+        // (with suitable factors of 4pi/(2l+1)
+        // this doesn't make any difference to the kernel, as long as we remember that it has been done
+
+        // it generates a sum of the form
+        // sum_{n=1}^\infty (-1)^n 4pi (2n+1) LegP(n, k.L)
+        // times a sign factor generated by the sign of k and L
+
+        reduced = Legendre_to_cosines(reduced, this->loop_q);
+        reduced = cosines_to_Legendre(reduced, this->loop_q);
+
+        // step through this expression, pairing up LegP(n, k.L) and LegP(n, r.L) terms,
+        // either appearing explicitly or from the sum generated by the \hat{x} integral,
+        // and also replacing the dx integral with a Fabrikant function
+        reduced = this->integrate_Legendre(reduced, this->loop_q,
+          [&](auto term, auto q) -> auto
+            {
+              return this->apply_Legendre_orthogonality(term, q, loop_coeff, kext_coeff.begin()->first, kext_coeff.begin()->second, R);
+            });
+
+        cache.insert(key, reduced);
+      }
 
-    // step through this expression, pairing up LegP(n, k.L) and LegP(n, r.L) terms,
-    // either appearing explicitly or from the sum generated by the \hat{x} integral,
-    // and also replacing the dx integral with a Fabrikant function
-    temp = this->integrate_Legendre(temp, this->loop_q,
-      [&](auto term, auto q) -> auto
-        {
-          return this->apply_Legendre_orthogonality(term, q, loop_coeff, kext_coeff.begin()->first, kext_coeff.begin()->second, R);
-        });
+    auto temp = (coeff * reduced).expand();
 
     // the input kernel should be dimensionless
     // the output kernel has an extra integral d^3 s and should therefore have dimension [k^-3], ie. it loses
@@ -657,8 +795,8 @@ void one_loop_reduced_integral::one_loop_reduce_one_Rayleigh(const GiNaC::ex& te
         temp = temp.subs(R_map);
 
         auto elt =
-          std::make_unique<one_loop_element>(temp, measure, this->WickProduct.subs(R_map), this->tm,
-                                             GiNaC_symbol_set{this->loop_q, this->x}, this->x, this->external_momenta);
+          std::make_unique<one_loop_element>(this->coefficient, temp, measure, this->WickProduct.subs(R_map), this->tm,
+                                             GiNaC_symbol_set{this->loop_q, this->x}, this->x, this->external_momenta, this->loc);
 
         // insert in database
         this->emplace(std::move(elt));
@@ -673,15 +811,13 @@ GiNaC::ex one_loop_reduced_integral::apply_Legendre_orthogonality(const GiNaC::e
     using Legendre_list = std::vector< std::pair< GiNaC::symbol, unsigned int > >;
     Legendre_list partner_q;
 
-    if(GiNaC::is_a<GiNaC::numeric>(expr) || GiNaC::is_a<GiNaC::power>(expr)) temp = expr;
-    else if(GiNaC::is_a<GiNaC::mul>(expr))
+    if(GiNaC::is_a<GiNaC::numeric>(expr) || GiNaC::is_a<GiNaC::power>(expr) || GiNaC::is_a<GiNaC::symbol>(expr)) temp = expr;
+    else if(GiNaC::is_a<GiNaC::mul>(expr) || GiNaC::is_a<GiNaC::function>(expr))
       {
         // run through each factor in the expression
         // if it is a Legendre polynomial involving q then record the momentum it occurs with, and its order
-        for(size_t i = 0; i < expr.nops(); ++i)
+        for(const auto& term : get_factors(expr))
           {
-            const GiNaC::ex& term = expr.op(i);
-
             if(!GiNaC::is_a<GiNaC::function>(term)) { temp *= term; continue; }
 
             const auto& fn = GiNaC::ex_to<GiNaC::function>(term);
@@ -738,7 +874,8 @@ static std::map< unsigned int, GiNaC::numeric > A_cache;
 
 GiNaC::numeric A(unsigned int r)
   {
-    if(A_cache.find(r) != A_cache.end()) return A_cache[r];
+    auto t = A_cache.find(r);
+    if(t != A_cache.end()) return t->second;
 
     unsigned int numerator = 1;
     unsigned int count = 2*r - 1;
@@ -827,9 +964,8 @@ one_loop_reduced_integral::apply_Legendre_orthogonality(const GiNaC::ex& expr, c
     using Legendre_list = std::vector< std::pair< GiNaC::symbol, unsigned int > >;
     Legendre_list partner_q;
 
-    for(size_t i = 0; i < expr.nops(); ++i)
+    for(const auto& term : get_factors(expr))
       {
-        const auto term = expr.op(i);
         if(!GiNaC::is_a<GiNaC::function>(term)) { temp *= term; continue; }
 
         const auto& fn = GiNaC::ex_to<GiNaC::function>(term);
@@ -883,6 +1019,53 @@ one_loop_reduced_integral::apply_Legendre_orthogonality(const GiNaC::ex& expr, c
   }
 
 
+one_loop_reduced_integral::one_loop_reduced_integral(const loop_integral& i_, const GiNaC::ex& ar, service_locator& lc_)
+  : loop_int(i_),
+    Rayleigh_momenta(i_.get_Rayleigh_momenta()),
+    WickProduct(i_.get_Wick_product()),
+    tm(i_.get_time_function()),
+    coefficient(i_.get_coefficient()),
+    external_momenta(i_.get_external_momenta()),
+    symmetrize(false),
+    loc(lc_),
+    x(lc_.get_symbol_factory().make_symbol("x"))
+  {
+    // archived form is a list {symmetrize flag, elements}
+    const auto& data = archive_list(ar, 2);
+
+    symmetrize = !data.op(0).is_zero();
+
+    if(loop_int.get_loop_order() == 1) loop_q = *loop_int.get_loop_momenta().begin();
+
+    // element coefficients are archived relative to the coefficient of the parent integral
+    for(const auto& item : archive_list(data.op(1)))
+      {
+        auto elt = std::make_unique<one_loop_element>(item, this->loc);
+        if(!this->coefficient.is_zero()) elt->set_coefficient(elt->get_coefficient() * this->coefficient);
+
+        this->emplace(std::move(elt));
+      }
+  }
+
+
+GiNaC::ex one_loop_reduced_integral::to_archive() const
+  {
+    GiNaC::lst elements;
+    for(const auto& record : this->integrand)
+      {
+        const auto& data = record.second;
+
+        if(data) elements.append(data->to_archive(this->coefficient));
+      }
+
+    GiNaC::lst data;
+    data.append(this->symmetrize ? 1 : 0);
+    data.append(elements);
+
+    return data;
+  }
+
+
 void one_loop_reduced_integral::write(std::ostream& out) const
   {
     out << this->integrand;
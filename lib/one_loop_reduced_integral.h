@@ -52,9 +52,13 @@ class one_loop_element
 
   public:
 
-    //! constructor captures integrand, measure, integration variables, Wick product, time factor, external momenta
-    one_loop_element(GiNaC::ex ig_, GiNaC::ex ms_, GiNaC::ex wp_, time_function tm_,
-                     GiNaC_symbol_set vs_, GiNaC::symbol ang_, GiNaC_symbol_set em_);
+    //! constructor captures coefficient, integrand, measure, integration variables, Wick product, time factor,
+    //! external momenta. The coefficient is a polynomial in the symbols declared as coefficients
+    one_loop_element(GiNaC::ex cf_, GiNaC::ex ig_, GiNaC::ex ms_, GiNaC::ex wp_, time_function tm_,
+                     GiNaC_symbol_set vs_, GiNaC::symbol ang_, GiNaC_symbol_set em_, service_locator& lc_);
+
+    //! constructor rebuilds an element from its archived representation
+    one_loop_element(const GiNaC::ex& ar, service_locator& lc_);
 
     //! destructor is default
     ~one_loop_element() = default;
@@ -72,6 +76,9 @@ class one_loop_element
 
   public:
 
+    //! get coefficient multiplying the integrand
+    const GiNaC::ex& get_coefficient() const { return this->coefficient; }
+
     //! get integrand
     const GiNaC::ex& get_integrand() const { return this->integrand; }
 
@@ -98,11 +105,12 @@ class one_loop_element
     //! write self to stream
     void write(std::ostream& str) const;
 
-    //! test for matching type (matches time function, measure, Wick product, integration variables, external momenta)
+    //! test for matching type (matches time function, coefficient, measure, Wick product, integration variables,
+    //! external momenta)
     bool is_matching_type(const one_loop_element& obj) const;
 
     //! test for nullity of integrand
-    bool null() const { return static_cast<bool>(this->integrand == 0); }
+    bool null() const { return static_cast<bool>(this->integrand == 0) || static_cast<bool>(this->coefficient == 0); }
 
 
     // TRANSFORMATIONS
@@ -118,6 +126,15 @@ class one_loop_element
     //! filter integrand
     void filter(const GiNaC::symbol& pattern, unsigned int order = 1);
 
+    //! replace integrand, keeping all other data
+    void set_integrand(GiNaC::ex ig) { this->integrand = std::move(ig); }
+
+    //! replace coefficient, keeping all other data
+    void set_coefficient(GiNaC::ex cf) { this->coefficient = std::move(cf); }
+
+    //! multiply the coefficient into the integrand, leaving a unit coefficient
+    void absorb_coefficient();
+
 
     // SERVICES
 
@@ -129,11 +146,26 @@ class one_loop_element
     //! construct UV limit
     GiNaC::ex get_UV_limit(unsigned int order=2) const;
 
+    //! convert self to an archivable representation; the coefficient is stored relative to cf,
+    //! and should be multiplied by it again when the element is restored
+    GiNaC::ex to_archive(const GiNaC::ex& cf = 1) const;
+
 
     // INTERNAL DATA
 
   private:
 
+    // AGENTS
+
+    //! cache reference to service locator
+    service_locator& loc;
+
+
+    // INTEGRAND DATA
+
+    //! coefficient multiplying the integrand, built from the symbols declared as coefficients
+    GiNaC::ex coefficient;
+
     //! integrand
     GiNaC::ex integrand;
 
@@ -203,6 +235,18 @@ class one_loop_element_key
     //! cache reference to partner class
     const one_loop_element& elt;
 
+    //! interned identifier for time function
+    expression_registry::id_type tm_id;
+
+    //! interned identifier for coefficient
+    expression_registry::id_type coeff_id;
+
+    //! interned identifier for measure
+    expression_registry::id_type measure_id;
+
+    //! interned identifier for Wick product
+    expression_registry::id_type Wick_id;
+
   };
 
 
@@ -249,6 +293,10 @@ class one_loop_reduced_integral
     //! constructor accepts a loop_integral container and performs dimensional reduction on it
     one_loop_reduced_integral(const loop_integral& i_, service_locator& lc_, bool s_);
 
+    //! constructor accepts a loop_integral container and the archived representation of its
+    //! reduction, eg. restored from a checkpoint; no reduction is performed
+    one_loop_reduced_integral(const loop_integral& i_, const GiNaC::ex& ar, service_locator& lc_);
+
     //! destructor is default
     ~one_loop_reduced_integral() = default;
 
@@ -317,6 +365,11 @@ class one_loop_reduced_integral
     //! get UV limit
     GiNaC::ex get_UV_limit(unsigned int order=2) const;
 
+    //! convert self to an archivable representation; the parent loop_integral is not included.
+    //! Element coefficients are stored relative to the coefficient of the parent, so the archive can be
+    //! restored against any loop integral which differs only in its coefficient
+    GiNaC::ex to_archive() const;
+
 
     // INTERNAL DATA
 
@@ -342,6 +395,9 @@ class one_loop_reduced_integral
     //! cache time function
     const time_function& tm;
 
+    //! cache coefficient
+    const GiNaC::ex& coefficient;
+
     //! cache loop momentum
     GiNaC::symbol loop_q;
 
@@ -386,7 +442,8 @@ GiNaC::ex one_loop_reduced_integral::integrate_Legendre(const GiNaC::ex& term, c
         return temp;
       }
 
-    if(GiNaC::is_a<GiNaC::symbol>(term_ex) || GiNaC::is_a<GiNaC::function>(term_ex)) return term;
+    // a single symbol or function is a product with one factor
+    if(GiNaC::is_a<GiNaC::symbol>(term_ex) || GiNaC::is_a<GiNaC::function>(term_ex)) return f(term_ex, q);
 
     std::cerr << term_ex << '\n';
     throw exception(ERROR_BADLY_FORMED_TOP_LEVEL_LEGENDRE_SUM, exception_code::loop_transformation_error);
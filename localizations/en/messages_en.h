@@ -39,7 +39,17 @@ constexpr auto LABEL_PK_TREE = "Tree level";
 constexpr auto LABEL_PK_13 = "Loop level 13";
 constexpr auto LABEL_PK_22 = "Loop level 22";
 
+constexpr auto LABEL_ANGULAR_REDUCTION_PROGRESS = "Angular reduction: completed";
+constexpr auto LABEL_CHECKPOINT_RESUME = "Resuming from checkpoint for stage";
+constexpr auto LABEL_CHECKPOINT_NONE = "No usable checkpoint found; starting from the beginning";
+constexpr auto LABEL_INTEGRAL_CACHE = "Reduced integral cache:";
+constexpr auto LABEL_INTEGRAL_CACHE_HITS = "hits,";
+constexpr auto LABEL_INTEGRAL_CACHE_MISSES = "misses";
+
 constexpr auto ERROR_SYMBOL_INSERTION_FAILED = "Internal error: symbol insertion failed";
+constexpr auto ERROR_SYMBOL_ID_TABLE_NOT_BOUND = "Internal error: no symbol identifier table is available";
+constexpr auto ERROR_EXPRESSION_REGISTRY_INSERT_FAILED = "Internal error: expression registry insertion failed";
+constexpr auto ERROR_EXPRESSION_REGISTRY_UNKNOWN_ID = "Internal error: unknown expression registry identifier";
 constexpr auto ERROR_INITIAL_VALUE_INSERT_FAILED = "Internal error: initial value insertion failed";
 constexpr auto ERROR_KERNEL_INSERT_FAILED = "Internal error: kernel insertion failed";
 constexpr auto ERROR_KERNEL_COPY_INSERT_FAILED = "Internal error: kernel insertion failed on copy";
@@ -128,10 +138,25 @@ constexpr auto ERROR_COMPOSE_ONE_LOOP_ELEMENT_MISMATCHING_TYPE = "Internal error
 constexpr auto ERROR_BACKEND_PK_RSD_ALREADY_REGISTERED_A = "A power spectrum with the name";
 constexpr auto ERROR_BACKEND_PK_RSD_ALREADY_REGISTERED_B = "is already registered for output";
 
+constexpr auto ERROR_PK_RSD_FILTER_ALREADY_REQUESTED_A = "An RSD filter pattern with the name";
+constexpr auto ERROR_PK_RSD_FILTER_ALREADY_REQUESTED_B = "has already been requested";
+constexpr auto ERROR_PK_RSD_BUILDER_RESTORED = "Cannot request RSD filter patterns from a decomposition restored from a checkpoint";
+constexpr auto ERROR_PK_RSD_FILTER_SYMBOL_NOT_BIAS = "RSD filter pattern contains a symbol that is not a declared bias symbol";
+
 constexpr auto ERROR_UNKNOWN_GINAC_FUNCTION = "Unknown mathematical function";
 constexpr auto ERROR_BACKEND_POW_ARGUMENTS = "Internal error: power function has unexpected number of arguments";
 constexpr auto ERROR_BACKEND_PK_ARGUMENTS = "Internal error: Pk correlator has unexpected number of arguments";
 
+constexpr auto ERROR_CHECKPOINT_OPEN_FAILED = "Could not open checkpoint file";
+constexpr auto ERROR_CHECKPOINT_WRITE_FAILED = "Could not write checkpoint file";
+constexpr auto ERROR_CHECKPOINT_BADLY_FORMED = "Badly formed checkpoint file";
+constexpr auto ERROR_CHECKPOINT_MISSING_ENTRY = "Checkpoint does not contain the entry";
+constexpr auto ERROR_CHECKPOINT_UNEXPECTED_FORM = "Archived object in checkpoint has unexpected form";
+constexpr auto ERROR_CHECKPOINT_UNKNOWN_STAGE = "Internal error: unknown checkpoint stage";
+constexpr auto ERROR_CHECKPOINT_NO_RESUME_POINT = "Internal error: no checkpoint has been restored";
+
+constexpr auto ERROR_WORKER_PROCESS_FAILED = "A worker process could not be started, or did not complete successfully";
+
 constexpr auto WARNING_UNUSED_MOMENTA_SING = "Kernel does not depend on available momentum vector";
 constexpr auto WARNING_UNUSED_MOMENTA_PLURAL = "Kernel does not depend on available momentum vectors";
 constexpr auto WARNING_ORDER_ZERO_KERNEL = "Ignoring order-zero kernel";
@@ -140,6 +165,11 @@ constexpr auto WARNING_UNEVALUATED_FABRIKANT = "Unevaluated Fabrikant integral o
 constexpr auto WARNING_PARAMETER_APPEARS_IN_TIME_FUNCTION_RENORMALIZATION = "Encountered normalization of time-dependent function with parameter";
 constexpr auto WARNING_PK_RSD_EMPTY = "Empty RSD Pk group for filter pattern";
 constexpr auto WARNING_KERNEL_IS_NOT_IR_SAFE = "Detected failure of IR safety for LSSEFT kernel";
+constexpr auto WARNING_CHECKPOINT_IGNORED = "Ignoring checkpoint";
+constexpr auto WARNING_RESUME_WITHOUT_CHECKPOINT_DIR = "Resume requested, but no checkpoint directory was specified";
+constexpr auto WARNING_INTEGRAL_CACHE_UNAVAILABLE = "Reduced integral cache is disabled; could not create directory";
+constexpr auto WARNING_INTEGRAL_CACHE_WRITE_FAILED = "Could not write to reduced integral cache";
+constexpr auto WARNING_INTEGRAL_CACHE_TRIM_FAILED = "Could not evict entries from reduced integral cache";
 
 
 #endif //LSSEFT_ANALYTIC_MESSAGES_EN_H
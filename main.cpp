@@ -29,6 +29,7 @@
 #include <functional>
 
 #include "services/service_locator.h"
+#include "services/checkpoint_store.h"
 
 #include "lib/vector.h"
 #include "lib/initial_value.h"
@@ -38,11 +39,13 @@
 #include "lib/detail/special_functions.h"
 
 #include "SPT/time_functions.h"
-#include "SPT/one_loop_kernels.h"
+#include "SPT/halo_model.h"
 
 #include "backends/LSSEFT.h"
 
 #include "instruments/timing_instrument.h"
+#include "instruments/profiler.h"
+#include "instruments/run_statistics.h"
 
 
 std::vector<std::string> generate_UV_limit(const Pk_rsd_group& group, const GiNaC::symbol& k, unsigned int max_mu, unsigned int max_k)
@@ -193,12 +196,36 @@ int main(int argc, char* argv[])
     if(!args.get_counterterms() && args.get_output_path().empty() && args.get_Mathematica_output().empty())
       exit(EXIT_SUCCESS);
 
-    // redshift z is the time variable
-    const auto& z = sf.get_z();
+    if(!args.get_profile_report().empty() || !args.get_profile_trace().empty())
+      profiler::instance().enable(!args.get_profile_trace().empty());
 
-    // H is the Hubble rate, f is linear growth factor
-    GiNaC::ex H = FRW::Hub(z);
-    GiNaC::ex f = SPT::f(z);
+    // memory usage is recorded at the end of each stage, if requested
+    run_statistics stats;
+    if(!args.get_memory_report().empty()) stats.enable();
+
+    // each stage is timed by a timing_instrument; the previous stage must be closed before
+    // the next begins, so that stages are recorded as sibling (not nested) profiler regions
+    std::unique_ptr<timing_instrument> timer;
+    std::string stage;
+
+    auto end_stage = [&]() -> void
+      {
+        timer.reset();
+
+        // kernels built during a stage have been consumed once it ends, so release memoized kernel
+        // algebra; its entries would otherwise keep every intermediate kernel database alive
+        loc.get_kernel_cache().clear();
+
+        if(!stage.empty()) stats.checkpoint(stage);
+        stage.clear();
+      };
+
+    auto begin_stage = [&](std::string name) -> void
+      {
+        end_stage();
+        stage = name;
+        timer = std::make_unique<timing_instrument>(std::move(name));
+      };
 
     // r is the unit line-of-sight vector to Earth
     auto r_sym = sf.make_symbol("r");
@@ -210,28 +237,7 @@ int main(int argc, char* argv[])
     sf.declare_parameter(mu);
 
     // define halo bias parameters
-    auto b1_1 = sf.make_symbol("b1_1");
-    auto b1_2 = sf.make_symbol("b1_2");
-    auto b1_3 = sf.make_symbol("b1_3");
-
-    auto b2_2 = sf.make_symbol("b2_2");
-    auto b2_3 = sf.make_symbol("b2_3");
-
-    auto bG2_2 = sf.make_symbol("bG2_2");
-    auto bG2_3 = sf.make_symbol("bG2_3");
-
-    auto b3 = sf.make_symbol("b3");
-    auto bG3 = sf.make_symbol("bG3");
-    auto bdG2 = sf.make_symbol("bdG2");
-    auto bGamma3 = sf.make_symbol("bGamma3");
-
-    sf.declare_parameter(b1_1).declare_parameter(b1_2).declare_parameter(b1_3);
-    sf.declare_parameter(b2_2).declare_parameter(b2_3);
-    sf.declare_parameter(bG2_2).declare_parameter(bG2_3);
-    sf.declare_parameter(b3);
-    sf.declare_parameter(bG3);
-    sf.declare_parameter(bdG2);
-    sf.declare_parameter(bGamma3);
+    SPT::halo_bias bias{sf};
 
     // manufacture placeholder stochastic initial values delta*_q, delta*_s, delta*_t
     // (recall we skip delta*_r because r is also the line-of-sight variable)
@@ -239,271 +245,234 @@ int main(int argc, char* argv[])
     auto deltas = sf.make_initial_value("delta");
     auto deltat = sf.make_initial_value("delta");
 
-    // linear set is delta*_q
-    initial_value_set iv_q{deltaq};
 
-    // quadratic set is delta*_q delta*_s or delta*_s delta*_t
-    initial_value_set iv_qs{deltaq, deltas};
-    initial_value_set iv_st{deltas, deltat};
-
-    // cubic set is delta*_q delta*_s delta*_t
-    initial_value_set iv_qst{deltaq, deltas, deltat};
+    // set up momentum label k, corresponding to external momentum in 2pf
+    auto k = sf.make_symbol("k");
+    sf.declare_parameter(k);
 
-    // extract momentum vectors from these initial value placeholders
-    vector q = deltaq;
-    vector s = deltas;
-    vector t = deltat;
 
+    // checkpoints are written at the end of each stage whose outputs are self-contained; all symbols
+    // used by the model must be created before the store is constructed, because resuming restores
+    // symbol factory state.
+    // If Mathematica output is requested, the 1-loop power spectrum is needed and resuming
+    // can't skip its construction
+    checkpoint_store checkpoints{ {"delta", "deltah", "rsd", "Pk", "Pk_rsd"}, loc,
+                                  args.get_Mathematica_output().empty() ? boost::optional<std::string>{} : std::string{"Pk"} };
 
-    auto timer = std::make_unique<timing_instrument>("Construct \\delta Fourier representation");
+    auto restore_kernel = [&](fourier_kernel<3>& kernel, const std::string& label) -> void
+      {
+        auto restored = loc.make_fourier_kernel<3>(checkpoints.get_restored(), label);
+        kernel.swap(restored);
+      };
 
-    // set up kernels for the dark matter overdensity \delta
     auto delta = loc.make_fourier_kernel<3>();
+    auto phi = loc.make_fourier_kernel<3>();
+    auto deltah = loc.make_fourier_kernel<3>();
 
-    // linear order
-    delta.add(SPT::D(z), iv_q, 1);
-
-    // second order
-    // we don't symmetrize explicitly; kernels are symmetrized automatically
-    // if this feature is not disabled
-    kernel qs_base{iv_qs, loc};
-    delta.add(SPT::DA(z) * alpha(q, s, qs_base, loc));
-    delta.add(SPT::DB(z) * gamma(q, s, qs_base, loc));
-
-    // third order
-    kernel qst_base{iv_qst, loc};
-    delta.add((SPT::DD(z) - SPT::DJ(z)) * 2*gamma_bar(s+t, q, alpha_bar(s, t, qst_base, loc), loc));
-    delta.add(SPT::DE(z)                * 2*gamma_bar(s+t, q, gamma_bar(s, t, qst_base, loc), loc));
-    delta.add((SPT::DF(z) + SPT::DJ(z)) * 2*alpha_bar(s+t, q, alpha_bar(s, t, qst_base, loc), loc));
-    delta.add(SPT::DG(z)                * 2*alpha_bar(s+t, q, gamma_bar(s, t, qst_base, loc), loc));
-    delta.add(SPT::DJ(z)                * (alpha(s+t, q, gamma_bar(s, t, qst_base, loc), loc)
-                                           - 2*alpha(s+t, q, alpha_bar(s, t, qst_base, loc), loc)));
-
-    // extract different orders of \delta
-    auto delta_1 = delta.order(1);
-    auto delta_2 = delta.order(2);
-    auto delta_3 = delta.order(3);
-
-    // extract different orders of \delta^2
-    auto deltasq = delta*delta;
-    auto deltasq_2 = deltasq.order(2);
-    auto deltasq_3 = deltasq.order(3);
-
-
-    timer = std::make_unique<timing_instrument>("Construct velocity potential \\phi");
-
-    // compute kernels for the dark matter velocity potential \phi, v = grad phi -> v(k) = i k phi
-    auto phi1 = InverseLaplacian(-diff_t(delta_1));
-    auto phi2 = InverseLaplacian(-diff_t(delta_2) - delta_1*Laplacian(phi1) - gradgrad(phi1, delta_1));
-    auto phi3 = InverseLaplacian(-diff_t(delta_3)
-                                 - delta_1*Laplacian(phi2) - delta_2*Laplacian(phi1)
-                                 - gradgrad(phi1, delta_2) - gradgrad(phi2, delta_1));
-
-    auto phi = phi1 + phi2 + phi3;
-
-
-    timer = std::make_unique<timing_instrument>("Construct Galileon operators");
-
-    // build halo overdensity \delta
-    // first, need velocity potentials for the Galileon terms
-    auto Phi_delta = InverseLaplacian(delta);
-    auto Phi_v = -phi/(f*H);
-
-    auto G2 = Galileon2(Phi_delta);
-    auto G2_2 = G2.order(2);
-    auto G2_3 = G2.order(3);
-
-    auto G3 = Galileon3(Phi_delta);
-    auto Gamma3 = (Galileon2(Phi_delta) - Galileon2(Phi_v)).order(3);
-
+    if(checkpoints.resume_from("delta"))
+      {
+        restore_kernel(delta, "delta");
+      }
+    else if(checkpoints.resume_from("deltah"))
+      {
+        restore_kernel(delta, "delta");
+        restore_kernel(phi, "phi");
+        restore_kernel(deltah, "deltah");
+      }
 
-    timer = std::make_unique<timing_instrument>("Construct halo overdensity field");
+    if(!checkpoints.completed("delta"))
+      {
+        begin_stage("Construct \\delta Fourier representation");
 
-    auto vp1 = phi1 / (H*f);
-    auto vp2 = phi2 / (H*f);
+        // set up kernels for the dark matter overdensity \delta
+        auto delta_sum = SPT::dark_matter_overdensity(deltaq, deltas, deltat, loc);
+        delta.swap(delta_sum);
 
-    auto deltah_b1 = b1_1*delta_1 + b1_2*delta_2 + b1_3*delta_3;
+        stats.add("delta", delta);
 
-    auto deltah_b1_adv = - (b1_1 - b1_2) * gradgrad(vp1, delta_1)
-                         - (b1_2 - b1_3) * gradgrad(vp1, delta_2)
-                         - (b1_1 - b1_3) * gradgrad(vp2, delta_1) / 2
-                         + ((b1_1 + b1_3) / 2 - b1_2) * convective_bias_term(vp1, delta_1);
+        auto ckpt = checkpoints.make_checkpoint("delta");
+        delta.archive(ckpt, "delta");
+        checkpoints.commit(ckpt);
+      }
 
-    auto deltah_b2 = (b2_2/2)*deltasq_2 + (b2_3/2)*deltasq_3;
+    if(!checkpoints.completed("deltah"))
+      {
+        begin_stage("Construct velocity potential \\phi");
 
-    auto deltah_b2_adv = - (b2_2/2-b2_3/2) * gradgrad(vp1, deltasq_2);
+        // compute kernels for the dark matter velocity potential \phi
+        auto phi_sum = SPT::velocity_potential(delta);
+        phi.swap(phi_sum);
 
-    auto deltah_G2 = bG2_2*G2_2 + bG2_3*G2_3;
+        stats.add("phi", phi);
 
-    auto deltah_G2_adv = - (bG2_2 - bG2_3) * gradgrad(vp1, G2_2);
 
-    auto deltah_cubic = (b3/6)*delta*delta*delta + bdG2*G2*delta + bG3*G3 + bGamma3*Gamma3;
+        begin_stage("Construct halo overdensity field");
 
-    auto deltah = deltah_b1 + deltah_b1_adv + deltah_b2 + deltah_b2_adv + deltah_G2 + deltah_G2_adv + deltah_cubic;
+        auto deltah_sum = SPT::halo_overdensity(delta, phi, bias, loc);
+        deltah.swap(deltah_sum);
 
+        stats.add("deltah", deltah);
 
-    // set up momentum label k, corresponding to external momentum in 2pf
-    auto k = sf.make_symbol("k");
-    sf.declare_parameter(k);
+        // phi is retained, because it is needed for the redshift-space transformation
+        auto ckpt = checkpoints.make_checkpoint("deltah");
+        delta.archive(ckpt, "delta");
+        phi.archive(ckpt, "phi");
+        deltah.archive(ckpt, "deltah");
+        checkpoints.commit(ckpt);
+      }
 
 
     // build expression for the redshift-space overdensities,
     // for both dark matter and halos
 
-    // utility function to perform the redshift-space transformation
-    // note that we don't have to adjust r_dot_v for the halo power spectrum, so it can just be
-    // captured from the exterior scope.
-    // Of course, delta has to be adjusted.
-    auto r_dot_v = dotgrad(r, phi);
-    auto make_delta_rsd = [&](const auto& kmu, const auto& d) -> auto
-      {
-        return d
-               - (GiNaC::I / H) * kmu * r_dot_v
-               - (GiNaC::I / H) * kmu * (r_dot_v * d)
-               - (GiNaC::numeric{1} / (2*H*H)) * kmu*kmu * (r_dot_v * r_dot_v)
-               - (GiNaC::numeric{1} / (2*H*H)) * kmu*kmu * (r_dot_v * r_dot_v * d)
-               + (GiNaC::I / (3*2*H*H*H)) * kmu*kmu*kmu * (r_dot_v * r_dot_v * r_dot_v);
-      };
-
-    // dark matter in redshift-space
     auto k1mu = k*mu;
     auto k2mu = -k*mu;
 
-    timer = std::make_unique<timing_instrument>("RSD transform for dark matter overdensity");
-    auto delta_rsd_k1 = make_delta_rsd(k1mu, delta);
-    auto delta_rsd_k2 = make_delta_rsd(k2mu, delta);
+    auto deltah_rsd_k1 = loc.make_fourier_kernel<3>();
+    auto deltah_rsd_k2 = loc.make_fourier_kernel<3>();
 
-    // halos in redshift-space
-    timer = std::make_unique<timing_instrument>("RSD transform for halo overdensity");
-    auto deltah_rsd_k1 = make_delta_rsd(k1mu, deltah);
-    auto deltah_rsd_k2 = make_delta_rsd(k2mu, deltah);
+    if(checkpoints.resume_from("rsd"))
+      {
+        restore_kernel(deltah_rsd_k1, "deltah_rsd_k1");
+        restore_kernel(deltah_rsd_k2, "deltah_rsd_k2");
+      }
+    else if(!checkpoints.completed("rsd"))
+      {
+        // r_dot_v doesn't have to be adjusted for the halo power spectrum, so it is shared between
+        // dark matter and halos; of course, delta has to be adjusted
+        auto r_dot_v = dotgrad(r, phi);
+
+        // dark matter in redshift-space
+        begin_stage("RSD transform for dark matter overdensity");
+        auto delta_rsd_k1 = SPT::redshift_space_overdensity(delta, r_dot_v, k1mu, loc);
+        auto delta_rsd_k2 = SPT::redshift_space_overdensity(delta, r_dot_v, k2mu, loc);
+
+        stats.add("delta_rsd_k1", delta_rsd_k1);
+
+        // halos in redshift-space
+        begin_stage("RSD transform for halo overdensity");
+        auto rsd_k1 = SPT::redshift_space_overdensity(deltah, r_dot_v, k1mu, loc);
+        auto rsd_k2 = SPT::redshift_space_overdensity(deltah, r_dot_v, k2mu, loc);
+        deltah_rsd_k1.swap(rsd_k1);
+        deltah_rsd_k2.swap(rsd_k2);
+
+        stats.add("deltah_rsd_k1", deltah_rsd_k1);
+
+        auto ckpt = checkpoints.make_checkpoint("rsd");
+        deltah_rsd_k1.archive(ckpt, "deltah_rsd_k1");
+        deltah_rsd_k2.archive(ckpt, "deltah_rsd_k2");
+        checkpoints.commit(ckpt);
+      }
 
     // construct 1-loop \delta power spectrum
-    timer = std::make_unique<timing_instrument>("Construct 1-loop power spectrum");
-    Pk_one_loop Pk_delta{"1-loop halo RSD P(k)", "halo", deltah_rsd_k1, deltah_rsd_k2, k, loc};
+    std::unique_ptr<Pk_one_loop> Pk_delta;
 
-    // simplify mu-dependence
-    Pk_delta.canonicalize_external_momenta();
-    Pk_delta.simplify(GiNaC::exmap{ {Angular::Cos(k,r_sym), mu} });
+    if(checkpoints.resume_from("Pk"))
+      {
+        Pk_delta = std::make_unique<Pk_one_loop>(checkpoints.get_restored(), "Pk_delta", loc);
+      }
+    else if(!checkpoints.completed("Pk"))
+      {
+        begin_stage("Construct 1-loop power spectrum");
+        Pk_delta = std::make_unique<Pk_one_loop>("1-loop halo RSD P(k)", "halo", deltah_rsd_k1, deltah_rsd_k2, k, loc);
 
-    // remove unwanted r factors, which are equal to unity (r is a unit vector)
-    Pk_delta.simplify(GiNaC::exmap{ {r_sym, GiNaC::ex{1}} });
+        // simplify mu-dependence, and remove factors of the unit vector r
+        SPT::simplify_line_of_sight(*Pk_delta, k, r_sym, mu);
+
+        stats.add("Pk_delta", *Pk_delta);
+
+        auto ckpt = checkpoints.make_checkpoint("Pk");
+        Pk_delta->archive(ckpt, "Pk_delta");
+        checkpoints.commit(ckpt);
+      }
 
     if(!args.get_Mathematica_output().empty())
       {
         std::ofstream mma_out{args.get_Mathematica_output().string(), std::ios_base::out | std::ios_base::trunc};
-        Pk_delta.write_Mathematica(mma_out);
+        Pk_delta->write_Mathematica(mma_out);
         mma_out.close();
       }
 
-//    auto& tree = Pk_delta.get_tree();
+//    auto& tree = Pk_delta->get_tree();
 //    std::cout << "Tree-level P(k):" << '\n';
 //    std::cout << tree << '\n';
 
-//    auto& P13 = Pk_delta.get_13();
+//    auto& P13 = Pk_delta->get_13();
 //    std::cout << "Loop-level 13 P(k):" << '\n';
 //    std::cout << P13 << '\n';
 
-//    auto& P22 = Pk_delta.get_22();
+//    auto& P22 = Pk_delta->get_22();
 //    std::cout << "Loop-level 22 P(k):" << '\n';
 //    std::cout << P22 << '\n';
 
 
     // break result into powers of mu, grouped by the bias coefficients involved
-    GiNaC_symbol_set filter_syms{b1_1, b1_2, b1_3, b2_2, b2_3, b3, bG2_2, bG2_3, bdG2, bG3, bGamma3};
-
-    timer = std::make_unique<timing_instrument>("Extract RSD mu coefficients");
+    GiNaC_symbol_set filter_syms = bias.get_symbols();
 
-    Pk_rsd Pk_nobias{Pk_delta, mu, filter_list{}, filter_syms};
+    std::unique_ptr<Pk_rsd_set_builder> builder;
 
-    Pk_rsd Pk_b1_1{Pk_delta, mu, filter_list{ {b1_1,1} }, filter_syms};
-    Pk_rsd Pk_b1_2{Pk_delta, mu, filter_list{ {b1_2,1} }, filter_syms};
-    Pk_rsd Pk_b1_3{Pk_delta, mu, filter_list{ {b1_3,1} }, filter_syms};
-
-    Pk_rsd Pk_b2_2{Pk_delta, mu, filter_list{ {b2_2,1} }, filter_syms};
-    Pk_rsd Pk_b2_3{Pk_delta, mu, filter_list{ {b2_3,1} }, filter_syms};
-
-    Pk_rsd Pk_bG2_2{Pk_delta, mu, filter_list{ {bG2_2,1} }, filter_syms};
-    Pk_rsd Pk_bG2_3{Pk_delta, mu, filter_list{ {bG2_3,1} }, filter_syms};
-
-    Pk_rsd Pk_b3{Pk_delta, mu, filter_list{ {b3,1} }, filter_syms};
-    Pk_rsd Pk_bG3{Pk_delta, mu, filter_list{ {bG3,1} }, filter_syms};                           // zero
-    Pk_rsd Pk_bdG2{Pk_delta, mu, filter_list{ {bdG2,1} }, filter_syms};
-    Pk_rsd Pk_bGamma3{Pk_delta, mu, filter_list{ {bGamma3,1} }, filter_syms};
-
-    Pk_rsd Pk_b1_1_b1_1{Pk_delta, mu, filter_list{ {b1_1,2} }, filter_syms};
-    Pk_rsd Pk_b1_2_b1_2{Pk_delta, mu, filter_list{ {b1_2,2} }, filter_syms};
-    Pk_rsd Pk_b1_1_b1_2{Pk_delta, mu, filter_list{ {b1_1,1}, {b1_2,1} }, filter_syms};
-    Pk_rsd Pk_b1_1_b1_3{Pk_delta, mu, filter_list{ {b1_1,1}, {b1_3,1} }, filter_syms};
-
-    Pk_rsd Pk_b1_1_b2_2{Pk_delta, mu, filter_list{ {b1_1,1}, {b2_2,1} }, filter_syms};
-    Pk_rsd Pk_b1_1_b2_3{Pk_delta, mu, filter_list{ {b1_1,1}, {b2_3,1} }, filter_syms};
-    Pk_rsd Pk_b1_2_b2_2{Pk_delta, mu, filter_list{ {b1_2,1}, {b2_2,1} }, filter_syms};
-
-    Pk_rsd Pk_b1_1_b3{Pk_delta, mu, filter_list{ {b1_1,1}, {b3,1} }, filter_syms};
-
-    Pk_rsd Pk_b2_2_b2_2{Pk_delta, mu, filter_list{ {b2_2,2} }, filter_syms};
-
-    Pk_rsd Pk_b1_1_bG2_2{Pk_delta, mu, filter_list{ {b1_1,1}, {bG2_2,1} }, filter_syms};
-    Pk_rsd Pk_b1_1_bG2_3{Pk_delta, mu, filter_list{ {b1_1,1}, {bG2_3,1} }, filter_syms};
-    Pk_rsd Pk_b1_2_bG2_2{Pk_delta, mu, filter_list{ {b1_2,1}, {bG2_2,1} }, filter_syms};
-
-    Pk_rsd Pk_bG2_2_bG2_2{Pk_delta, mu, filter_list{ {bG2_2,2} }, filter_syms};
-
-    Pk_rsd Pk_b2_2_bG2_2{Pk_delta, mu, filter_list{ {b2_2,1}, {bG2_2,1} }, filter_syms};
+    if(checkpoints.resume_from("Pk_rsd"))
+      {
+        builder = std::make_unique<Pk_rsd_set_builder>(checkpoints.get_restored(), "Pk_rsd", loc);
+      }
+    else
+      {
+        begin_stage("Extract RSD mu coefficients");
 
-    Pk_rsd Pk_b1_1_bG3{Pk_delta, mu, filter_list{ {b1_1,1}, {bG3,1} }, filter_syms};            // zero
+        builder = std::make_unique<Pk_rsd_set_builder>(*Pk_delta, mu, filter_syms);
 
-    Pk_rsd Pk_b1_1_bdG2{Pk_delta, mu, filter_list{ {b1_1,1}, {bdG2,1} }, filter_syms};
+        // bG3 and b1_1 bG3 contributions vanish and are not requested
+        builder->add("nobias", filter_list{});
 
-    Pk_rsd Pk_b1_1_bGamma3{Pk_delta, mu, filter_list{ {b1_1,1}, {bGamma3,1} }, filter_syms};
+        builder->add("b1_1", filter_list{ {bias.b1_1,1} });
+        builder->add("b1_2", filter_list{ {bias.b1_2,1} });
+        builder->add("b1_3", filter_list{ {bias.b1_3,1} });
 
-    timer.reset(nullptr);
+        builder->add("b2_2", filter_list{ {bias.b2_2,1} });
+        builder->add("b2_3", filter_list{ {bias.b2_3,1} });                            // set to zero in 'full' fit; degenerate with 1-loop renormalization of b1_1
 
+        builder->add("bG2_2", filter_list{ {bias.bG2_2,1} });
+        builder->add("bG2_3", filter_list{ {bias.bG2_3,1} });
 
-    Pk_rsd_set Pks =
-      {
-        {"nobias", std::ref(Pk_nobias)},
+        builder->add("b3", filter_list{ {bias.b3,1} });                                // set to zero in 'full' fit; degenerate with 1-loop renormalization of b1_1
+        builder->add("bdG2", filter_list{ {bias.bdG2,1} });                            // set to zero in 'full' fit; degenerate with 1-loop renormalization of b1_1
+        builder->add("bGamma3", filter_list{ {bias.bGamma3,1} });                      // set to zero in 'full' fit: degenerate with bG2_3 and an associated 1-loop renormalization of b1_1
 
-        {"b1_1", std::ref(Pk_b1_1)},
-        {"b1_2", std::ref(Pk_b1_2)},
-        {"b1_3", std::ref(Pk_b1_3)},
+        builder->add("b1_1_b1_1", filter_list{ {bias.b1_1,2} });
+        builder->add("b1_2_b1_2", filter_list{ {bias.b1_2,2} });
+        builder->add("b1_1_b1_2", filter_list{ {bias.b1_1,1}, {bias.b1_2,1} });
+        builder->add("b1_1_b1_3", filter_list{ {bias.b1_1,1}, {bias.b1_3,1} });
 
-        {"b2_2", std::ref(Pk_b2_2)},
-        {"b2_3", std::ref(Pk_b2_3)},                    // set to zero in 'full' fit; degenerate with 1-loop renormalization of b1_1
+        builder->add("b1_1_b2_2", filter_list{ {bias.b1_1,1}, {bias.b2_2,1} });
+        builder->add("b1_1_b2_3", filter_list{ {bias.b1_1,1}, {bias.b2_3,1} });        // set to zero in 'full' fit; b2_3 degenerate as explained above
+        builder->add("b1_2_b2_2", filter_list{ {bias.b1_2,1}, {bias.b2_2,1} });
 
-        {"bG2_2", std::ref(Pk_bG2_2)},
-        {"bG2_3", std::ref(Pk_bG2_3)},
+        builder->add("b1_1_b3", filter_list{ {bias.b1_1,1}, {bias.b3,1} });            // set to zero in 'full' fit; b3 degenerate as explained above
 
-        {"b3", std::ref(Pk_b3)},                        // set to zero in 'full' fit; degenerate with 1-loop renormalization of b1_1
-        {"bdG2", std::ref(Pk_bdG2)},                    // set to zero in 'full' fit; degenerate with 1-loop renormalization of b1_1
-        {"bGamma3", std::ref(Pk_bGamma3)},              // set to zero in 'full' fit: degenerate with bG2_3 and an associated 1-loop renormalization of b1_1
+        builder->add("b2_2_b2_2", filter_list{ {bias.b2_2,2} });
 
-        {"b1_1_b1_1", std::ref(Pk_b1_1_b1_1)},
-        {"b1_2_b1_2", std::ref(Pk_b1_2_b1_2)},
-        {"b1_1_b1_2", std::ref(Pk_b1_1_b1_2)},
-        {"b1_1_b1_3", std::ref(Pk_b1_1_b1_3)},
+        builder->add("b1_1_bG2_2", filter_list{ {bias.b1_1,1}, {bias.bG2_2,1} });
+        builder->add("b1_1_bG2_3", filter_list{ {bias.b1_1,1}, {bias.bG2_3,1} });
+        builder->add("b1_2_bG2_2", filter_list{ {bias.b1_2,1}, {bias.bG2_2,1} });
 
-        {"b1_1_b2_2", std::ref(Pk_b1_1_b2_2)},
-        {"b1_1_b2_3", std::ref(Pk_b1_1_b2_3)},          // set to zero in 'full' fit; b2_3 degenerate as explained above
-        {"b1_2_b2_2", std::ref(Pk_b1_2_b2_2)},
+        builder->add("bG2_2_bG2_2", filter_list{ {bias.bG2_2,2} });
 
-        {"b1_1_b3", std::ref(Pk_b1_1_b3)},              // set to zero in 'full' fit; b3 degenerate as explained above
+        builder->add("b2_2_bG2_2", filter_list{ {bias.b2_2,1}, {bias.bG2_2,1} });
 
-        {"b2_2_b2_2", std::ref(Pk_b2_2_b2_2)},
+        builder->add("b1_1_bdG2", filter_list{ {bias.b1_1,1}, {bias.bdG2,1} });        // set to zero in 'full' fit; bdG2 degenerate as explained above
 
-        {"b1_1_bG2_2", std::ref(Pk_b1_1_bG2_2)},
-        {"b1_1_bG2_3", std::ref(Pk_b1_1_bG2_3)},
-        {"b1_2_bG2_2", std::ref(Pk_b1_2_bG2_2)},
+        builder->add("b1_1_bGamma3", filter_list{ {bias.b1_1,1}, {bias.bGamma3,1} });  // set to zero in 'full' fit; bGamma3 degenerate as explained above
 
-        {"bG2_2_bG2_2", std::ref(Pk_bG2_2_bG2_2)},
+        auto ckpt = checkpoints.make_checkpoint("Pk_rsd");
+        builder->archive(ckpt, "Pk_rsd");
+        checkpoints.commit(ckpt);
+      }
 
-        {"b2_2_bG2_2", std::ref(Pk_b2_2_bG2_2)},
+    end_stage();
 
-        {"b1_1_bdG2", std::ref(Pk_b1_1_bdG2)},          // set to zero in 'full' fit; bdG2 degenerate as explained above
+    Pk_rsd_set Pks = builder->get();
 
-        {"b1_1_bGamma3", std::ref(Pk_b1_1_bGamma3)}     // set to zero in 'full' fit; bGamma3 degenerate as explained above
-      };
+    stats.add("Pks", Pks);
 
     if(args.get_counterterms())
       {
@@ -519,12 +488,20 @@ int main(int argc, char* argv[])
 
     if(!args.get_output_path().empty())
       {
+        begin_stage("Write backend output");
+
         LSSEFT backend{args.get_output_path(), loc};
         backend.add(Pks);
 
         backend.write();
+
+        end_stage();
       }
 
+    if(!args.get_profile_report().empty()) profiler::instance().write_report(args.get_profile_report());
+    if(!args.get_profile_trace().empty()) profiler::instance().write_trace(args.get_profile_trace());
+    if(!args.get_memory_report().empty()) stats.write(args.get_memory_report());
+
 
     return EXIT_SUCCESS;
   }
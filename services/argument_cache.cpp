@@ -26,6 +26,7 @@
 
 
 #include <iostream>
+#include <algorithm>
 
 #include "argument_cache.h"
 #include "switches.h"
@@ -50,16 +51,42 @@ argument_cache::argument_cache(int argc, char**& argv)
       (SWITCH_22_SYMMETRIZE, HELP_22_SYMMETRIZE)
       ;
 
+    boost::program_options::options_description performance{"Performance"};
+    performance.add_options()
+      (SWITCH_WORKERS, boost::program_options::value<unsigned int>(), HELP_WORKERS)
+      (SWITCH_MEMOIZE_KERNELS, HELP_MEMOIZE_KERNELS)
+      (SWITCH_PARALLEL_BACKEND, HELP_PARALLEL_BACKEND)
+      (SWITCH_PROFILE_REPORT, boost::program_options::value<std::string>(), HELP_PROFILE_REPORT)
+      (SWITCH_PROFILE_TRACE, boost::program_options::value<std::string>(), HELP_PROFILE_TRACE)
+      (SWITCH_MEMORY_REPORT, boost::program_options::value<std::string>(), HELP_MEMORY_REPORT)
+      ;
+
     boost::program_options::options_description backend{"Backend control"};
     backend.add_options()
       (SWITCH_COUNTERTERMS, HELP_COUNTERTERMS)
+      (SWITCH_CSE, HELP_CSE)
+      (SWITCH_NVEC, boost::program_options::value<unsigned int>(), HELP_NVEC)
+      (SWITCH_FUSE_KERNELS, HELP_FUSE_KERNELS)
+      (SWITCH_MASTER_INTEGRALS, HELP_MASTER_INTEGRALS)
+      (SWITCH_HORNER, HELP_HORNER)
+      (SWITCH_INTEGRAND_SHARDS, boost::program_options::value<unsigned int>(), HELP_INTEGRAND_SHARDS)
+      (SWITCH_SHARD_BYTES, boost::program_options::value<size_t>(), HELP_SHARD_BYTES)
       (SWITCH_OUTPUT, boost::program_options::value<std::string>(), HELP_OUTPUT)
       (SWITCH_MATHEMATICA_OUTPUT, boost::program_options::value<std::string>(), HELP_MATHEMATICA_OUTPUT)
       ;
 
+    boost::program_options::options_description checkpointing{"Checkpointing"};
+    checkpointing.add_options()
+      (SWITCH_CHECKPOINT_DIR, boost::program_options::value<std::string>(), HELP_CHECKPOINT_DIR)
+      (SWITCH_RESUME, HELP_RESUME)
+      (SWITCH_INTEGRAL_CACHE, boost::program_options::value<std::string>(), HELP_INTEGRAL_CACHE)
+      (SWITCH_INTEGRAL_CACHE_SIZE, boost::program_options::value<unsigned int>(), HELP_INTEGRAL_CACHE_SIZE)
+      ;
+
     boost::program_options::options_description backend_hidden{"Hidden backed control options"};
     backend_hidden.add_options()
       (SWITCH_NO_COUNTERTERMS, "")
+      (SWITCH_NO_CSE, "")
       ;
 
     boost::program_options::options_description expressions_hidden{"Hidden expression options"};
@@ -69,10 +96,10 @@ argument_cache::argument_cache(int argc, char**& argv)
       ;
 
     boost::program_options::options_description cmdline_options;
-    cmdline_options.add(generic).add(expressions).add(expressions_hidden).add(backend);
+    cmdline_options.add(generic).add(expressions).add(expressions_hidden).add(performance).add(checkpointing).add(backend).add(backend_hidden);
 
     boost::program_options::options_description output_options;
-    output_options.add(generic).add(expressions).add(backend);
+    output_options.add(generic).add(expressions).add(performance).add(checkpointing).add(backend);
 
     boost::program_options::variables_map option_map;
     boost::program_options::store(boost::program_options::parse_command_line(argc, argv, cmdline_options), option_map);
@@ -101,6 +128,21 @@ argument_cache::argument_cache(int argc, char**& argv)
     if(option_map.count(SWITCH_COUNTERTERMS))       this->counterterms = true;
     if(option_map.count(SWITCH_NO_COUNTERTERMS))    this->counterterms = false;
 
+    if(option_map.count(SWITCH_CSE))                this->cse = true;
+    if(option_map.count(SWITCH_NO_CSE))             this->cse = false;
+
+    if(option_map.count(SWITCH_NVEC))               this->nvec = std::max(option_map[SWITCH_NVEC].as<unsigned int>(), 1U);
+    if(option_map.count(SWITCH_FUSE_KERNELS))       this->fuse_kernels = true;
+    if(option_map.count(SWITCH_MASTER_INTEGRALS))   this->master_integrals = true;
+    if(option_map.count(SWITCH_HORNER))             this->horner = true;
+
+    if(option_map.count(SWITCH_INTEGRAND_SHARDS))   this->integrand_shards = std::max(option_map[SWITCH_INTEGRAND_SHARDS].as<unsigned int>(), 1U);
+    if(option_map.count(SWITCH_SHARD_BYTES))        this->integrand_shard_bytes = option_map[SWITCH_SHARD_BYTES].as<size_t>();
+
+    if(option_map.count(SWITCH_WORKERS_LONG))       this->workers = option_map[SWITCH_WORKERS_LONG].as<unsigned int>();
+    if(option_map.count(SWITCH_MEMOIZE_KERNELS))    this->memoize_kernels = true;
+    if(option_map.count(SWITCH_PARALLEL_BACKEND))   this->parallel_backend = true;
+
     if(option_map.count(SWITCH_OUTPUT_LONG))
       {
         boost::filesystem::path outpath = option_map[SWITCH_OUTPUT_LONG].as<std::string>();
@@ -116,6 +158,51 @@ argument_cache::argument_cache(int argc, char**& argv)
 
         this->output_mma = std::move(outpath);
       }
+
+    if(option_map.count(SWITCH_PROFILE_REPORT))
+      {
+        boost::filesystem::path outpath = option_map[SWITCH_PROFILE_REPORT].as<std::string>();
+        if(!outpath.is_absolute()) outpath = boost::filesystem::absolute(outpath);
+
+        this->profile_report = std::move(outpath);
+      }
+
+    if(option_map.count(SWITCH_PROFILE_TRACE))
+      {
+        boost::filesystem::path outpath = option_map[SWITCH_PROFILE_TRACE].as<std::string>();
+        if(!outpath.is_absolute()) outpath = boost::filesystem::absolute(outpath);
+
+        this->profile_trace = std::move(outpath);
+      }
+
+    if(option_map.count(SWITCH_MEMORY_REPORT))
+      {
+        boost::filesystem::path outpath = option_map[SWITCH_MEMORY_REPORT].as<std::string>();
+        if(!outpath.is_absolute()) outpath = boost::filesystem::absolute(outpath);
+
+        this->memory_report = std::move(outpath);
+      }
+
+    if(option_map.count(SWITCH_CHECKPOINT_DIR))
+      {
+        boost::filesystem::path outpath = option_map[SWITCH_CHECKPOINT_DIR].as<std::string>();
+        if(!outpath.is_absolute()) outpath = boost::filesystem::absolute(outpath);
+
+        this->checkpoint_dir = std::move(outpath);
+      }
+
+    if(option_map.count(SWITCH_RESUME))             this->resume = true;
+
+    if(option_map.count(SWITCH_INTEGRAL_CACHE))
+      {
+        boost::filesystem::path outpath = option_map[SWITCH_INTEGRAL_CACHE].as<std::string>();
+        if(!outpath.is_absolute()) outpath = boost::filesystem::absolute(outpath);
+
+        this->integral_cache = std::move(outpath);
+      }
+
+    if(option_map.count(SWITCH_INTEGRAL_CACHE_SIZE))
+      this->integral_cache_size = static_cast<size_t>(option_map[SWITCH_INTEGRAL_CACHE_SIZE].as<unsigned int>()) * 1024 * 1024;
   }
 
 
@@ -131,6 +218,24 @@ bool argument_cache::get_symmetrize_22() const
   }
 
 
+unsigned int argument_cache::get_workers() const
+  {
+    return this->workers;
+  }
+
+
+bool argument_cache::get_memoize_kernels() const
+  {
+    return this->memoize_kernels;
+  }
+
+
+bool argument_cache::get_parallel_backend() const
+  {
+    return this->parallel_backend;
+  }
+
+
 const boost::filesystem::path& argument_cache::get_output_path() const
   {
     return this->output_root;
@@ -143,9 +248,91 @@ bool argument_cache::get_counterterms() const
   }
 
 
+bool argument_cache::get_cse() const
+  {
+    return this->cse;
+  }
+
+
+unsigned int argument_cache::get_nvec() const
+  {
+    return this->nvec;
+  }
+
+
+bool argument_cache::get_fuse_kernels() const
+  {
+    return this->fuse_kernels;
+  }
+
+
+bool argument_cache::get_master_integrals() const
+  {
+    return this->master_integrals;
+  }
+
+
+bool argument_cache::get_horner() const
+  {
+    return this->horner;
+  }
+
+
+unsigned int argument_cache::get_integrand_shards() const
+  {
+    return this->integrand_shards;
+  }
+
+
+size_t argument_cache::get_integrand_shard_bytes() const
+  {
+    return this->integrand_shard_bytes;
+  }
+
+
 const boost::filesystem::path& argument_cache::get_Mathematica_output() const
   {
     return this->output_mma;
   }
 
 
+const boost::filesystem::path& argument_cache::get_profile_report() const
+  {
+    return this->profile_report;
+  }
+
+
+const boost::filesystem::path& argument_cache::get_profile_trace() const
+  {
+    return this->profile_trace;
+  }
+
+
+const boost::filesystem::path& argument_cache::get_memory_report() const
+  {
+    return this->memory_report;
+  }
+
+
+const boost::filesystem::path& argument_cache::get_checkpoint_dir() const
+  {
+    return this->checkpoint_dir;
+  }
+
+
+bool argument_cache::get_resume() const
+  {
+    return this->resume;
+  }
+
+
+const boost::filesystem::path& argument_cache::get_integral_cache() const
+  {
+    return this->integral_cache;
+  }
+
+
+size_t argument_cache::get_integral_cache_size() const
+  {
+    return this->integral_cache_size;
+  }
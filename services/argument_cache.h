@@ -56,12 +56,63 @@ class argument_cache
     //! get symmetrize-22 status
     bool get_symmetrize_22() const;
 
+    //! get number of worker processes; zero means use all available cores
+    unsigned int get_workers() const;
+
+    //! get Fourier kernel memoization status
+    bool get_memoize_kernels() const;
+
+    //! get parallel backend status
+    bool get_parallel_backend() const;
+
+    //! get common-subexpression elimination status
+    bool get_cse() const;
+
+    //! get number of sample points evaluated per call by batched integrands; 1 means scalar integrands
+    unsigned int get_nvec() const;
+
+    //! get kernel fusion status
+    bool get_fuse_kernels() const;
+
+    //! get master-integral mode status
+    bool get_master_integrals() const;
+
+    //! get Horner-form emission status
+    bool get_horner() const;
+
+    //! get number of translation units for kernel integrands
+    unsigned int get_integrand_shards() const;
+
+    //! get target size of each translation unit for kernel integrands; zero means no target
+    size_t get_integrand_shard_bytes() const;
+
     //! get output root
     const boost::filesystem::path& get_output_path() const;
 
     //! get mathematica output
     const boost::filesystem::path& get_Mathematica_output() const;
 
+    //! get destination for JSON profiling report; empty if no report is required
+    const boost::filesystem::path& get_profile_report() const;
+
+    //! get destination for Chrome trace-event profile; empty if no trace is required
+    const boost::filesystem::path& get_profile_trace() const;
+
+    //! get destination for JSON memory and expression-size summary; empty if no summary is required
+    const boost::filesystem::path& get_memory_report() const;
+
+    //! get directory for stage checkpoints; empty if checkpoints are not required
+    const boost::filesystem::path& get_checkpoint_dir() const;
+
+    //! get resume status
+    bool get_resume() const;
+
+    //! get directory for persistent angular reduction cache; empty if the cache is not required
+    const boost::filesystem::path& get_integral_cache() const;
+
+    //! get maximum size (in bytes) of persistent angular reduction cache
+    size_t get_integral_cache_size() const;
+
 
     // INTERNAL DATA
 
@@ -76,6 +127,18 @@ class argument_cache
     bool symmetrize_22{true};
 
 
+    // PERFORMANCE
+
+    //! number of worker processes
+    unsigned int workers{1};
+
+    //! memoize Fourier kernel operations?
+    bool memoize_kernels{false};
+
+    //! render kernel integrands in the worker processes?
+    bool parallel_backend{false};
+
+
     // BACKEND
 
     //! generate counterterm list?
@@ -85,12 +148,57 @@ class argument_cache
 
   private:
 
+    //! eliminate common subexpressions in generated integrands?
+    bool cse{true};
+
+    //! number of sample points per integrand call
+    unsigned int nvec{1};
+
+    //! fuse compatible kernels into multi-component integrands?
+    bool fuse_kernels{false};
+
+    //! decompose kernels into a basis of master integrals?
+    bool master_integrals{false};
+
+    //! emit kernel integrands in Horner form?
+    bool horner{false};
+
+    //! number of translation units for kernel integrands
+    unsigned int integrand_shards{1};
+
+    //! target size (in bytes) of translation units for kernel integrands
+    size_t integrand_shard_bytes{0};
+
     //! root for output file
     boost::filesystem::path output_root;
 
     //! root for output of Mathematica integrals
     boost::filesystem::path output_mma;
 
+    //! destination for JSON profiling report
+    boost::filesystem::path profile_report;
+
+    //! destination for Chrome trace-event profile
+    boost::filesystem::path profile_trace;
+
+    //! destination for memory and expression-size summary
+    boost::filesystem::path memory_report;
+
+
+    // CHECKPOINTING
+
+    //! directory for stage checkpoints
+    boost::filesystem::path checkpoint_dir;
+
+    //! resume from latest usable checkpoint?
+    bool resume{false};
+
+    //! directory for persistent angular reduction cache
+    boost::filesystem::path integral_cache;
+
+    //! maximum size (in bytes) of persistent angular reduction cache
+    size_t integral_cache_size{size_t(1024) * 1024 * 1024};
+
   };
 
 
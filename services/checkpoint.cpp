@@ -0,0 +1,363 @@
+//
+// Created by David Seery on 10/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "checkpoint.h"
+
+#include "utilities/stable_hash.h"
+
+#include "shared/exceptions.h"
+#include "localizations/messages.h"
+
+#include "boost/filesystem/operations.hpp"
+
+
+namespace checkpoint_impl
+  {
+
+    //! identifying string at the start of every checkpoint file
+    constexpr auto magic = "LSSEFT-analytic checkpoint";
+
+    //! version of the on-disk format; increment whenever the layout of the header, or the archived
+    //! representation of any object, changes
+    constexpr unsigned int format_version = 1;
+
+
+    //! escape a string so that it occupies a single line of the header
+    static std::string escape(const std::string& str)
+      {
+        std::string out;
+        out.reserve(str.size());
+
+        for(char c : str)
+          {
+            switch(c)
+              {
+                case '\\': out += "\\\\"; break;
+                case '\n': out += "\\n"; break;
+                case '\t': out += "\\t"; break;
+                default: out += c;
+              }
+          }
+
+        return out;
+      }
+
+
+    //! undo escaping
+    static std::string unescape(const std::string& str)
+      {
+        std::string out;
+        out.reserve(str.size());
+
+        for(size_t i = 0; i < str.size(); ++i)
+          {
+            if(str[i] != '\\' || i+1 == str.size())
+              {
+                out += str[i];
+                continue;
+              }
+
+            switch(str[++i])
+              {
+                case 'n': out += '\n'; break;
+                case 't': out += '\t'; break;
+                default: out += str[i];
+              }
+          }
+
+        return out;
+      }
+
+
+    //! raise an exception reporting a badly formed checkpoint
+    [[noreturn]] static void badly_formed(const boost::filesystem::path& p, const std::string& detail)
+      {
+        std::ostringstream msg;
+        msg << ERROR_CHECKPOINT_BADLY_FORMED << " '" << p.string() << "' (" << detail << ")";
+        throw exception(msg.str(), exception_code::checkpoint_error);
+      }
+
+
+    //! read a header line of the form '<label> <value>' and return the value
+    static std::string read_field(std::istream& in, const std::string& label, const boost::filesystem::path& p)
+      {
+        std::string line;
+        if(!std::getline(in, line)) badly_formed(p, "missing " + label);
+
+        if(line.compare(0, label.size()+1, label + " ") != 0) badly_formed(p, "missing " + label);
+
+        return line.substr(label.size()+1);
+      }
+
+  }   // namespace checkpoint_impl
+
+
+checkpoint::checkpoint(std::string st_, std::string ih_)
+  : stage(std::move(st_)),
+    input_hash(std::move(ih_))
+  {
+  }
+
+
+checkpoint::checkpoint(const boost::filesystem::path& p)
+  {
+    using checkpoint_impl::read_field;
+    using checkpoint_impl::badly_formed;
+
+    std::ifstream in{p.string(), std::ios_base::in | std::ios_base::binary};
+    if(!in)
+      {
+        std::ostringstream msg;
+        msg << ERROR_CHECKPOINT_OPEN_FAILED << " '" << p.string() << "'";
+        throw exception(msg.str(), exception_code::checkpoint_error);
+      }
+
+    std::string line;
+    if(!std::getline(in, line) || line != checkpoint_impl::magic) badly_formed(p, "not a checkpoint");
+
+    if(read_field(in, "format", p) != std::to_string(checkpoint_impl::format_version))
+      badly_formed(p, "unsupported format version");
+
+    this->stage = checkpoint_impl::unescape(read_field(in, "stage", p));
+    this->input_hash = read_field(in, "input", p);
+
+    // read metadata strings
+    size_t num_strings = 0;
+    size_t payload_size = 0;
+    std::string checksum;
+
+    try
+      {
+        num_strings = std::stoul(read_field(in, "strings", p));
+      }
+    catch(std::logic_error&)
+      {
+        badly_formed(p, "string count");
+      }
+
+    for(size_t i = 0; i < num_strings; ++i)
+      {
+        if(!std::getline(in, line)) badly_formed(p, "truncated string table");
+
+        auto sep = line.find('\t');
+        if(sep == std::string::npos) badly_formed(p, "string table");
+
+        this->strings.emplace(checkpoint_impl::unescape(line.substr(0, sep)), checkpoint_impl::unescape(line.substr(sep+1)));
+      }
+
+    // read archive, verifying its checksum before handing it to GiNaC
+    std::istringstream payload_header{read_field(in, "payload", p)};
+    if(!(payload_header >> payload_size >> checksum)) badly_formed(p, "payload header");
+
+    std::string payload(payload_size, '\0');
+    if(!in.read(&payload[0], static_cast<std::streamsize>(payload_size))) badly_formed(p, "truncated payload");
+
+    if(hash_impl::to_hex(hash_impl::fnv1a(payload.data(), payload.size())) != checksum) badly_formed(p, "checksum mismatch");
+
+    try
+      {
+        std::istringstream archive_in{payload};
+        archive_in >> this->ar;
+      }
+    catch(std::exception& xe)
+      {
+        badly_formed(p, xe.what());
+      }
+  }
+
+
+void checkpoint::archive_ex(const std::string& key, const GiNaC::ex& expr)
+  {
+    this->ar.archive_ex(expr, key.c_str());
+  }
+
+
+GiNaC::ex checkpoint::unarchive_ex(const std::string& key) const
+  {
+    try
+      {
+        return this->ar.unarchive_ex(this->symbol_table, key.c_str());
+      }
+    catch(std::runtime_error& xe)
+      {
+        std::ostringstream msg;
+        msg << ERROR_CHECKPOINT_MISSING_ENTRY << " '" << key << "'";
+        throw exception(msg.str(), exception_code::checkpoint_error);
+      }
+  }
+
+
+void checkpoint::set_string(const std::string& key, std::string value)
+  {
+    this->strings[key] = std::move(value);
+  }
+
+
+const std::string& checkpoint::get_string(const std::string& key) const
+  {
+    auto t = this->strings.find(key);
+
+    if(t == this->strings.end())
+      {
+        std::ostringstream msg;
+        msg << ERROR_CHECKPOINT_MISSING_ENTRY << " '" << key << "'";
+        throw exception(msg.str(), exception_code::checkpoint_error);
+      }
+
+    return t->second;
+  }
+
+
+void checkpoint::write(const boost::filesystem::path& p) const
+  {
+    using checkpoint_impl::escape;
+
+    // serialize archive first, so its size and checksum can be written into the header
+    std::ostringstream archive_out;
+    archive_out << this->ar;
+    const std::string payload = archive_out.str();
+
+    // write to a temporary file, which is renamed over the destination once complete; its name is
+    // unique, so that several processes can write the same destination concurrently
+    auto temp = p;
+    temp += boost::filesystem::unique_path(".%%%%-%%%%-%%%%.tmp");
+
+    bool written = false;
+
+    {
+      std::ofstream out{temp.string(), std::ios_base::out | std::ios_base::trunc | std::ios_base::binary};
+
+      out << checkpoint_impl::magic << '\n';
+      out << "format " << checkpoint_impl::format_version << '\n';
+      out << "stage " << escape(this->stage) << '\n';
+      out << "input " << this->input_hash << '\n';
+
+      out << "strings " << this->strings.size() << '\n';
+      for(const auto& item : this->strings)
+        {
+          out << escape(item.first) << '\t' << escape(item.second) << '\n';
+        }
+
+      out << "payload " << payload.size() << " " << hash_impl::to_hex(hash_impl::fnv1a(payload.data(), payload.size())) << '\n';
+      out.write(payload.data(), static_cast<std::streamsize>(payload.size()));
+
+      out.close();
+      written = static_cast<bool>(out);
+    }
+
+    boost::system::error_code ec;
+    if(written) boost::filesystem::rename(temp, p, ec);
+
+    if(!written || ec)
+      {
+        boost::system::error_code ignore;
+        boost::filesystem::remove(temp, ignore);
+
+        std::ostringstream msg;
+        msg << ERROR_CHECKPOINT_WRITE_FAILED << " '" << p.string() << "'";
+        throw exception(msg.str(), exception_code::checkpoint_error);
+      }
+  }
+
+
+const GiNaC::lst& archive_list(const GiNaC::ex& expr, size_t size)
+  {
+    if(!GiNaC::is_a<GiNaC::lst>(expr) || (size > 0 && expr.nops() != size))
+      throw exception(ERROR_CHECKPOINT_UNEXPECTED_FORM, exception_code::checkpoint_error);
+
+    return GiNaC::ex_to<GiNaC::lst>(expr);
+  }
+
+
+const GiNaC::symbol& archive_symbol(const GiNaC::ex& expr)
+  {
+    if(!GiNaC::is_a<GiNaC::symbol>(expr))
+      throw exception(ERROR_CHECKPOINT_UNEXPECTED_FORM, exception_code::checkpoint_error);
+
+    return GiNaC::ex_to<GiNaC::symbol>(expr);
+  }
+
+
+GiNaC::ex archive_symbol_set(const GiNaC_symbol_set& syms)
+  {
+    GiNaC::lst list;
+
+    // store in lexical order, so that archives do not depend on the order in which symbols were created
+    for(const auto& sym : order_symbol_set(syms))
+      {
+        list.append(sym);
+      }
+
+    return list;
+  }
+
+
+GiNaC_symbol_set restore_symbol_set(const GiNaC::ex& expr)
+  {
+    GiNaC_symbol_set syms;
+
+    for(const auto& item : archive_list(expr))
+      {
+        syms.insert(archive_symbol(item));
+      }
+
+    return syms;
+  }
+
+
+GiNaC::ex archive_exmap(const GiNaC::exmap& map)
+  {
+    GiNaC::lst list;
+
+    for(const auto& item : map)
+      {
+        GiNaC::lst rule;
+        rule.append(item.first);
+        rule.append(item.second);
+
+        list.append(rule);
+      }
+
+    return list;
+  }
+
+
+GiNaC::exmap restore_exmap(const GiNaC::ex& expr)
+  {
+    GiNaC::exmap map;
+
+    for(const auto& item : archive_list(expr))
+      {
+        const auto& rule = archive_list(item, 2);
+        map[rule.op(0)] = rule.op(1);
+      }
+
+    return map;
+  }
@@ -0,0 +1,163 @@
+//
+// Created by David Seery on 10/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#ifndef LSSEFT_ANALYTIC_CHECKPOINT_H
+#define LSSEFT_ANALYTIC_CHECKPOINT_H
+
+
+#include <string>
+#include <map>
+
+#include "utilities/GiNaC_utils.h"
+
+#include "boost/filesystem/path.hpp"
+
+#include "ginac/ginac.h"
+
+
+//! checkpoint holds a snapshot of the pipeline state at the end of a named stage.
+//! Expressions are held in a GiNaC::archive, so subexpressions shared between them are stored once;
+//! short metadata strings (names, tags) are held separately.
+//! On disk, a checkpoint consists of a text header followed by the archive. The header records the
+//! stage name, a hash of the inputs used to produce it, and a checksum of the archive, so that truncated
+//! or stale checkpoints can be detected
+class checkpoint
+  {
+
+    // TYPES
+
+  protected:
+
+    //! type for string database
+    using string_db = std::map< std::string, std::string >;
+
+
+    // CONSTRUCTOR, DESTRUCTOR
+
+  public:
+
+    //! constructor creates an empty checkpoint for the named stage, produced from inputs with the given hash
+    checkpoint(std::string st_, std::string ih_);
+
+    //! constructor reads a checkpoint from disk; throws if the file is missing or corrupt
+    explicit checkpoint(const boost::filesystem::path& p);
+
+    //! destructor is default
+    ~checkpoint() = default;
+
+
+    // METADATA
+
+  public:
+
+    //! get stage name
+    const std::string& get_stage() const { return this->stage; }
+
+    //! get input hash
+    const std::string& get_input_hash() const { return this->input_hash; }
+
+
+    // EXPRESSIONS
+
+  public:
+
+    //! store a GiNaC expression under the given key
+    void archive_ex(const std::string& key, const GiNaC::ex& expr);
+
+    //! retrieve a GiNaC expression; symbols are bound by name to those in the symbol table, where possible
+    GiNaC::ex unarchive_ex(const std::string& key) const;
+
+    //! set the symbol table used when retrieving expressions
+    void set_symbol_table(GiNaC::lst syms) { this->symbol_table = std::move(syms); }
+
+
+    // STRINGS
+
+  public:
+
+    //! store a string under the given key
+    void set_string(const std::string& key, std::string value);
+
+    //! retrieve a string; throws if the key is not present
+    const std::string& get_string(const std::string& key) const;
+
+    //! determine whether a string is present
+    bool has_string(const std::string& key) const { return this->strings.find(key) != this->strings.end(); }
+
+
+    // SERVICES
+
+  public:
+
+    //! write self to disk; the file is replaced atomically, so an interrupted write does not destroy
+    //! an earlier checkpoint
+    void write(const boost::filesystem::path& p) const;
+
+
+    // INTERNAL DATA
+
+  private:
+
+    //! stage name
+    std::string stage;
+
+    //! hash of inputs
+    std::string input_hash;
+
+    //! metadata strings
+    string_db strings;
+
+    //! archive of GiNaC expressions
+    GiNaC::archive ar;
+
+    //! symbol table used when unarchiving
+    GiNaC::lst symbol_table;
+
+  };
+
+
+// utility functions to convert common containers to and from archivable GiNaC expressions
+
+//! check that an archived expression is a list and, if size is nonzero, that it has the expected number of elements
+const GiNaC::lst& archive_list(const GiNaC::ex& expr, size_t size = 0);
+
+//! check that an archived expression is a symbol, and return it
+const GiNaC::symbol& archive_symbol(const GiNaC::ex& expr);
+
+//! convert a symbol set to an archivable list
+GiNaC::ex archive_symbol_set(const GiNaC_symbol_set& syms);
+
+//! rebuild a symbol set from its archived form
+GiNaC_symbol_set restore_symbol_set(const GiNaC::ex& expr);
+
+//! convert a substitution map to an archivable list of pairs
+GiNaC::ex archive_exmap(const GiNaC::exmap& map);
+
+//! rebuild a substitution map from its archived form
+GiNaC::exmap restore_exmap(const GiNaC::ex& expr);
+
+
+#endif //LSSEFT_ANALYTIC_CHECKPOINT_H
@@ -0,0 +1,202 @@
+//
+// Created by David Seery on 10/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+#include "checkpoint_store.h"
+
+#include "utilities/stable_hash.h"
+
+#include "shared/common.h"
+#include "shared/exceptions.h"
+#include "shared/error.h"
+#include "localizations/messages.h"
+
+#include "boost/filesystem/operations.hpp"
+
+
+// digest of the sources defining the model; normally supplied by the build system, which recomputes
+// it whenever these sources change
+#ifndef LSSEFT_MODEL_DIGEST
+#define LSSEFT_MODEL_DIGEST "unknown"
+#endif
+
+
+checkpoint_store::checkpoint_store(std::vector<std::string> st_, service_locator& lc_, boost::optional<std::string> lt_)
+  : loc(lc_),
+    root(lc_.get_argument_cache().get_checkpoint_dir()),
+    stages(std::move(st_))
+  {
+    this->compute_hashes();
+
+    const auto& args = this->loc.get_argument_cache();
+    if(!args.get_resume()) return;
+
+    if(!this->enabled())
+      {
+        error_handler err;
+        err.warn(WARNING_RESUME_WITHOUT_CHECKPOINT_DIR);
+        return;
+      }
+
+    this->find_resume_point(lt_ ? this->stage_index(*lt_) : this->stages.size()-1);
+  }
+
+
+void checkpoint_store::compute_hashes()
+  {
+    const auto& args = this->loc.get_argument_cache();
+
+    std::ostringstream inputs;
+    inputs << PROGRAM_NAME << " " << PROGRAM_VERSION << '\n'
+           << "model " << LSSEFT_MODEL_DIGEST << '\n'
+           << "auto-symmetrize " << args.get_auto_symmetrize() << '\n'
+           << "symmetrize-22 " << args.get_symmetrize_22() << '\n';
+
+    std::string hash = hash_impl::stable_hash(inputs.str());
+
+    // each stage's hash depends on the hash of the stage before it, so invalidating one stage
+    // invalidates all stages which follow it
+    for(const auto& stage : this->stages)
+      {
+        hash = hash_impl::stable_hash(hash + '\n' + stage);
+        this->hashes.push_back(hash);
+      }
+  }
+
+
+void checkpoint_store::find_resume_point(size_t latest)
+  {
+    error_handler err;
+
+    for(size_t i = std::min(latest+1, this->stages.size()); i > 0; --i)
+      {
+        const size_t index = i-1;
+        const auto path = this->checkpoint_path(index);
+
+        if(!boost::filesystem::exists(path)) continue;
+
+        try
+          {
+            auto ckpt = std::make_unique<checkpoint>(path);
+
+            if(ckpt->get_stage() != this->stages[index] || ckpt->get_input_hash() != this->hashes[index])
+              {
+                std::ostringstream msg;
+                msg << WARNING_CHECKPOINT_IGNORED << " '" << path.string() << "' (input hash does not match)";
+                err.warn(msg.str());
+                continue;
+              }
+
+            // restore symbol factory state before any expressions are unarchived, so that named symbols
+            // in the checkpoint are bound to the symbols used in this run
+            auto& sf = this->loc.get_symbol_factory();
+            sf.restore(*ckpt);
+            ckpt->set_symbol_table(sf.get_symbol_table());
+
+            this->restored = std::move(ckpt);
+            this->resume_index = index;
+
+            std::ostringstream msg;
+            msg << LABEL_CHECKPOINT_RESUME << " '" << this->stages[index] << "'";
+            err.info(msg.str());
+
+            return;
+          }
+        catch(exception& xe)
+          {
+            std::ostringstream msg;
+            msg << WARNING_CHECKPOINT_IGNORED << " '" << path.string() << "' (" << xe.what() << ")";
+            err.warn(msg.str());
+          }
+      }
+
+    err.info(LABEL_CHECKPOINT_NONE);
+  }
+
+
+size_t checkpoint_store::stage_index(const std::string& stage) const
+  {
+    auto t = std::find(this->stages.begin(), this->stages.end(), stage);
+
+    if(t == this->stages.end())
+      {
+        std::ostringstream msg;
+        msg << ERROR_CHECKPOINT_UNKNOWN_STAGE << " '" << stage << "'";
+        throw exception(msg.str(), exception_code::checkpoint_error);
+      }
+
+    return static_cast<size_t>(t - this->stages.begin());
+  }
+
+
+boost::filesystem::path checkpoint_store::checkpoint_path(size_t index) const
+  {
+    // prefix file names with the stage number, so that a directory listing shows stages in order
+    std::ostringstream name;
+    name << std::setw(2) << std::setfill('0') << index << "_" << this->stages[index] << ".ckpt";
+
+    return this->root / name.str();
+  }
+
+
+bool checkpoint_store::completed(const std::string& stage) const
+  {
+    return this->resume_index && this->stage_index(stage) <= *this->resume_index;
+  }
+
+
+bool checkpoint_store::resume_from(const std::string& stage) const
+  {
+    return this->resume_index && this->stage_index(stage) == *this->resume_index;
+  }
+
+
+const checkpoint& checkpoint_store::get_restored() const
+  {
+    if(!this->restored) throw exception(ERROR_CHECKPOINT_NO_RESUME_POINT, exception_code::checkpoint_error);
+
+    return *this->restored;
+  }
+
+
+checkpoint checkpoint_store::make_checkpoint(const std::string& stage) const
+  {
+    return checkpoint{stage, this->hashes[this->stage_index(stage)]};
+  }
+
+
+void checkpoint_store::commit(checkpoint& ckpt) const
+  {
+    if(!this->enabled()) return;
+
+    this->loc.get_symbol_factory().archive(ckpt);
+
+    boost::filesystem::create_directories(this->root);
+    ckpt.write(this->checkpoint_path(this->stage_index(ckpt.get_stage())));
+  }
@@ -0,0 +1,129 @@
+//
+// Created by David Seery on 10/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#ifndef LSSEFT_ANALYTIC_CHECKPOINT_STORE_H
+#define LSSEFT_ANALYTIC_CHECKPOINT_STORE_H
+
+
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "checkpoint.h"
+#include "service_locator.h"
+
+#include "boost/optional.hpp"
+#include "boost/filesystem/path.hpp"
+
+
+//! checkpoint_store manages the checkpoints written at the end of each stage of the pipeline.
+//! Each stage is assigned an input hash, built from the program version, a digest of the sources
+//! that define the model, the options which affect the symbolic computation, and the hash of the
+//! preceding stage. A checkpoint is usable only if its input hash matches.
+//! When resuming, the latest usable checkpoint is located and restored; all stages up to and including
+//! it can then be skipped
+class checkpoint_store
+  {
+
+    // CONSTRUCTOR, DESTRUCTOR
+
+  public:
+
+    //! constructor accepts the list of stages, in order of execution. If resuming was requested, the
+    //! latest usable checkpoint is located and restored, but no stage later than lt_ (if given) is used
+    checkpoint_store(std::vector<std::string> st_, service_locator& lc_, boost::optional<std::string> lt_ = boost::none);
+
+    //! destructor is default
+    ~checkpoint_store() = default;
+
+
+    // INTERFACE
+
+  public:
+
+    //! determine whether a stage was completed by an earlier run, ie. it lies at or before the resume point
+    bool completed(const std::string& stage) const;
+
+    //! determine whether a stage is the resume point; if so, its outputs should be restored from
+    //! the checkpoint returned by get_restored()
+    bool resume_from(const std::string& stage) const;
+
+    //! get checkpoint for the resume point
+    const checkpoint& get_restored() const;
+
+    //! create an empty checkpoint for a stage
+    checkpoint make_checkpoint(const std::string& stage) const;
+
+    //! store symbol factory state in a populated checkpoint, and write it to disk if checkpointing is enabled
+    void commit(checkpoint& ckpt) const;
+
+    //! determine whether checkpoints are written
+    bool enabled() const { return !this->root.empty(); }
+
+
+    // INTERNAL API
+
+  protected:
+
+    //! get index of a named stage
+    size_t stage_index(const std::string& stage) const;
+
+    //! get path of the checkpoint for a given stage
+    boost::filesystem::path checkpoint_path(size_t index) const;
+
+    //! compute input hashes for all stages
+    void compute_hashes();
+
+    //! search for the latest usable checkpoint, no later than the given stage
+    void find_resume_point(size_t latest);
+
+
+    // INTERNAL DATA
+
+  private:
+
+    //! cache reference to service locator
+    service_locator& loc;
+
+    //! directory holding checkpoints; empty if checkpointing is disabled
+    boost::filesystem::path root;
+
+    //! list of stages
+    const std::vector<std::string> stages;
+
+    //! input hash for each stage
+    std::vector<std::string> hashes;
+
+    //! index of resume point, if any
+    boost::optional<size_t> resume_index;
+
+    //! checkpoint for resume point, if any
+    std::unique_ptr<checkpoint> restored;
+
+  };
+
+
+#endif //LSSEFT_ANALYTIC_CHECKPOINT_STORE_H
@@ -0,0 +1,73 @@
+//
+// Created by David Seery on 18/10/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#include "expression_registry.h"
+
+#include "shared/exceptions.h"
+#include "localizations/messages.h"
+
+
+expression_registry::id_type expression_registry::intern(const GiNaC::ex& expr)
+  {
+    // search for an existing record of this expression
+    auto t = this->db.find(expr);
+
+    // if a record was found, return its identifier
+    if(t != this->db.end()) return t->second;
+
+    // otherwise, assign the next available identifier
+    auto id = static_cast<id_type>(this->exprs.size());
+
+    auto r = this->db.emplace(expr, id);
+    if(!r.second) throw exception(ERROR_EXPRESSION_REGISTRY_INSERT_FAILED, exception_code::symbol_error);
+
+    this->exprs.push_back(expr);
+    return id;
+  }
+
+
+expression_registry::id_type expression_registry::intern(const GiNaC::exmap& map)
+  {
+    // GiNaC::exmap is ordered by GiNaC::ex_is_less, so matching substitution lists
+    // will produce identical lists of rules
+    GiNaC::lst rules;
+
+    for(const auto& rule : map)
+      {
+        rules.append(rule.first == rule.second);
+      }
+
+    return this->intern(rules);
+  }
+
+
+const GiNaC::ex& expression_registry::get(id_type id) const
+  {
+    if(id >= this->exprs.size()) throw exception(ERROR_EXPRESSION_REGISTRY_UNKNOWN_ID, exception_code::symbol_error);
+
+    return this->exprs[id];
+  }
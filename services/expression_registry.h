@@ -0,0 +1,123 @@
+//
+// Created by David Seery on 18/10/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#ifndef LSSEFT_ANALYTIC_EXPRESSION_REGISTRY_H
+#define LSSEFT_ANALYTIC_EXPRESSION_REGISTRY_H
+
+
+#include <unordered_map>
+#include <deque>
+
+#include "ginac/ginac.h"
+
+
+namespace expression_registry_impl
+  {
+
+    //! hash a GiNaC expression using its structural hash
+    struct ex_hasher
+      {
+        size_t operator()(const GiNaC::ex& e) const { return static_cast<size_t>(e.gethash()); }
+      };
+
+    //! compare GiNaC expressions for structural equality
+    struct ex_equal
+      {
+        bool operator()(const GiNaC::ex& a, const GiNaC::ex& b) const { return a.is_equal(b); }
+      };
+
+  }   // namespace expression_registry_impl
+
+
+//! expression_registry hash-conses GiNaC expressions (typically time functions, Wick products
+//! and integration measures) and assigns each distinct expression a stable integer identifier.
+//! Keys used to index the kernel and loop-integral databases can then hash and compare
+//! on these identifiers rather than printing expressions to strings
+class expression_registry
+  {
+
+    // TYPES
+
+  public:
+
+    //! type used for expression identifiers
+    using id_type = unsigned int;
+
+  protected:
+
+    //! type for expression database
+    using expression_db = std::unordered_map< GiNaC::ex, id_type, expression_registry_impl::ex_hasher,
+                                              expression_registry_impl::ex_equal >;
+
+
+    // CONSTRUCTOR, DESTRUCTOR
+
+  public:
+
+    //! constructor is default
+    expression_registry() = default;
+
+    //! destructor is default
+    ~expression_registry() = default;
+
+    //! disable copying
+    expression_registry(const expression_registry& obj) = delete;
+
+
+    // INTERFACE
+
+  public:
+
+    //! intern an expression, returning its identifier; structurally identical expressions
+    //! (which GiNaC guarantees are stored in a canonical order) always receive the same identifier
+    id_type intern(const GiNaC::ex& expr);
+
+    //! intern a substitution list, returning a single identifier for the entire list
+    id_type intern(const GiNaC::exmap& map);
+
+    //! recover the expression associated with an identifier
+    const GiNaC::ex& get(id_type id) const;
+
+    //! get number of distinct expressions interned
+    size_t size() const { return this->exprs.size(); }
+
+
+    // INTERNAL DATA
+
+  private:
+
+    //! map from expressions to identifiers
+    expression_db db;
+
+    //! map from identifiers to expressions; a deque is used so that references returned
+    //! by get() are not invalidated by later insertions
+    std::deque<GiNaC::ex> exprs;
+
+  };
+
+
+#endif //LSSEFT_ANALYTIC_EXPRESSION_REGISTRY_H
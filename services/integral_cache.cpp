@@ -0,0 +1,328 @@
+//
+// Created by David Seery on 10/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <ctime>
+
+#include "integral_cache.h"
+#include "checkpoint.h"
+
+#include "utilities/GiNaC_utils.h"
+#include "utilities/stable_hash.h"
+
+#include "shared/common.h"
+#include "shared/exceptions.h"
+#include "shared/error.h"
+#include "localizations/messages.h"
+
+#include "boost/filesystem/operations.hpp"
+#include "boost/interprocess/sync/file_lock.hpp"
+#include "boost/interprocess/sync/scoped_lock.hpp"
+
+
+// digest of the sources which perform angular reduction; normally supplied by the build system,
+// which recomputes it whenever these sources change
+#ifndef LSSEFT_REDUCTION_DIGEST
+#define LSSEFT_REDUCTION_DIGEST "unknown"
+#endif
+
+
+namespace integral_cache_impl
+  {
+
+    //! stage name used to label cache entries
+    constexpr auto entry_label = "reduced-integral";
+
+    //! file extension for cache entries
+    constexpr auto entry_extension = ".integral";
+
+    //! name of lock file serializing eviction
+    constexpr auto lock_name = ".lock";
+
+    //! age (in seconds) after which an orphaned temporary file may be removed
+    constexpr std::time_t stale_temporary_age = 24*60*60;
+
+  }   // namespace integral_cache_impl
+
+
+integral_cache::integral_cache(boost::filesystem::path rt_, size_t mx_)
+  : root(std::move(rt_)),
+    max_size(mx_)
+  {
+    if(!this->enabled()) return;
+
+    boost::system::error_code ec;
+    boost::filesystem::create_directories(this->root, ec);
+
+    if(ec)
+      {
+        std::ostringstream msg;
+        msg << WARNING_INTEGRAL_CACHE_UNAVAILABLE << " '" << this->root.string() << "'";
+
+        error_handler err;
+        err.warn(msg.str());
+
+        this->root.clear();
+      }
+  }
+
+
+integral_cache::~integral_cache()
+  {
+    if(!this->enabled()) return;
+
+    this->trim();
+
+    if(this->hits > 0 || this->misses > 0)
+      {
+        std::ostringstream msg;
+        msg << LABEL_INTEGRAL_CACHE << " " << this->hits << " " << LABEL_INTEGRAL_CACHE_HITS << " "
+            << this->misses << " " << LABEL_INTEGRAL_CACHE_MISSES;
+
+        error_handler err;
+        err.info(msg.str());
+      }
+  }
+
+
+std::string integral_cache::make_key(const std::string& fingerprint) const
+  {
+    std::ostringstream str;
+    str << PROGRAM_VERSION << '\n' << LSSEFT_REDUCTION_DIGEST << '\n' << fingerprint;
+
+    return hash_impl::stable_hash(str.str());
+  }
+
+
+boost::filesystem::path integral_cache::entry_path(const std::string& key) const
+  {
+    // fan entries out over subdirectories named by the leading digits of the key, so that
+    // no single directory becomes very large
+    return this->root / key.substr(0, 2) / (key + integral_cache_impl::entry_extension);
+  }
+
+
+boost::optional<GiNaC::ex> integral_cache::find(const std::string& fingerprint, const symbol_factory& sf)
+  {
+    if(!this->enabled()) return boost::none;
+
+    const auto key = this->make_key(fingerprint);
+    const auto path = this->entry_path(key);
+
+    boost::system::error_code ec;
+    if(!boost::filesystem::exists(path, ec))
+      {
+        ++this->misses;
+        return boost::none;
+      }
+
+    try
+      {
+        checkpoint entry{path};
+
+        // a different fingerprint means the keys collided; the entry is valid, but not for us
+        if(entry.get_stage() != integral_cache_impl::entry_label || entry.get_input_hash() != key
+           || entry.get_string("fingerprint") != fingerprint)
+          {
+            ++this->misses;
+            return boost::none;
+          }
+
+        // each named symbol used by the entry must already exist, so that it is bound to the symbol used
+        // elsewhere in this run; otherwise the entry refers to symbols this model does not use, and the
+        // lookup fails
+        std::set<std::string> known;
+        for(const auto& sym : sf.get_symbol_table())
+          {
+            known.insert(GiNaC::ex_to<GiNaC::symbol>(sym).get_name());
+          }
+
+        std::istringstream names{entry.get_string("symbols")};
+        std::string name;
+        while(std::getline(names, name))
+          {
+            if(!name.empty() && known.find(name) == known.end())
+              {
+                ++this->misses;
+                return boost::none;
+              }
+          }
+
+        entry.set_symbol_table(sf.get_symbol_table());
+        auto value = entry.unarchive_ex("integral");
+
+        // update modification time, which is used to order entries for eviction
+        boost::filesystem::last_write_time(path, std::time(nullptr), ec);
+
+        ++this->hits;
+        return value;
+      }
+    catch(exception&)
+      {
+        // the entry is damaged or was written by an incompatible version; remove it, so that it
+        // is replaced by this run
+        boost::filesystem::remove(path, ec);
+
+        ++this->misses;
+        return boost::none;
+      }
+  }
+
+
+void integral_cache::insert(const std::string& fingerprint, const GiNaC::ex& value)
+  {
+    if(!this->enabled()) return;
+
+    const auto key = this->make_key(fingerprint);
+    const auto path = this->entry_path(key);
+
+    try
+      {
+        checkpoint entry{integral_cache_impl::entry_label, key};
+        entry.set_string("fingerprint", fingerprint);
+
+        std::string names;
+        for(const auto& sym : get_expr_symbols(value))
+          {
+            if(!names.empty()) names += '\n';
+            names += sym.get_name();
+          }
+        entry.set_string("symbols", names);
+
+        entry.archive_ex("integral", value);
+
+        boost::system::error_code ec;
+        boost::filesystem::create_directories(path.parent_path(), ec);
+
+        entry.write(path);
+      }
+    catch(exception& xe)
+      {
+        // report only the first failure; a full or read-only disk would otherwise produce
+        // one warning per integral
+        if(!this->write_failed)
+          {
+            this->write_failed = true;
+
+            std::ostringstream msg;
+            msg << WARNING_INTEGRAL_CACHE_WRITE_FAILED << " (" << xe.what() << ")";
+
+            error_handler err;
+            err.warn(msg.str());
+          }
+      }
+  }
+
+
+void integral_cache::trim()
+  {
+    if(!this->enabled()) return;
+
+    const auto lock_path = this->root / integral_cache_impl::lock_name;
+
+    try
+      {
+        // file_lock requires the lock file to exist
+        {
+          std::ofstream touch{lock_path.string(), std::ios_base::out | std::ios_base::app};
+        }
+
+        boost::interprocess::file_lock lock_file{lock_path.string().c_str()};
+        boost::interprocess::scoped_lock<boost::interprocess::file_lock> lock{lock_file, boost::interprocess::try_to_lock};
+
+        // if another process is already evicting entries, there is nothing to do
+        if(!lock) return;
+
+        struct entry_record
+          {
+            boost::filesystem::path path;
+            std::time_t time;
+            uintmax_t size;
+          };
+
+        std::vector<entry_record> entries;
+        uintmax_t total = 0;
+
+        const std::time_t now = std::time(nullptr);
+
+        boost::system::error_code ec;
+        for(boost::filesystem::recursive_directory_iterator t{this->root, ec}, end; !ec && t != end; t.increment(ec))
+          {
+            const auto& p = t->path();
+
+            boost::system::error_code fec;
+            if(!boost::filesystem::is_regular_file(p, fec)) continue;
+
+            const auto time = boost::filesystem::last_write_time(p, fec);
+            if(fec) continue;
+
+            // temporary files left behind by interrupted writes are removed once they are old enough
+            // that they can't belong to a write still in progress
+            if(p.extension() == ".tmp")
+              {
+                if(now - time > integral_cache_impl::stale_temporary_age) boost::filesystem::remove(p, fec);
+                continue;
+              }
+
+            if(p.extension() != integral_cache_impl::entry_extension) continue;
+
+            const auto size = boost::filesystem::file_size(p, fec);
+            if(fec) continue;
+
+            entries.push_back(entry_record{p, time, size});
+            total += size;
+          }
+
+        if(total <= this->max_size) return;
+
+        // evict least-recently-used entries first, down to a low-water mark below the limit,
+        // so that eviction is not needed on every run
+        std::sort(entries.begin(), entries.end(),
+                  [](const entry_record& a, const entry_record& b) -> bool { return a.time < b.time; });
+
+        const uintmax_t target = this->max_size - this->max_size/10;
+
+        for(const auto& e : entries)
+          {
+            if(total <= target) break;
+
+            boost::system::error_code rec;
+            if(boost::filesystem::remove(e.path, rec)) total -= e.size;
+          }
+      }
+    catch(boost::interprocess::interprocess_exception& xe)
+      {
+        std::ostringstream msg;
+        msg << WARNING_INTEGRAL_CACHE_TRIM_FAILED << " (" << xe.what() << ")";
+
+        error_handler err;
+        err.warn(msg.str());
+      }
+  }
@@ -0,0 +1,123 @@
+//
+// Created by David Seery on 10/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#ifndef LSSEFT_ANALYTIC_INTEGRAL_CACHE_H
+#define LSSEFT_ANALYTIC_INTEGRAL_CACHE_H
+
+
+#include <string>
+
+#include "symbol_factory.h"
+
+#include "boost/optional.hpp"
+#include "boost/filesystem/path.hpp"
+
+#include "ginac/ginac.h"
+
+
+//! integral_cache is a persistent, content-addressed store of angular reductions, shared between runs
+//! and between models.
+//! Entries are keyed by a stable hash of the fingerprint of a loop integral (together with
+//! a digest of the sources which perform the reduction), and hold the archived element database of
+//! the reduced integral. The full fingerprint is stored in each entry and checked on retrieval, so hash
+//! collisions cannot produce incorrect results.
+//! Several processes may use the same cache directory concurrently. Entries are written to unique
+//! temporary files and renamed into place, so readers never see a partial entry; eviction, which
+//! removes the least-recently-used entries once the cache exceeds its size limit, is serialized
+//! between processes by a lock file
+class integral_cache
+  {
+
+    // CONSTRUCTOR, DESTRUCTOR
+
+  public:
+
+    //! constructor accepts the cache directory (empty to disable the cache) and its maximum size in bytes
+    integral_cache(boost::filesystem::path rt_, size_t mx_);
+
+    //! destructor evicts entries if the cache has grown beyond its size limit, and reports usage
+    ~integral_cache();
+
+    //! disable copying
+    integral_cache(const integral_cache& obj) = delete;
+
+
+    // INTERFACE
+
+  public:
+
+    //! determine whether the cache is in use
+    bool enabled() const { return !this->root.empty(); }
+
+    //! look up the archived reduction associated with a fingerprint, if one exists; its symbols
+    //! are bound by name to those of the symbol factory, and the lookup fails if any are unknown
+    boost::optional<GiNaC::ex> find(const std::string& fingerprint, const symbol_factory& sf);
+
+    //! store the archived reduction associated with a fingerprint; failures are reported, but are not fatal
+    void insert(const std::string& fingerprint, const GiNaC::ex& value);
+
+    //! evict least-recently-used entries until the cache is within its size limit; does nothing if
+    //! another process is already doing so
+    void trim();
+
+
+    // INTERNAL API
+
+  protected:
+
+    //! compute key for a fingerprint
+    std::string make_key(const std::string& fingerprint) const;
+
+    //! get path of the entry for a key
+    boost::filesystem::path entry_path(const std::string& key) const;
+
+
+    // INTERNAL DATA
+
+  private:
+
+    //! cache directory; empty if the cache is disabled
+    boost::filesystem::path root;
+
+    //! maximum size in bytes
+    size_t max_size;
+
+
+    // STATISTICS
+
+    //! number of lookups which found an entry
+    unsigned int hits{0};
+
+    //! number of lookups which did not find an entry
+    unsigned int misses{0};
+
+    //! has a write failure been reported?
+    bool write_failed{false};
+
+  };
+
+
+#endif //LSSEFT_ANALYTIC_INTEGRAL_CACHE_H
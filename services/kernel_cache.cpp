@@ -0,0 +1,103 @@
+//
+// Created by David Seery on 20/10/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#include <algorithm>
+
+#include "kernel_cache.h"
+
+#include "utilities/hash_combine.h"
+
+
+size_t kernel_cache::key_hasher::operator()(const key& k) const
+  {
+    size_t h = 0;
+    hash_impl::hash_combine(h, static_cast<unsigned int>(k.operation), k.N);
+
+    std::for_each(k.operands.begin(), k.operands.end(),
+                  [&](const void* p) -> void { hash_impl::hash_combine(h, p); });
+    std::for_each(k.exprs.begin(), k.exprs.end(),
+                  [&](expression_registry::id_type id) -> void { hash_impl::hash_combine(h, id); });
+
+    return h;
+  }
+
+
+bool kernel_cache::key_equal::operator()(const key& a, const key& b) const
+  {
+    return a.operation == b.operation && a.N == b.N && a.operands == b.operands && a.exprs == b.exprs;
+  }
+
+
+kernel_cache::kernel_cache(bool e)
+  : enabled(e)
+  {
+  }
+
+
+kernel_cache::key kernel_cache::make_key(op o, unsigned int N, const handle_list& operands, expression_list exprs)
+  {
+    key k{o, N, {}, std::move(exprs)};
+
+    k.operands.reserve(operands.size());
+    for(const auto& h : operands)
+      {
+        k.operands.push_back(h.get());
+      }
+
+    return k;
+  }
+
+
+kernel_cache::handle
+kernel_cache::find(op o, unsigned int N, const handle_list& operands, const expression_list& exprs) const
+  {
+    auto k = make_key(o, N, operands, exprs);
+
+    auto t = this->db.find(k);
+    if(t == this->db.end()) return handle{};
+
+    return t->second.result;
+  }
+
+
+void kernel_cache::insert(op o, unsigned int N, handle_list operands, expression_list exprs, handle result)
+  {
+    auto k = make_key(o, N, operands, std::move(exprs));
+
+    this->db.emplace(std::move(k), entry{std::move(operands), std::move(result)});
+  }
+
+
+size_t kernel_cache::size() const
+  {
+    return this->db.size();
+  }
+
+
+void kernel_cache::clear()
+  {
+    this->db.clear();
+  }
@@ -0,0 +1,165 @@
+//
+// Created by David Seery on 20/10/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#ifndef LSSEFT_ANALYTIC_KERNEL_CACHE_H
+#define LSSEFT_ANALYTIC_KERNEL_CACHE_H
+
+
+#include <unordered_map>
+#include <vector>
+#include <memory>
+
+#include "expression_registry.h"
+
+
+//! kernel_cache memoizes the results of Fourier kernel algebra.
+//! Fourier kernels share their (immutable) kernel databases, so a database can be used as the identity
+//! of the kernel it represents. An operation applied to the same operand databases (and the same auxiliary
+//! expressions, if any) must produce the same result, so it need be computed only once.
+//! Databases are held type-erased because they depend on the maximum order N.
+//! Entries retain their operands, so the address of a database is never reused while it appears in a key.
+//! Because entries keep their databases alive, the cache should be cleared once the kernels it relates
+//! to have been consumed. The cache is single-threaded and is not protected by a lock
+class kernel_cache
+  {
+
+    // TYPES
+
+  public:
+
+    //! operations that can be memoized
+    enum class op { negate, sum, scale, product, diff_z, Laplacian, InverseLaplacian,
+                    gradgrad, dotgrad, convective_bias_term, Galileon2, Galileon3 };
+
+    //! type-erased handle to a kernel database
+    using handle = std::shared_ptr<const void>;
+
+    //! list of handles
+    using handle_list = std::vector<handle>;
+
+    //! list of interned auxiliary expressions
+    using expression_list = std::vector<expression_registry::id_type>;
+
+  protected:
+
+    //! key identifies an operation by its operands
+    struct key
+      {
+        //! operation
+        op operation;
+
+        //! maximum order of operands
+        unsigned int N;
+
+        //! operand databases
+        std::vector<const void*> operands;
+
+        //! auxiliary expressions
+        expression_list exprs;
+      };
+
+    //! hash a key
+    struct key_hasher
+      {
+        size_t operator()(const key& k) const;
+      };
+
+    //! compare keys for equality
+    struct key_equal
+      {
+        bool operator()(const key& a, const key& b) const;
+      };
+
+    //! a cache entry holds the result and keeps its operands alive
+    struct entry
+      {
+        //! operand databases
+        handle_list operands;
+
+        //! result database
+        handle result;
+      };
+
+    //! type for cache database
+    using cache_db = std::unordered_map< key, entry, key_hasher, key_equal >;
+
+
+    // CONSTRUCTOR, DESTRUCTOR
+
+  public:
+
+    //! constructor accepts flag indicating whether memoization is enabled
+    explicit kernel_cache(bool e);
+
+    //! destructor is default
+    ~kernel_cache() = default;
+
+    //! disable copying
+    kernel_cache(const kernel_cache& obj) = delete;
+
+
+    // INTERFACE
+
+  public:
+
+    //! determine whether memoization is enabled
+    bool is_enabled() const { return this->enabled; }
+
+    //! look up the result of an operation; returns an empty handle if none exists
+    handle find(op o, unsigned int N, const handle_list& operands, const expression_list& exprs) const;
+
+    //! store the result of an operation; if an entry already exists it is left unchanged
+    void insert(op o, unsigned int N, handle_list operands, expression_list exprs, handle result);
+
+    //! get number of cached results
+    size_t size() const;
+
+    //! remove all cached results, releasing the databases they retain
+    void clear();
+
+
+    // INTERNAL API
+
+  protected:
+
+    //! build a key
+    static key make_key(op o, unsigned int N, const handle_list& operands, expression_list exprs);
+
+
+    // INTERNAL DATA
+
+  private:
+
+    //! is memoization enabled?
+    const bool enabled;
+
+    //! database of results
+    cache_db db;
+
+  };
+
+
+#endif //LSSEFT_ANALYTIC_KERNEL_CACHE_H
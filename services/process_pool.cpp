@@ -0,0 +1,179 @@
+//
+// Created by David Seery on 10/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cerrno>
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include "process_pool.h"
+
+#include "shared/exceptions.h"
+#include "localizations/messages.h"
+
+#include "boost/filesystem/operations.hpp"
+
+
+namespace process_pool_impl
+  {
+
+    //! stage name used to label worker checkpoints
+    constexpr auto worker_label = "worker";
+
+    //! template for names of the temporary files used to return results from workers
+    constexpr auto result_template = "lsseft-worker-%%%%-%%%%-%%%%.ckpt";
+
+    //! wait for a worker process to exit; returns true if it completed successfully
+    bool wait_for(pid_t pid)
+      {
+        int status = 0;
+
+        while(waitpid(pid, &status, 0) < 0)
+          {
+            if(errno != EINTR) return false;
+          }
+
+        return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+      }
+
+  }   // namespace process_pool_impl
+
+
+process_pool::process_pool(unsigned int n)
+  : num_workers(n)
+  {
+    if(this->num_workers == 0)
+      {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        this->num_workers = cores > 0 ? static_cast<unsigned int>(cores) : 1;
+      }
+  }
+
+
+void process_pool::run(size_t count, const work_function& work, const collect_function& collect)
+  {
+    if(count == 0) return;
+
+    // if the batch is not split, there is no need to fork; results are passed back in memory
+    if(!this->parallel(count))
+      {
+        checkpoint results{process_pool_impl::worker_label, "0"};
+        work(0, count, results);
+        collect(0, count, results);
+        return;
+      }
+
+    const size_t slices = std::min(count, static_cast<size_t>(this->num_workers));
+    auto slice_begin = [&](size_t i) -> size_t { return count * i / slices; };
+
+    // flush buffered output, so that it is not written a second time by each worker
+    std::cout.flush();
+    std::cerr.flush();
+
+    std::vector<boost::filesystem::path> files;
+    std::vector<pid_t> workers;
+    bool failed = false;
+
+    const auto temp = boost::filesystem::temp_directory_path();
+
+    for(size_t i = 0; i < slices; ++i)
+      {
+        files.push_back(temp / boost::filesystem::unique_path(process_pool_impl::result_template));
+
+        pid_t pid = fork();
+        if(pid < 0)
+          {
+            failed = true;
+            break;
+          }
+
+        if(pid == 0)
+          {
+            // worker process: store results and exit, without running destructors or exit handlers
+            // which belong to the parent
+            int status = EXIT_SUCCESS;
+
+            try
+              {
+                checkpoint results{process_pool_impl::worker_label, std::to_string(i)};
+                work(slice_begin(i), slice_begin(i+1), results);
+                results.write(files.back());
+              }
+            catch(...)
+              {
+                status = EXIT_FAILURE;
+              }
+
+            std::cout.flush();
+            std::cerr.flush();
+            _exit(status);
+          }
+
+        workers.push_back(pid);
+      }
+
+    // wait for every worker, even if one has failed, so that none is left running
+    for(pid_t pid : workers)
+      {
+        if(!process_pool_impl::wait_for(pid)) failed = true;
+      }
+
+    auto remove_files = [&]() -> void
+      {
+        boost::system::error_code ec;
+        for(const auto& file : files)
+          {
+            boost::filesystem::remove(file, ec);
+          }
+      };
+
+    if(failed)
+      {
+        remove_files();
+        throw exception(ERROR_WORKER_PROCESS_FAILED, exception_code::process_error);
+      }
+
+    try
+      {
+        for(size_t i = 0; i < slices; ++i)
+          {
+            checkpoint results{files[i]};
+            collect(slice_begin(i), slice_begin(i+1), results);
+          }
+      }
+    catch(...)
+      {
+        remove_files();
+        throw;
+      }
+
+    remove_files();
+  }
@@ -0,0 +1,98 @@
+//
+// Created by David Seery on 10/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#ifndef LSSEFT_ANALYTIC_PROCESS_POOL_H
+#define LSSEFT_ANALYTIC_PROCESS_POOL_H
+
+
+#include <functional>
+
+#include "checkpoint.h"
+
+
+//! process_pool runs batches of independent symbolic work in forked worker processes.
+//! GiNaC expressions cannot be shared between threads, but a forked worker holds a private copy of
+//! the parent's heap, and can work on any expression the parent holds.
+//! Each worker processes a contiguous slice of the batch and returns its results in a checkpoint,
+//! written to a temporary file. The parent collects these in slice order, so results do not depend on
+//! the order in which workers finish.
+//! Anything else a worker computes, including entries in its caches, is discarded when it exits
+class process_pool
+  {
+
+    // TYPES
+
+  public:
+
+    //! a work function processes the slice [begin, end) in a worker, and stores its results in a checkpoint
+    using work_function = std::function<void(size_t begin, size_t end, checkpoint& out)>;
+
+    //! a collect function retrieves results for the slice [begin, end) in the parent
+    using collect_function = std::function<void(size_t begin, size_t end, checkpoint& in)>;
+
+
+    // CONSTRUCTOR, DESTRUCTOR
+
+  public:
+
+    //! constructor accepts number of worker processes; zero means use one per available core
+    explicit process_pool(unsigned int n = 1);
+
+    //! destructor is default
+    ~process_pool() = default;
+
+    //! disable copying
+    process_pool(const process_pool& obj) = delete;
+
+
+    // INTERFACE
+
+  public:
+
+    //! get number of worker processes
+    unsigned int size() const { return this->num_workers; }
+
+    //! determine whether a batch of the given size will be split between worker processes
+    bool parallel(size_t count) const { return this->num_workers > 1 && count > 1; }
+
+    //! partition [0, count) into at most size() slices; each slice is processed by work() in a worker,
+    //! and its results retrieved by collect() in the calling process, in slice order.
+    //! If the batch is not split, both run in the calling process. Throws if any worker fails
+    void run(size_t count, const work_function& work, const collect_function& collect);
+
+
+    // INTERNAL DATA
+
+  private:
+
+    //! number of worker processes
+    unsigned int num_workers;
+
+  };
+
+
+#endif //LSSEFT_ANALYTIC_PROCESS_POOL_H
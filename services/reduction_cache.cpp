@@ -0,0 +1,57 @@
+//
+// Created by David Seery on 20/10/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#include "reduction_cache.h"
+
+
+boost::optional<GiNaC::ex> reduction_cache::find(const GiNaC::ex& key) const
+  {
+    auto t = this->db.find(key);
+    if(t == this->db.end()) return boost::none;
+
+    return t->second;
+  }
+
+
+void reduction_cache::insert(const GiNaC::ex& key, const GiNaC::ex& value)
+  {
+    // if a reduction has already been stored for this key, it must agree with ours,
+    // so there is no need to check the result of emplace
+    this->db.emplace(key, value);
+  }
+
+
+size_t reduction_cache::size() const
+  {
+    return this->db.size();
+  }
+
+
+void reduction_cache::clear()
+  {
+    this->db.clear();
+  }
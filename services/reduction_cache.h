@@ -0,0 +1,100 @@
+//
+// Created by David Seery on 20/10/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#ifndef LSSEFT_ANALYTIC_REDUCTION_CACHE_H
+#define LSSEFT_ANALYTIC_REDUCTION_CACHE_H
+
+
+#include <unordered_map>
+
+#include "expression_registry.h"
+
+#include "boost/optional.hpp"
+
+#include "ginac/ginac.h"
+
+
+//! reduction_cache memoizes the result of angular reductions.
+//! Keys are canonical expressions describing the angular skeleton of a term (its angular factors,
+//! together with the loop and Rayleigh momenta it is integrated against), and values are the
+//! reduced skeleton. Since the reduction is linear in any non-angular coefficient, later terms with
+//! the same skeleton need only be multiplied by their own coefficient.
+//! The cache is single-threaded and is not protected by a lock; worker processes each hold their own copy
+class reduction_cache
+  {
+
+    // TYPES
+
+  protected:
+
+    //! type for cache database
+    using cache_db = std::unordered_map< GiNaC::ex, GiNaC::ex, expression_registry_impl::ex_hasher,
+                                         expression_registry_impl::ex_equal >;
+
+
+    // CONSTRUCTOR, DESTRUCTOR
+
+  public:
+
+    //! constructor is default
+    reduction_cache() = default;
+
+    //! destructor is default
+    ~reduction_cache() = default;
+
+    //! disable copying
+    reduction_cache(const reduction_cache& obj) = delete;
+
+
+    // INTERFACE
+
+  public:
+
+    //! look up the reduction associated with a key, if one exists
+    boost::optional<GiNaC::ex> find(const GiNaC::ex& key) const;
+
+    //! store the reduction associated with a key; if an entry already exists it is left unchanged
+    void insert(const GiNaC::ex& key, const GiNaC::ex& value);
+
+    //! get number of cached reductions
+    size_t size() const;
+
+    //! remove all cached reductions
+    void clear();
+
+
+    // INTERNAL DATA
+
+  private:
+
+    //! database of reductions
+    cache_db db;
+
+  };
+
+
+#endif //LSSEFT_ANALYTIC_REDUCTION_CACHE_H
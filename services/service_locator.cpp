@@ -29,6 +29,9 @@
 
 service_locator::service_locator(argument_cache& ac_, symbol_factory& sf_)
   : args(ac_),
-    sf(sf_)
+    sf(sf_),
+    pool(ac_.get_workers()),
+    kc(ac_.get_memoize_kernels()),
+    ic(ac_.get_integral_cache(), ac_.get_integral_cache_size())
   {
   }
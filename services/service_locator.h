@@ -30,12 +30,20 @@
 
 #include "argument_cache.h"
 #include "symbol_factory.h"
+#include "expression_registry.h"
+#include "reduction_cache.h"
+#include "process_pool.h"
+#include "kernel_cache.h"
+#include "integral_cache.h"
 
 
 //! forward-declare fourier_kernel
 template <unsigned int N>
 class fourier_kernel;
 
+//! forward-declare checkpoint
+class checkpoint;
+
 
 //! service_locator is a service locator class
 class service_locator
@@ -63,6 +71,10 @@ class service_locator
     template <unsigned int N>
     fourier_kernel<N> make_fourier_kernel();
 
+    //! restore a Fourier kernel from a checkpoint
+    template <unsigned int N>
+    fourier_kernel<N> make_fourier_kernel(const checkpoint& ckpt, const std::string& label);
+
 
     // ACCESSORS
 
@@ -74,6 +86,21 @@ class service_locator
     //! get symbol factory
     symbol_factory& get_symbol_factory() { return this->sf; }
 
+    //! get expression registry
+    expression_registry& get_expression_registry() { return this->reg; }
+
+    //! get angular reduction cache
+    reduction_cache& get_reduction_cache() { return this->rc; }
+
+    //! get worker process pool
+    process_pool& get_process_pool() { return this->pool; }
+
+    //! get Fourier kernel cache
+    kernel_cache& get_kernel_cache() { return this->kc; }
+
+    //! get persistent angular reduction cache
+    integral_cache& get_integral_cache() { return this->ic; }
+
 
     // INTERNAL DATA
 
@@ -85,6 +112,22 @@ class service_locator
     //! capture reference to symbol factory
     symbol_factory& sf;
 
+    //! expression registry is owned by the service locator
+    expression_registry reg;
+
+    //! angular reduction cache is owned by the service locator, so that it can be shared
+    //! between all reduced integrals
+    reduction_cache rc;
+
+    //! worker process pool is owned by the service locator
+    process_pool pool;
+
+    //! Fourier kernel cache is owned by the service locator
+    kernel_cache kc;
+
+    //! persistent angular reduction cache is owned by the service locator
+    integral_cache ic;
+
   };
 
 
@@ -95,4 +138,11 @@ fourier_kernel<N> service_locator::make_fourier_kernel()
   }
 
 
+template <unsigned int N>
+fourier_kernel<N> service_locator::make_fourier_kernel(const checkpoint& ckpt, const std::string& label)
+  {
+    return fourier_kernel<N>{*this, ckpt, label};
+  }
+
+
 #endif //LSSEFT_ANALYTIC_SERVICE_LOCATOR_H
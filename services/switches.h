@@ -50,8 +50,61 @@ constexpr auto SWITCH_OUTPUT             = "output,o";
 constexpr auto SWITCH_OUTPUT_LONG        = "output";
 constexpr auto HELP_OUTPUT               = "set output root name";
 
+constexpr auto SWITCH_WORKERS            = "workers,j";
+constexpr auto SWITCH_WORKERS_LONG       = "workers";
+constexpr auto HELP_WORKERS              = "number of worker processes used for angular reduction and the parallel backend (0 = use all available cores)";
+
+constexpr auto SWITCH_MEMOIZE_KERNELS    = "memoize-kernels";
+constexpr auto HELP_MEMOIZE_KERNELS      = "reuse results of repeated Fourier kernel operations [experimental]";
+
+constexpr auto SWITCH_PROFILE_REPORT     = "profile-report";
+constexpr auto HELP_PROFILE_REPORT       = "write JSON profiling report to the specified file";
+
+constexpr auto SWITCH_PROFILE_TRACE      = "profile-trace";
+constexpr auto HELP_PROFILE_TRACE        = "write Chrome trace-event profile to the specified file";
+
+constexpr auto SWITCH_MEMORY_REPORT      = "memory-report";
+constexpr auto HELP_MEMORY_REPORT        = "write JSON summary of memory usage and expression sizes at each stage to the specified file";
+
+constexpr auto SWITCH_PARALLEL_BACKEND   = "parallel-backend";
+constexpr auto HELP_PARALLEL_BACKEND     = "check and render kernel integrands in the worker processes [experimental]";
+
+constexpr auto SWITCH_CSE                = "cse";
+constexpr auto SWITCH_NO_CSE             = "no-cse";
+constexpr auto HELP_CSE                  = "eliminate common subexpressions in generated kernel integrands";
+
+constexpr auto SWITCH_NVEC               = "nvec";
+constexpr auto HELP_NVEC                 = "emit batched kernel integrands evaluating up to this many sample points per call";
+
+constexpr auto SWITCH_FUSE_KERNELS       = "fuse-kernels";
+constexpr auto HELP_FUSE_KERNELS         = "integrate kernels sharing a Wick product as components of a single integrand";
+
+constexpr auto SWITCH_MASTER_INTEGRALS   = "master-integrals";
+constexpr auto HELP_MASTER_INTEGRALS     = "integrate a basis of monomials and express each kernel as a linear combination; kernels with IR cancellations between monomials are integrated whole";
+
+constexpr auto SWITCH_HORNER             = "horner";
+constexpr auto HELP_HORNER               = "write kernel integrands in nested Horner form in the integration variables";
+
+constexpr auto SWITCH_INTEGRAND_SHARDS   = "integrand-shards";
+constexpr auto HELP_INTEGRAND_SHARDS     = "split kernel integrands into this many translation units";
+
+constexpr auto SWITCH_SHARD_BYTES        = "integrand-shard-bytes";
+constexpr auto HELP_SHARD_BYTES          = "split kernel integrands into translation units of approximately this size";
+
 constexpr auto SWITCH_MATHEMATICA_OUTPUT = "mathematica-output";
 constexpr auto HELP_MATHEMATICA_OUTPUT   = "write Mathematica script for loop integrals";
 
+constexpr auto SWITCH_CHECKPOINT_DIR     = "checkpoint-dir";
+constexpr auto HELP_CHECKPOINT_DIR       = "write a checkpoint to the specified directory at the end of each stage";
+
+constexpr auto SWITCH_RESUME             = "resume";
+constexpr auto HELP_RESUME               = "resume from the latest usable checkpoint";
+
+constexpr auto SWITCH_INTEGRAL_CACHE     = "integral-cache";
+constexpr auto HELP_INTEGRAL_CACHE       = "reuse angular reductions stored in the specified directory, which may be shared between runs";
+
+constexpr auto SWITCH_INTEGRAL_CACHE_SIZE = "integral-cache-size";
+constexpr auto HELP_INTEGRAL_CACHE_SIZE  = "maximum size (in Mb) of the angular reduction cache";
+
 
 #endif //LSSEFT_ANALYTIC_SWITCHES_H
@@ -24,7 +24,11 @@
 // --@@
 //
 
+#include <sstream>
+#include <algorithm>
+
 #include "symbol_factory.h"
+#include "checkpoint.h"
 
 #include "lib/vector.h"
 #include "lib/initial_value.h"
@@ -38,6 +42,7 @@ symbol_factory::symbol_factory(unsigned int d_)
   : index_dimension(d_),
     z(LSSEFT_REDSHIFT_NAME, LSSEFT_REDSHIFT_LATEX)
   {
+    this->ids.assign(this->z);
   }
 
 
@@ -65,8 +70,12 @@ const GiNaC::symbol& symbol_factory::make_symbol(std::string name, boost::option
     key_type key = std::make_pair(std::move(name), std::move(latex_name));
     auto r = this->symbols.emplace(std::move(key), std::move(sym));
     
-    // check whether insertion actually occurred
-    if(r.second) return r.first->second;
+    // check whether insertion actually occurred; if so, assign an identifier
+    if(r.second)
+      {
+        this->ids.assign(r.first->second);
+        return r.first->second;
+      }
     
     // otherwise, raise an exception
     throw exception(ERROR_SYMBOL_INSERTION_FAILED, exception_code::symbol_error);
@@ -86,6 +95,7 @@ GiNaC::idx symbol_factory::make_unique_index()
     
     // generate symbol and convert to an index object
     GiNaC::symbol s{name};
+    this->ids.assign(s);
     
     return GiNaC::idx{s, this->index_dimension};
   }
@@ -102,8 +112,11 @@ GiNaC::symbol symbol_factory::make_unique_momentum()
     // generate unique name for this momentum variable
     std::string name = LSSEFT_DEFAULT_MOMENTUM_NAME + std::to_string(this->momentum_count++);
     
-    // generate symbol
-    return GiNaC::symbol{name};
+    // generate symbol and assign an identifier
+    GiNaC::symbol s{name};
+    this->ids.assign(s);
+
+    return s;
   }
 
 
@@ -112,8 +125,11 @@ GiNaC::symbol symbol_factory::make_unique_loop_momentum()
     // generate unique name for this loop momentum
     std::string name = LSSEFT_DEFAULT_LOOP_MOMENTUM_NAME + std::to_string(this->loop_count++);
 
-    // generate symbol
-    return GiNaC::symbol{name};
+    // generate symbol and assign an identifier
+    GiNaC::symbol s{name};
+    this->ids.assign(s);
+
+    return s;
   }
 
 
@@ -122,8 +138,11 @@ GiNaC::symbol symbol_factory::make_unique_Rayleigh_momentum()
     // generate unique name for this Rayleigh momentum
     std::string name = LSSEFT_DEFAULT_RAYLEIGH_MOMENTUM_NAME + std::to_string(this->Rayleigh_count++);
     
-    // generate symbol
-    return GiNaC::symbol{name};
+    // generate symbol and assign an identifier
+    GiNaC::symbol s{name};
+    this->ids.assign(s);
+
+    return s;
   }
 
 
@@ -165,22 +184,152 @@ vector symbol_factory::make_vector(const GiNaC::symbol& s)
 initial_value symbol_factory::make_initial_value(std::string name, boost::optional<std::string> latex_name)
   {
     auto sym = this->make_symbol(std::move(name), std::move(latex_name));
-    auto k = this->make_unique_momentum();
-    
-    return initial_value{k, sym, *this};
+
+    return this->make_initial_value(sym);
   }
 
 
 initial_value symbol_factory::make_initial_value(const GiNaC::symbol& s)
   {
     auto k = this->make_unique_momentum();
-    
+
+    // record momentum, so that it can be matched when restoring kernels from a checkpoint
+    this->initial_momenta.push_back(k);
+
     return initial_value{k, s, *this};
   }
 
+
+initial_value symbol_factory::restore_initial_value(GiNaC::symbol k, GiNaC::symbol s)
+  {
+    return initial_value{std::move(k), std::move(s), *this};
+  }
+
 symbol_factory& symbol_factory::declare_parameter(const GiNaC::symbol& s)
   {
     // TODO: could perhaps perform more checking to ensure that momenta are not declared as parameters ...
     this->parameters.insert(s);
     return *this;
   }
+
+
+symbol_factory& symbol_factory::declare_coefficient(const GiNaC::symbol& s)
+  {
+    this->parameters.insert(s);
+    this->coefficients.insert(s);
+    return *this;
+  }
+
+
+void symbol_factory::archive(checkpoint& ckpt) const
+  {
+    // named symbols, with their LaTeX names if present
+    ckpt.set_string("symbol_factory/symbols", std::to_string(this->symbols.size()));
+
+    unsigned int count = 0;
+    for(const auto& item : this->symbols)
+      {
+        const key_type& key = item.first;
+        const std::string root = "symbol_factory/symbol/" + std::to_string(count++);
+
+        ckpt.set_string(root + "/name", key.first);
+        if(key.second) ckpt.set_string(root + "/latex", *key.second);
+      }
+
+    // parameters and coefficients are stored as newline-separated lists of names
+    auto names = [](const GiNaC_symbol_set& syms) -> std::string
+      {
+        std::string list;
+        for(const auto& sym : order_symbol_set(syms))
+          {
+            if(!list.empty()) list += '\n';
+            list += sym.get_name();
+          }
+        return list;
+      };
+
+    ckpt.set_string("symbol_factory/parameters", names(this->parameters));
+    ckpt.set_string("symbol_factory/coefficients", names(this->coefficients));
+
+    std::ostringstream counters;
+    counters << this->index_count << " " << this->momentum_count << " " << this->loop_count << " " << this->Rayleigh_count;
+    ckpt.set_string("symbol_factory/counters", counters.str());
+  }
+
+
+void symbol_factory::restore(const checkpoint& ckpt)
+  {
+    // recreate named symbols; make_symbol() returns the existing symbol if one is already present
+    const auto num_symbols = std::stoul(ckpt.get_string("symbol_factory/symbols"));
+
+    for(unsigned int i = 0; i < num_symbols; ++i)
+      {
+        const std::string root = "symbol_factory/symbol/" + std::to_string(i);
+
+        boost::optional<std::string> latex_name;
+        if(ckpt.has_string(root + "/latex")) latex_name = ckpt.get_string(root + "/latex");
+
+        this->make_symbol(ckpt.get_string(root + "/name"), latex_name);
+      }
+
+    // redeclare parameters and coefficients
+    auto declare = [&](const std::string& list, bool coefficient) -> void
+      {
+        std::istringstream in{list};
+        std::string name;
+
+        while(std::getline(in, name))
+          {
+            if(name.empty()) continue;
+
+            auto sym = this->find_symbol(name);
+            if(!sym) sym = this->make_symbol(name);
+
+            if(coefficient) this->declare_coefficient(*sym);
+            else            this->declare_parameter(*sym);
+          }
+      };
+
+    declare(ckpt.get_string("symbol_factory/parameters"), false);
+    declare(ckpt.get_string("symbol_factory/coefficients"), true);
+
+    // advance counters past any values used in the checkpoint
+    std::istringstream counters{ckpt.get_string("symbol_factory/counters")};
+    unsigned int index = 0, momentum = 0, loop = 0, Rayleigh = 0;
+    if(!(counters >> index >> momentum >> loop >> Rayleigh))
+      throw exception(ERROR_CHECKPOINT_UNEXPECTED_FORM, exception_code::checkpoint_error);
+
+    this->index_count    = std::max(this->index_count, index);
+    this->momentum_count = std::max(this->momentum_count, momentum);
+    this->loop_count     = std::max(this->loop_count, loop);
+    this->Rayleigh_count = std::max(this->Rayleigh_count, Rayleigh);
+  }
+
+
+GiNaC::lst symbol_factory::get_symbol_table() const
+  {
+    GiNaC::lst table;
+    table.append(this->z);
+
+    for(const auto& item : this->symbols)
+      {
+        table.append(item.second);
+      }
+
+    for(const auto& k : this->initial_momenta)
+      {
+        table.append(k);
+      }
+
+    return table;
+  }
+
+
+boost::optional<GiNaC::symbol> symbol_factory::find_symbol(const std::string& name) const
+  {
+    auto t = std::find_if(this->symbols.begin(), this->symbols.end(),
+                          [&](const symbol_db::value_type& item) -> bool { return item.first.first == name; });
+
+    if(t == this->symbols.end()) return boost::none;
+    return t->second;
+  }
@@ -29,6 +29,7 @@
 
 
 #include <map>
+#include <vector>
 
 #include "boost/optional.hpp"
 
@@ -44,6 +45,9 @@ class vector;
 //! forward-declare initial_value
 class initial_value;
 
+//! forward-declare checkpoint
+class checkpoint;
+
 
 //! symbol factory provides a unified API for building GiNaC symbols
 class symbol_factory
@@ -78,7 +82,8 @@ class symbol_factory
     //! get GiNaC symbol representing redshift z
     const GiNaC::symbol& get_z() const;
 
-    //! manufacture a GiNaC symbol corresponding to a given name
+    //! manufacture a GiNaC symbol corresponding to a given name.
+    //! Every symbol made by the factory is assigned an integer identifier, used to order symbol sets
     const GiNaC::symbol& make_symbol(std::string name, boost::optional<std::string> latex_name = boost::none);
     
     
@@ -98,6 +103,9 @@ class symbol_factory
     //! make an initial value object from an existing symbol
     initial_value make_initial_value(const GiNaC::symbol& s);
 
+    //! make an initial value object carrying a specified momentum; used when restoring kernels from a checkpoint
+    initial_value restore_initial_value(GiNaC::symbol k, GiNaC::symbol s);
+
     
     // SERVICES
     
@@ -137,6 +145,36 @@ class symbol_factory
 
     //! determine whether a symbol is a parameter
     bool is_parameter(const GiNaC::symbol& s) const { return this->parameters.find(s) != this->parameters.end(); }
+
+    //! declare a symbol to be a coefficient; coefficients are parameters that appear polynomially
+    //! as prefactors (eg. halo bias), and are carried separately from momentum kernels
+    symbol_factory& declare_coefficient(const GiNaC::symbol& s);
+
+    //! get coefficient set
+    const GiNaC_symbol_set& get_coefficients() const { return this->coefficients; }
+
+    //! determine whether a symbol is a coefficient
+    bool is_coefficient(const GiNaC::symbol& s) const { return this->coefficients.find(s) != this->coefficients.end(); }
+
+
+    // CHECKPOINTING
+
+  public:
+
+    //! store named symbols, parameters, coefficients and counters in a checkpoint
+    void archive(checkpoint& ckpt) const;
+
+    //! restore state from a checkpoint. Named symbols which do not yet exist are created, and counters
+    //! are advanced so that newly-minted symbols cannot collide with those held in the checkpoint
+    void restore(const checkpoint& ckpt);
+
+    //! get table of symbols to which expressions restored from a checkpoint should be bound
+    GiNaC::lst get_symbol_table() const;
+
+  protected:
+
+    //! find a named symbol, irrespective of its LaTeX name
+    boost::optional<GiNaC::symbol> find_symbol(const std::string& name) const;
     
     
     // INTERNAL DATA
@@ -145,12 +183,21 @@ class symbol_factory
 
     // DATABASES
 
+    //! symbol identifier table; declared first, so that it outlives the symbol sets below
+    symbol_id_table ids;
+
     //! symbol database
     symbol_db symbols;
 
     //! parameter database; symbols declared as parameters can be included in momentum kernels
     GiNaC_symbol_set parameters;
 
+    //! coefficient database; a subset of the parameters
+    GiNaC_symbol_set coefficients;
+
+    //! momenta carried by initial values made by this factory
+    std::vector<GiNaC::symbol> initial_momenta;
+
 
     // INTERNAL STATE
     
@@ -60,6 +60,10 @@ constexpr auto LSSEFT_REDSHIFT_LATEX = "z";
 constexpr auto LSSEFT_DEFAULT_KERNEL_ROOT = "ker";
 
 
+//! minimum number of work items before progress is reported for a parallel stage
+constexpr unsigned int LSSEFT_PROGRESS_REPORT_THRESHOLD = 50;
+
+
 //! enable reduction of Fabrikant integrals
 #define REDUCE_FABRIKANT_INTEGRALS
 
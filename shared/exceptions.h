@@ -44,7 +44,9 @@ enum class exception_code
     loop_integral_error,
     loop_transformation_error,
     Fabrikant_error,
-    backend_error
+    backend_error,
+    checkpoint_error,
+    process_error
   };
 
 
@@ -24,9 +24,13 @@
 // --@@
 //
 
+#include <algorithm>
+#include <sstream>
+
 #include "GiNaC_utils.h"
 
 #include "services/service_locator.h"
+#include "instruments/profiler.h"
 
 #include "shared/exceptions.h"
 #include "localizations/messages.h"
@@ -405,6 +409,8 @@ GiNaC::ex simplify_index_impl(const GiNaC::ex& expr, const GiNaC::scalar_product
 GiNaC::ex simplify_index(const GiNaC::ex& expr, const GiNaC::scalar_products& sp, const GiNaC::exmap& Rayleigh_list,
                          service_locator& loc)
   {
+    PROFILE_SCOPE("simplify_index");
+
     // filter out any zero elements from Rayleigh list
     GiNaC::exmap new_Rayleigh_list;
     for(const auto& rule : Rayleigh_list)
@@ -531,14 +537,137 @@ GiNaC::exvector to_exvector(const GiNaC::ex& expr)
   }
 
 
-std::vector<GiNaC::symbol> order_symbol_set(const GiNaC_symbol_set& syms)
+size_t expression_nodes(const GiNaC::ex& expr)
+  {
+    size_t count = 1;
+
+    for(size_t i = 0; i < expr.nops(); ++i)
+      {
+        count += expression_nodes(expr.op(i));
+      }
+
+    return count;
+  }
+
+
+size_t expression_depth(const GiNaC::ex& expr)
+  {
+    size_t depth = 0;
+
+    for(size_t i = 0; i < expr.nops(); ++i)
+      {
+        depth = std::max(depth, expression_depth(expr.op(i)));
+      }
+
+    return depth + 1;
+  }
+
+
+std::string canonical_print(const GiNaC::ex& expr)
+  {
+    if(GiNaC::is_a<GiNaC::add>(expr) || GiNaC::is_a<GiNaC::mul>(expr))
+      {
+        std::vector<std::string> ops;
+        for(const auto& arg : expr)
+          {
+            ops.push_back(canonical_print(arg));
+          }
+        std::sort(ops.begin(), ops.end());
+
+        std::string rval{"("};
+        for(size_t i = 0; i < ops.size(); ++i)
+          {
+            if(i > 0) rval.append(GiNaC::is_a<GiNaC::add>(expr) ? "+" : "*");
+            rval.append(ops[i]);
+          }
+        rval.append(")");
+
+        return rval;
+      }
+
+    if(GiNaC::is_a<GiNaC::power>(expr))
+      {
+        return "(" + canonical_print(expr.op(0)) + ")^(" + canonical_print(expr.op(1)) + ")";
+      }
+
+    if(GiNaC::is_a<GiNaC::function>(expr))
+      {
+        std::string rval = GiNaC::ex_to<GiNaC::function>(expr).get_name() + "(";
+
+        unsigned int c = 0;
+        for(const auto& arg : expr)
+          {
+            if(c++ > 0) rval.append(",");
+            rval.append(canonical_print(arg));
+          }
+        rval.append(")");
+
+        return rval;
+      }
+
+    std::ostringstream str;
+    str << expr;
+
+    return str.str();
+  }
+
+
+GiNaC::ex canonical_numeric_factor(const GiNaC::ex& expr)
   {
-    std::vector<GiNaC::symbol> ordered_set;
+    GiNaC::ex factor{1};
+    std::string lead;
+    bool first = true;
 
-    for(const auto& sym : syms)
+    auto visit = [&](const GiNaC::ex& term) -> void
       {
-        ordered_set.push_back(sym);
+        GiNaC::ex c{1};
+        GiNaC::ex rest{1};
+
+        if(GiNaC::is_exactly_a<GiNaC::mul>(term))
+          {
+            for(const auto& f : term)
+              {
+                if(GiNaC::is_a<GiNaC::numeric>(f)) c *= f;
+                else                               rest *= f;
+              }
+          }
+        else if(GiNaC::is_a<GiNaC::numeric>(term))
+          {
+            c = term;
+          }
+        else
+          {
+            rest = term;
+          }
+
+        auto str = canonical_print(rest);
+        if(first || str < lead)
+          {
+            lead = std::move(str);
+            factor = c;
+            first = false;
+          }
+      };
+
+    if(GiNaC::is_exactly_a<GiNaC::add>(expr))
+      {
+        for(const auto& term : expr)
+          {
+            visit(term);
+          }
       }
+    else
+      {
+        visit(expr);
+      }
+
+    return factor;
+  }
+
+
+std::vector<GiNaC::symbol> order_symbol_set(const GiNaC_symbol_set& syms)
+  {
+    std::vector<GiNaC::symbol> ordered_set{syms.begin(), syms.end()};
 
     std::sort(ordered_set.begin(), ordered_set.end(), std::less<GiNaC::symbol>{});
 
@@ -29,6 +29,10 @@
 
 
 #include <set>
+#include <string>
+#include <vector>
+
+#include "utilities/symbol_set.h"
 
 #include "ginac/ginac.h"
 
@@ -54,9 +58,9 @@ namespace std
 class service_locator;
 
 
-//! set of GiNaC symbols, with comparison performed lexicographically by name
+//! set of GiNaC symbols, ordered by integer symbol identifier
 //! (GiNaC does not provide this option itself)
-using GiNaC_symbol_set = std::set< GiNaC::symbol, std::less<GiNaC::symbol> >;
+using GiNaC_symbol_set = symbol_set;
 
 
 //! extract a set of GiNaC symbols from a given expression
@@ -82,7 +86,23 @@ bool is_rational(const GiNaC::ex& expr);
 //! convert a product to an expression vector
 GiNaC::exvector to_exvector(const GiNaC::ex& expr);
 
-//! order a set of symbols
+//! order a set of symbols lexically by name; used wherever output order matters,
+//! because the order of a symbol set depends on the order in which its symbols were created
 std::vector<GiNaC::symbol> order_symbol_set(const GiNaC_symbol_set& syms);
 
+//! count the nodes in the expression tree of a GiNaC expression
+size_t expression_nodes(const GiNaC::ex& expr);
+
+//! compute the depth of the expression tree of a GiNaC expression; an atom has depth 1
+size_t expression_depth(const GiNaC::ex& expr);
+
+//! print an expression with the operands of sums and products in lexical order, so that the
+//! result does not depend on GiNaC's hash-based ordering (which can vary between runs)
+std::string canonical_print(const GiNaC::ex& expr);
+
+//! get the numerical factor of the term in an expanded expression whose non-numerical part sorts first
+//! under canonical_print. Dividing by this factor gives a normal form which is shared by expressions
+//! differing only by a numerical factor, and does not depend on GiNaC's ordering of terms
+GiNaC::ex canonical_numeric_factor(const GiNaC::ex& expr);
+
 #endif //LSSEFT_ANALYTIC_GINAC_UTILS_H
@@ -0,0 +1,76 @@
+//
+// Created by David Seery on 10/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#ifndef LSSEFT_ANALYTIC_JSON_ESCAPE_H
+#define LSSEFT_ANALYTIC_JSON_ESCAPE_H
+
+
+#include <string>
+#include <cstdio>
+
+
+//! escape a string for inclusion in a JSON string literal.
+//! Quotes and backslashes are escaped, common control characters use their short forms,
+//! and remaining control characters are written as \uXXXX
+inline std::string json_escape(const std::string& str)
+  {
+    std::string rval;
+    rval.reserve(str.size());
+
+    for(char c : str)
+      {
+        switch(c)
+          {
+            case '"':  rval += "\\\""; break;
+            case '\\': rval += "\\\\"; break;
+            case '\b': rval += "\\b"; break;
+            case '\f': rval += "\\f"; break;
+            case '\n': rval += "\\n"; break;
+            case '\r': rval += "\\r"; break;
+            case '\t': rval += "\\t"; break;
+
+            default:
+              {
+                if(static_cast<unsigned char>(c) < 0x20)
+                  {
+                    char buf[8];
+                    std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned int>(static_cast<unsigned char>(c)));
+                    rval += buf;
+                  }
+                else
+                  {
+                    rval.push_back(c);
+                  }
+              }
+          }
+      }
+
+    return rval;
+  }
+
+
+#endif //LSSEFT_ANALYTIC_JSON_ESCAPE_H
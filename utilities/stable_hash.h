@@ -0,0 +1,77 @@
+//
+// Created by David Seery on 10/11/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+#ifndef LSSEFT_ANALYTIC_STABLE_HASH_H
+#define LSSEFT_ANALYTIC_STABLE_HASH_H
+
+
+#include <string>
+#include <sstream>
+#include <iomanip>
+#include <cstdint>
+
+
+namespace hash_impl
+  {
+
+    //! offset basis for 64-bit FNV-1a
+    constexpr uint64_t fnv1a_basis = 14695981039346656037ULL;
+
+    //! 64-bit FNV-1a hash of a block of data; the hash of a longer block can be accumulated by
+    //! passing the result of earlier calls as the seed.
+    //! Unlike std::hash, this is guaranteed to be the same on every platform and in every run
+    inline uint64_t fnv1a(const char* data, size_t n, uint64_t h = fnv1a_basis)
+      {
+        for(size_t i = 0; i < n; ++i)
+          {
+            h ^= static_cast<unsigned char>(data[i]);
+            h *= 1099511628211ULL;
+          }
+
+        return h;
+      }
+
+
+    //! format a 64-bit hash as a fixed-width hexadecimal string
+    inline std::string to_hex(uint64_t h)
+      {
+        std::ostringstream out;
+        out << std::hex << std::setw(16) << std::setfill('0') << h;
+
+        return out.str();
+      }
+
+
+    //! compute stable hash of a string, formatted as a fixed-width hexadecimal string
+    inline std::string stable_hash(const std::string& str)
+      {
+        return to_hex(fnv1a(str.data(), str.size()));
+      }
+
+  }   // namespace hash_impl
+
+
+#endif //LSSEFT_ANALYTIC_STABLE_HASH_H
@@ -0,0 +1,127 @@
+//
+// Created by David Seery on 19/10/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#include <string>
+#include <functional>
+
+#include "symbol_set.h"
+
+#include "utilities/hash_combine.h"
+
+#include "shared/exceptions.h"
+#include "localizations/messages.h"
+
+
+symbol_id_table* symbol_id_table::bound = nullptr;
+
+
+symbol_id_table::symbol_id_table()
+  {
+    bound = this;
+  }
+
+
+symbol_id_table::~symbol_id_table()
+  {
+    if(bound == this) bound = nullptr;
+  }
+
+
+symbol_id symbol_id_table::assign(const GiNaC::symbol& s)
+  {
+    // identifiers are dense, so the next one to assign is the current size of the table
+    auto r = this->ids.emplace(s.get_name(), static_cast<symbol_id>(this->ids.size()));
+    return r.first->second;
+  }
+
+
+symbol_id symbol_id_table::lookup(const GiNaC::symbol& s)
+  {
+    if(bound == nullptr) throw exception(ERROR_SYMBOL_ID_TABLE_NOT_BOUND, exception_code::symbol_error);
+
+    return bound->assign(s);
+  }
+
+
+std::pair<symbol_set::iterator, bool> symbol_set::insert(const GiNaC::symbol& s)
+  {
+    auto id = symbol_id_table::lookup(s);
+
+    auto t = std::lower_bound(this->ids.begin(), this->ids.end(), id);
+    auto pos = t - this->ids.begin();
+
+    // if this symbol is already present, there is nothing to do
+    if(t != this->ids.end() && *t == id) return std::make_pair(this->syms.cbegin() + pos, false);
+
+    this->ids.insert(t, id);
+    auto u = this->syms.insert(this->syms.cbegin() + pos, s);
+
+    return std::make_pair(iterator{u}, true);
+  }
+
+
+symbol_set::const_iterator symbol_set::find(const GiNaC::symbol& s) const
+  {
+    const auto id = symbol_id_table::lookup(s);
+
+    auto t = std::lower_bound(this->ids.cbegin(), this->ids.cend(), id);
+    if(t == this->ids.cend() || *t != id) return this->syms.cend();
+
+    return this->syms.cbegin() + (t - this->ids.cbegin());
+  }
+
+
+symbol_set::iterator symbol_set::erase(const_iterator t)
+  {
+    auto pos = t - this->syms.cbegin();
+
+    this->ids.erase(this->ids.cbegin() + pos);
+    return this->syms.erase(t);
+  }
+
+
+symbol_set::size_type symbol_set::erase(const GiNaC::symbol& s)
+  {
+    auto t = this->find(s);
+    if(t == this->end()) return 0;
+
+    this->erase(t);
+    return 1;
+  }
+
+
+size_t symbol_set::hash() const
+  {
+    size_t h = 0;
+
+    for(const auto& id : this->ids)
+      {
+        hash_impl::hash_combine(h, id);
+      }
+
+    return h;
+  }
@@ -0,0 +1,247 @@
+//
+// Created by David Seery on 19/10/2017.
+// --@@
+// Copyright (c) 2017 University of Sussex. All rights reserved.
+//
+// This file is part of the Sussex Effective Field Theory for
+// Large-Scale Structure analytic calculation platform (LSSEFT-analytic).
+//
+// LSSEFT-analytic is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// LSSEFT-analytic is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with LSSEFT-analytic.  If not, see <http://www.gnu.org/licenses/>.
+//
+// @license: GPL-2
+// @contributor: David Seery <D.Seery@sussex.ac.uk>
+// --@@
+//
+
+
+#ifndef LSSEFT_ANALYTIC_SYMBOL_SET_H
+#define LSSEFT_ANALYTIC_SYMBOL_SET_H
+
+
+#include <algorithm>
+#include <string>
+#include <initializer_list>
+#include <functional>
+#include <unordered_map>
+
+#include "boost/container/small_vector.hpp"
+
+#include "ginac/ginac.h"
+
+
+//! type for integer symbol identifiers
+using symbol_id = unsigned int;
+
+
+//! symbol_id_table assigns dense integer identifiers to symbol names.
+//! A table is owned by symbol_factory, which assigns identifiers as it makes symbols, and binds itself
+//! as the table consulted by symbol_set for as long as it exists. Symbols which were not made by the
+//! factory (eg. those restored from a checkpoint) are assigned an identifier the first time they are seen.
+//! Identifiers depend on creation order, so they should not be used where output order matters.
+//! The table is not thread-safe; it is only ever used from a single thread
+class symbol_id_table
+  {
+
+    // CONSTRUCTOR, DESTRUCTOR
+
+  public:
+
+    //! constructor binds this table
+    symbol_id_table();
+
+    //! destructor unbinds this table
+    ~symbol_id_table();
+
+    //! tables are bound by address, so they cannot be copied
+    symbol_id_table(const symbol_id_table& obj) = delete;
+    symbol_id_table& operator=(const symbol_id_table& obj) = delete;
+
+
+    // INTERFACE
+
+  public:
+
+    //! get the identifier for a symbol, assigning a new one if its name has not been seen before
+    symbol_id assign(const GiNaC::symbol& s);
+
+    //! get the identifier for a symbol from the bound table
+    static symbol_id lookup(const GiNaC::symbol& s);
+
+
+    // INTERNAL DATA
+
+  private:
+
+    //! map from symbol names to identifiers
+    std::unordered_map< std::string, symbol_id > ids;
+
+    //! currently bound table
+    static symbol_id_table* bound;
+
+  };
+
+
+//! symbol_set is a flat set of GiNaC symbols, ordered by integer symbol identifier.
+//! Distinct GiNaC symbols sharing the same name have the same identifier, and compare equal.
+//! Most sets we handle contain only a handful of momenta, so storage is a small-vector
+//! that avoids heap allocation in the common case. The identifier of each symbol is cached when it
+//! is inserted, so ordering, comparison and hashing work on integers rather than names.
+//! Identifiers follow creation order, so where output order matters use order_symbol_set()
+//! to obtain the symbols in lexical order.
+//! The interface mimics the parts of std::set<> that we use
+class symbol_set
+  {
+
+    // TYPES
+
+  protected:
+
+    //! inline capacity before falling back to heap allocation
+    static constexpr unsigned int inline_capacity = 6;
+
+    //! container for symbols
+    using symbol_db = boost::container::small_vector< GiNaC::symbol, inline_capacity >;
+
+    //! container for identifiers
+    using id_db = boost::container::small_vector< symbol_id, inline_capacity >;
+
+  public:
+
+    //! value type
+    using value_type = GiNaC::symbol;
+
+    //! const iterator; elements of a set are immutable so we provide no mutable iterator
+    using const_iterator = symbol_db::const_iterator;
+    using iterator = const_iterator;
+
+    //! const reverse iterator
+    using const_reverse_iterator = symbol_db::const_reverse_iterator;
+    using reverse_iterator = const_reverse_iterator;
+
+    //! size type
+    using size_type = size_t;
+
+
+    // CONSTRUCTOR, DESTRUCTOR
+
+  public:
+
+    //! empty constructor
+    symbol_set() = default;
+
+    //! initializer-list constructor
+    symbol_set(std::initializer_list<GiNaC::symbol> syms)
+      {
+        for(const auto& s : syms)
+          {
+            this->insert(s);
+          }
+      }
+
+    //! destructor is default
+    ~symbol_set() = default;
+
+
+    // ITERATORS
+
+  public:
+
+    const_iterator begin() const                    { return this->syms.cbegin(); }
+    const_iterator end() const                      { return this->syms.cend(); }
+    const_iterator cbegin() const                   { return this->syms.cbegin(); }
+    const_iterator cend() const                     { return this->syms.cend(); }
+
+    const_reverse_iterator rbegin() const           { return this->syms.crbegin(); }
+    const_reverse_iterator rend() const             { return this->syms.crend(); }
+    const_reverse_iterator crbegin() const          { return this->syms.crbegin(); }
+    const_reverse_iterator crend() const            { return this->syms.crend(); }
+
+
+    // INTERFACE
+
+  public:
+
+    //! get size
+    size_type size() const { return this->syms.size(); }
+
+    //! query for empty
+    bool empty() const { return this->syms.empty(); }
+
+    //! insert a symbol; returns iterator to the element and a flag indicating whether insertion took place
+    std::pair<iterator, bool> insert(const GiNaC::symbol& s);
+
+    //! insert with a hint; the hint is ignored, but this overload allows use of std::inserter()
+    iterator insert(const_iterator hint, const GiNaC::symbol& s) { return this->insert(s).first; }
+
+    //! find a symbol
+    const_iterator find(const GiNaC::symbol& s) const;
+
+    //! count occurrences of a symbol (either zero or one)
+    size_type count(const GiNaC::symbol& s) const { return this->find(s) != this->end() ? 1 : 0; }
+
+    //! erase element by iterator, returning iterator to the following element
+    iterator erase(const_iterator t);
+
+    //! erase element by value, returning number of elements erased
+    size_type erase(const GiNaC::symbol& s);
+
+    //! clear set
+    void clear() { this->syms.clear(); this->ids.clear(); }
+
+
+    // SERVICES
+
+  public:
+
+    //! hash on identifiers
+    size_t hash() const;
+
+    //! test for equality using identifiers
+    bool operator==(const symbol_set& obj) const
+      { return std::equal(this->ids.cbegin(), this->ids.cend(), obj.ids.cbegin(), obj.ids.cend()); }
+
+    //! test for inequality
+    bool operator!=(const symbol_set& obj) const { return !(*this == obj); }
+
+
+    // INTERNAL DATA
+
+  private:
+
+    //! symbols, ordered by identifier
+    symbol_db syms;
+
+    //! identifiers, maintained in parallel with symbols
+    id_db ids;
+
+  };
+
+
+// specialize std::hash to work for symbol_set
+namespace std
+  {
+
+    template <>
+    struct hash<symbol_set>
+      {
+        size_t operator()(const symbol_set& obj) const
+          {
+            return obj.hash();
+          }
+      };
+
+  }   // namespace std
+
+
+#endif //LSSEFT_ANALYTIC_SYMBOL_SET_H